@@ -2,18 +2,177 @@
 #define SENSOR_INTERFACE_H
 #include <ArduinoSTL.h>
 #include <map>
+#include "utility/logger.util.h"
+
+// Per-sensor sampling schedule. The base interval is configured (MQTT,
+// EEPROM), adaptive mode moves the effective interval between a quarter
+// and four times the base depending on how fast the readings change, never
+// below the hardware floor.
+struct SensorSampling
+{
+    unsigned long intervalMs;
+    unsigned long minIntervalMs;
+    unsigned long currentMs;
+    unsigned long lastSampleAt;
+    bool adaptive;
+    bool sampled;
+    // Time budget: expected read time (declared, then tracked), the
+    // priority among sensors due in the same pass and the passes this
+    // sensor has been deferred in a row (ages its priority)
+    uint32_t costUs;
+    uint8_t priority;
+    uint8_t deferred;
+    // Reads split across passes: the sensor asks to be called again at
+    // resumeAt and reports nothing until its last step
+    bool pending;
+    unsigned long resumeAt;
+
+    void configure(unsigned long interval, bool adaptiveMode)
+    {
+        intervalMs = interval < minIntervalMs ? minIntervalMs : interval;
+        currentMs = intervalMs;
+        adaptive = adaptiveMode;
+    }
+
+    bool isDue(unsigned long now) const
+    {
+        if (pending)
+        {
+            return (long)(now - resumeAt) >= 0;
+        }
+        return !sampled || now - lastSampleAt >= currentMs;
+    }
+
+    void resumeAfter(unsigned long now, unsigned long delayMs)
+    {
+        pending = true;
+        resumeAt = now + delayMs;
+    }
+
+    void markSampled(unsigned long now)
+    {
+        lastSampleAt = now;
+        sampled = true;
+    }
+
+    // Moving average of the measured read time
+    void recordCost(uint32_t elapsedUs)
+    {
+        costUs = costUs - costUs / 4 + elapsedUs / 4;
+    }
+
+    // Halve the interval while changing, back off by 25% while stable
+    void adapt(bool changing)
+    {
+        unsigned long fastest = intervalMs / 4 < minIntervalMs ? minIntervalMs : intervalMs / 4;
+        unsigned long slowest = intervalMs * 4;
+        unsigned long next = changing ? currentMs / 2 : currentMs + currentMs / 4;
+        currentMs = next < fastest ? fastest : (next > slowest ? slowest : next);
+    }
+};
+
+// Per-sensor health and circuit breaker. Consecutive failures (no data or
+// implausible values) open the breaker: the sensor is skipped until the
+// backoff expires, then gets a single trial read. The backoff starts at
+// twice the sampling interval, doubles up to maxBackoffMs and resets on the
+// first good sample.
+struct SensorHealth
+{
+    enum State : uint8_t
+    {
+        Healthy,
+        Degraded, // Failing below the threshold, or stuck on one value
+        Open      // Breaker open, reads suspended
+    };
+
+    static const uint8_t failureThreshold = 3;
+    static const unsigned long maxBackoffMs = 300000UL;
+
+    State state;
+    uint8_t consecutiveFailures;
+    uint16_t totalFailures;
+    uint8_t stuckLimit; // Identical samples in a row that count as stuck, 0 = off
+    uint8_t stuckCount;
+    double lastSignature;
+    unsigned long lastGoodAt;
+    unsigned long retryAt;
+    unsigned long backoffMs;
+    const char *reason; // Last failure: "no data", "range", "stuck"
+
+    bool allowRead(unsigned long now) const
+    {
+        return state != Open || (long)(now - retryAt) >= 0;
+    }
+
+    bool isStuck() const
+    {
+        return stuckLimit && stuckCount >= stuckLimit;
+    }
+
+    // signature: any value derived from the whole sample, used for stuck detection
+    void recordSuccess(unsigned long now, double signature)
+    {
+        if (lastGoodAt == 0 || signature != lastSignature)
+        {
+            stuckCount = 0;
+        }
+        else if (stuckCount < 255)
+        {
+            stuckCount++;
+        }
+        lastSignature = signature;
+        lastGoodAt = now;
+        consecutiveFailures = 0;
+        backoffMs = 0;
+        if (isStuck())
+        {
+            reason = "stuck";
+        }
+        state = isStuck() ? Degraded : Healthy;
+    }
+
+    void recordFailure(unsigned long now, unsigned long intervalMs, const char *why)
+    {
+        reason = why;
+        totalFailures++;
+        if (consecutiveFailures < 255)
+        {
+            consecutiveFailures++;
+        }
+        if (consecutiveFailures < failureThreshold)
+        {
+            state = Degraded;
+            return;
+        }
+        backoffMs = backoffMs == 0 ? intervalMs * 2 : backoffMs * 2;
+        if (backoffMs > maxBackoffMs)
+        {
+            backoffMs = maxBackoffMs;
+        }
+        retryAt = now + backoffMs;
+        state = Open;
+    }
+
+    static const char *stateName(State state)
+    {
+        return state == Healthy ? "ok" : (state == Degraded ? "degraded" : "open");
+    }
+};
+
+// CRTP base for sensors. Sensors are composed at compile time (see
+// sensors/sensors.config.h) and always called through their concrete type,
+// so there is no vtable. Derived must provide:
+//   void initialize();
+//   std::map<std::string, double> readData();
+//   const char *getType();
+//   const char *getSensorName();
+template <typename Derived>
 class AbstractSensor
 {
 public:
-    virtual ~AbstractSensor() = default;
-    virtual void initialize() = 0;
-    virtual std::map<std::string, double> readData() = 0;
-    virtual const char *getType() = 0;
-    virtual const char *getSensorName() = 0;
-
-    virtual void calibrate()
+    void calibrate()
     {
-        log("Default calibration executed.");
+        LOG_INFO("sensor", "%s: default calibration executed", derived().getSensorName());
     }
 
     unsigned long getTimeElapsedSinceLastRead() const
@@ -36,23 +195,62 @@ public:
         uniqueID = id;
     }
 
-    std::string getUniqueID() const
+    const std::string &getUniqueID() const
     {
         return uniqueID;
     }
 
+    SensorSampling &getSampling()
+    {
+        return sampling;
+    }
+
+    SensorHealth &getHealth()
+    {
+        return health;
+    }
+
+    const std::string &getStatusMessage() const
+    {
+        return statusMessage;
+    }
+
+    // Range check per channel, sensors shadow this with their physical limits
+    bool isPlausible(const std::string &, double) const
+    {
+        return true;
+    }
+
+    // Called on passes where the sensor is not due. Sensors with channels
+    // derived from another sensor (temperature compensation) republish them
+    // here when that input changed, without sampling their own hardware.
+    void refreshDerived(std::map<std::string, double> &)
+    {
+    }
+
     std::map<std::string, double> readDataWithMetrics()
     {
         resetReadTime();
-        auto data = readData();
+        auto data = derived().readData();
         incrementReadCount();
         updateReadTime();
-        log(("Time elapsed since last read: " + String(timeElapsedSinceLastRead) + " ms").c_str());
+        LOG_DEBUG("sensor", "%s: %lu ms since last read", derived().getSensorName(), timeElapsedSinceLastRead);
 
         return data;
     }
 
 protected:
+    // Default sampling interval, the fastest rate the hardware tolerates,
+    // the expected cost of one readData() call (one step of a split read)
+    // and its priority (higher first)
+    AbstractSensor(unsigned long intervalMs, unsigned long minIntervalMs, uint32_t costUs, uint8_t priority)
+        : sampling{intervalMs, minIntervalMs, intervalMs, 0, false, false, costUs, priority, 0, false, 0},
+          health{SensorHealth::Healthy, 0, 0, 0, 0, 0, 0, 0, 0, ""} {}
+    ~AbstractSensor() = default;
+
+    SensorSampling sampling;
+    SensorHealth health;
+
     unsigned long lastReadTime = 0;
     unsigned long timeElapsedSinceLastRead = 0;
     unsigned long readCount = 0;
@@ -60,6 +258,11 @@ protected:
     std::string statusMessage = "OK";
     std::string uniqueID;
 
+    Derived &derived()
+    {
+        return static_cast<Derived &>(*this);
+    }
+
     void resetReadTime()
     {
         lastReadTime = millis();
@@ -81,14 +284,9 @@ protected:
         readCount++;
     }
 
-    void log(const std::string &message)
-    {
-        Serial.println(("[" + std::string(getSensorName()) + "] " + message).c_str());
-    }
-
     void setStatus(const std::string &status)
     {
         statusMessage = status;
     }
 };
-#endif // SENSOR_INTERFACE_H
\ No newline at end of file
+#endif // SENSOR_INTERFACE_H
@@ -0,0 +1,107 @@
+# Embeds the portal pages (src/services/webserver/assets) into flash.
+#
+# Writes src/services/webserver/webAssets.h with a plain and a gzip copy of
+# every asset as PROGMEM arrays plus a lookup table. The output is
+# deterministic (gzip mtime 0) and only rewritten when it changes, so it can
+# run before every build:
+#
+#   extra_scripts = pre:apps/iot/io-manager/scripts/embed_assets.py
+#
+# or by hand: python3 apps/iot/io-manager/scripts/embed_assets.py
+
+import gzip
+import os
+import re
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+}
+
+
+def project_dir():
+    try:
+        here = os.path.dirname(os.path.abspath(__file__))
+    except NameError:  # exec'd by PlatformIO's SCons
+        Import("env")  # noqa: F821
+        here = os.path.join(env.subst("$PROJECT_DIR"), "apps", "iot", "io-manager", "scripts")  # noqa: F821
+    return os.path.dirname(here)
+
+
+def c_identifier(name):
+    return "ASSET_" + re.sub(r"[^A-Za-z0-9]", "_", name).upper()
+
+
+def byte_lines(data, per_line=16):
+    for start in range(0, len(data), per_line):
+        yield "    " + ", ".join("0x%02x" % b for b in data[start:start + per_line]) + ","
+
+
+def render(assets_dir):
+    lines = [
+        "// Generated by scripts/embed_assets.py from src/services/webserver/assets, do not edit",
+        "#ifndef WEB_ASSETS_H",
+        "#define WEB_ASSETS_H",
+        "",
+        "#include <Arduino.h>",
+        "",
+        "struct WebAsset",
+        "{",
+        "    PGM_P path;",
+        "    PGM_P contentType;",
+        "    const uint8_t *plain;",
+        "    uint16_t plainLength;",
+        "    const uint8_t *gzip;",
+        "    uint16_t gzipLength;",
+        "};",
+        "",
+    ]
+    table = []
+    for name in sorted(os.listdir(assets_dir)):
+        path = os.path.join(assets_dir, name)
+        extension = os.path.splitext(name)[1]
+        if not os.path.isfile(path) or extension not in CONTENT_TYPES:
+            continue
+        with open(path, "rb") as source:
+            plain = source.read()
+        packed = gzip.compress(plain, compresslevel=9, mtime=0)
+        ident = c_identifier(name)
+        url = "/" if name == "index.html" else "/" + name
+        lines.append('static const char %s_PATH[] PROGMEM = "%s";' % (ident, url))
+        lines.append('static const char %s_TYPE[] PROGMEM = "%s";' % (ident, CONTENT_TYPES[extension]))
+        lines.append("static const uint8_t %s[] PROGMEM = {" % ident)
+        lines.extend(byte_lines(plain))
+        lines.append("};")
+        lines.append("static const uint8_t %s_GZ[] PROGMEM = {" % ident)
+        lines.extend(byte_lines(packed))
+        lines.append("};")
+        lines.append("")
+        table.append("    {%s_PATH, %s_TYPE, %s, %d, %s_GZ, %d}," % (ident, ident, ident, len(plain), ident, len(packed)))
+
+    lines.append("static const WebAsset WEB_ASSETS[] PROGMEM = {")
+    lines.extend(table)
+    lines.append("};")
+    lines.append("static const uint8_t WEB_ASSET_COUNT = %d;" % len(table))
+    lines.append("")
+    lines.append("#endif // WEB_ASSETS_H")
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    root = project_dir()
+    output = os.path.join(root, "src", "services", "webserver", "webAssets.h")
+    text = render(os.path.join(root, "src", "services", "webserver", "assets"))
+    current = None
+    if os.path.exists(output):
+        with open(output) as existing:
+            current = existing.read()
+    if text != current:
+        with open(output, "w") as target:
+            target.write(text)
+        print("embed_assets: wrote %s" % os.path.relpath(output, root))
+
+
+main()
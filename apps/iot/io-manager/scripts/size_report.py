@@ -0,0 +1,85 @@
+# Post-build SRAM report for the AVR firmware.
+#
+# Prints .data/.bss (static SRAM) against the 8 KB of the Mega, how much
+# text is served from flash (.progmem: F() literals, PROGMEM tables and
+# assets) and, when a baseline was recorded, the SRAM reclaimed since then:
+#
+#   extra_scripts = post:apps/iot/io-manager/scripts/size_report.py
+#
+# Record the current build as the baseline with
+#   SRAM_BASELINE=save pio run -e megaatmega2560
+# (written to scripts/sram-baseline.txt, commit it to share it).
+
+import os
+import subprocess
+
+Import("env")  # noqa: F821
+
+SRAM_BYTES = 8192
+# Heap (JSON documents, Strings, the sensor maps) and stack share what
+# .data/.bss leave; below this the build is flagged. Check the measured
+# iomanager_sram_headroom_bytes on the device as well.
+SRAM_FREE_MIN = 2048
+
+
+def section_sizes(size_tool, elf):
+    output = subprocess.check_output([size_tool, "-A", elf]).decode()
+    sizes = {}
+    for line in output.splitlines():
+        parts = line.split()
+        if len(parts) >= 2 and parts[0].startswith(".") and parts[1].isdigit():
+            sizes[parts[0]] = int(parts[1])
+    return sizes
+
+
+def progmem_bytes(nm_tool, elf):
+    # F()/PSTR literals are named __c.NNN, PROGMEM arrays keep their names;
+    # everything placed in .progmem.* is reported together
+    output = subprocess.check_output([nm_tool, "-S", "--size-sort", "-t", "d", elf]).decode()
+    literals = 0
+    tables = 0
+    for line in output.splitlines():
+        parts = line.split()
+        if len(parts) < 4 or parts[2] not in "tTrR":
+            continue
+        size = int(parts[1])
+        if parts[3].startswith("__c."):
+            literals += size
+        elif parts[3].startswith(("ASSET_", "WEB_ASSETS", "STATUS_", "TYPE_")) or parts[3].endswith("_PAGE"):
+            tables += size
+    return literals, tables
+
+
+def report(source, target, env):
+    elf = str(target[0]) if target else env.subst("$BUILD_DIR/${PROGNAME}.elf")
+    if not elf.endswith(".elf"):
+        elf = env.subst("$BUILD_DIR/${PROGNAME}.elf")
+    size_tool = env.subst("$SIZETOOL") or "avr-size"
+    nm_tool = size_tool.replace("size", "nm")
+
+    sizes = section_sizes(size_tool, elf)
+    static_sram = sizes.get(".data", 0) + sizes.get(".bss", 0) + sizes.get(".noinit", 0)
+    literals, tables = progmem_bytes(nm_tool, elf)
+
+    print("")
+    print("SRAM report")
+    print("  .data %6d  .bss %6d  static %6d of %d (%.1f%%), %d left for heap and stack" % (
+        sizes.get(".data", 0), sizes.get(".bss", 0), static_sram, SRAM_BYTES,
+        100.0 * static_sram / SRAM_BYTES, SRAM_BYTES - static_sram))
+    if SRAM_BYTES - static_sram < SRAM_FREE_MIN:
+        print("  WARNING: less than %d bytes left for heap and stack, shrink MQTT_QOS1_WINDOW or HTTP_SNAPSHOT_SIZE" % SRAM_FREE_MIN)
+    print("  flash strings: %d bytes of F()/PSTR literals, %d bytes of PROGMEM tables and assets" % (literals, tables))
+
+    baseline_file = os.path.join(env.subst("$PROJECT_DIR"), "apps", "iot", "io-manager", "scripts", "sram-baseline.txt")
+    if os.environ.get("SRAM_BASELINE") == "save":
+        with open(baseline_file, "w") as out:
+            out.write("%d\n" % static_sram)
+        print("  baseline saved (%d bytes)" % static_sram)
+    elif os.path.exists(baseline_file):
+        with open(baseline_file) as baseline:
+            before = int(baseline.read().split()[0])
+        print("  baseline %d bytes, reclaimed %d bytes" % (before, before - static_sram))
+    print("")
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", report)  # noqa: F821
@@ -0,0 +1,264 @@
+#ifndef AT_LINK_H
+#define AT_LINK_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Command text stays in flash on the board; on the host these are plain RAM
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#else
+#ifndef PSTR
+#define PSTR(s) (s)
+#endif
+#ifndef PGM_P
+#define PGM_P const char *
+#endif
+#ifndef pgm_read_byte
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#endif
+#ifndef strcmp_P
+#define strcmp_P strcmp
+#endif
+#ifndef snprintf_P
+#define snprintf_P snprintf
+#endif
+#endif
+
+#define AT_LINE_MAX 48         // Longer response lines are cut, only their start is matched
+#define AT_TIMEOUT_MS 1000UL   // Plain commands
+#define AT_CONNECT_MS 10000UL  // AT+CIPSTART waits for the TCP handshake
+#define AT_SWITCH_MS 20UL      // The module answers at the old rate, then switches
+#define AT_GUARD_MS 1000UL     // Silence around "+++" that leaves passthrough
+#define AT_PROBE_ATTEMPTS 3
+
+// AT command layer of the ESP-AT link: rate negotiation and the transparent
+// (passthrough) mode WiFiEspAT does not use. Port is the UART, it provides
+//   int available(); int read(); size_t write(uint8_t);
+//   void setBaud(uint32_t); unsigned long now(); void wait(unsigned long ms);
+// which lets the host tests run it against a simulated module.
+template <typename Port>
+class AtLink
+{
+public:
+    enum Result
+    {
+        Ok,
+        Error,
+        Timeout
+    };
+
+    explicit AtLink(Port &port) : port(port), length(0) {}
+
+    // Sends the command and waits for OK / ERROR / FAIL, or for a line (or
+    // prompt) equal to `expect` when one is given
+    Result command(PGM_P text, unsigned long timeoutMs = AT_TIMEOUT_MS, PGM_P expect = nullptr)
+    {
+        discardInput();
+        for (PGM_P p = text; pgm_read_byte(p) != 0; p++)
+        {
+            port.write(pgm_read_byte(p));
+        }
+        return finishCommand(timeoutMs, expect);
+    }
+
+    bool probe(uint8_t attempts = AT_PROBE_ATTEMPTS)
+    {
+        for (uint8_t i = 0; i < attempts; i++)
+        {
+            if (command(PSTR("AT"), 200) == Ok)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Moves the module and the port to `fast` with AT+UART_CUR (not stored,
+    // a module reset goes back to its default) and checks that the new rate
+    // carries. Falls back to `fallback` when the firmware refuses the rate or
+    // it does not work on this wiring. Returns the rate in use, 0 when the
+    // module no longer answers at all. flowControl is the AT+UART_CUR field
+    // (2: the module holds its output while our RTS line is high).
+    uint32_t negotiateBaud(uint32_t fast, uint32_t fallback, uint8_t flowControl)
+    {
+        port.setBaud(fallback);
+        if (!probe())
+        {
+            return 0;
+        }
+        if (fast == 0 || fast == fallback)
+        {
+            return fallback;
+        }
+        if (uartCommand(fast, flowControl) != Ok)
+        {
+            return fallback;
+        }
+        port.wait(AT_SWITCH_MS);
+        port.setBaud(fast);
+        if (probe())
+        {
+            return fast;
+        }
+
+        // The module may not have switched after all
+        port.setBaud(fallback);
+        if (probe())
+        {
+            return fallback;
+        }
+        // It did but the rate does not carry: ask it back blind, after a
+        // line end that closes the noise the probes just left in its buffer
+        port.setBaud(fast);
+        port.write('\r');
+        port.write('\n');
+        uartCommand(fallback, 0);
+        port.wait(AT_SWITCH_MS);
+        port.setBaud(fallback);
+        return probe() ? fallback : 0;
+    }
+
+    // Single connection transparent mode: after this every byte written to
+    // the port goes to the TCP peer and every byte read came from it, no
+    // AT+CIPSEND framing. Fails back to the multiplexed mode WiFiEspAT uses.
+    bool enterPassthrough(const char *host, uint16_t remotePort)
+    {
+        if (command(PSTR("AT+CIPMUX=0")) != Ok || command(PSTR("AT+CIPMODE=1")) != Ok)
+        {
+            restoreMultiplexed();
+            return false;
+        }
+        char start[AT_LINE_MAX + 32];
+        int n = snprintf_P(start, sizeof(start), PSTR("AT+CIPSTART=\"TCP\",\"%s\",%u"), host, remotePort);
+        if (n <= 0 || n >= (int)sizeof(start))
+        {
+            restoreMultiplexed();
+            return false;
+        }
+        discardInput();
+        for (int i = 0; i < n; i++)
+        {
+            port.write((uint8_t)start[i]);
+        }
+        if (finishCommand(AT_CONNECT_MS, nullptr) != Ok)
+        {
+            restoreMultiplexed();
+            return false;
+        }
+        if (command(PSTR("AT+CIPSEND"), AT_TIMEOUT_MS, PSTR(">")) != Ok)
+        {
+            command(PSTR("AT+CIPCLOSE"));
+            restoreMultiplexed();
+            return false;
+        }
+        return true;
+    }
+
+    // "+++" framed by silence ends passthrough, then the socket is closed
+    // and the module is put back the way WiFiEspAT expects it
+    bool leavePassthrough()
+    {
+        port.wait(AT_GUARD_MS);
+        port.write('+');
+        port.write('+');
+        port.write('+');
+        port.wait(AT_GUARD_MS);
+        discardInput();
+        command(PSTR("AT+CIPCLOSE"));
+        return restoreMultiplexed();
+    }
+
+private:
+    Port &port;
+    char line[AT_LINE_MAX];
+    uint8_t length;
+
+    Result uartCommand(uint32_t baud, uint8_t flowControl)
+    {
+        char text[40];
+        int n = snprintf_P(text, sizeof(text), PSTR("AT+UART_CUR=%lu,8,1,0,%u"), (unsigned long)baud, flowControl);
+        discardInput();
+        for (int i = 0; i < n && i < (int)sizeof(text); i++)
+        {
+            port.write((uint8_t)text[i]);
+        }
+        return finishCommand(AT_TIMEOUT_MS, nullptr);
+    }
+
+    bool restoreMultiplexed()
+    {
+        bool single = command(PSTR("AT+CIPMODE=0")) == Ok;
+        bool mux = command(PSTR("AT+CIPMUX=1")) == Ok;
+        command(PSTR("AT+CIPRECVMODE=1"));
+        return single && mux;
+    }
+
+    Result finishCommand(unsigned long timeoutMs, PGM_P expect)
+    {
+        port.write('\r');
+        port.write('\n');
+        length = 0;
+        unsigned long started = port.now();
+        while (port.now() - started < timeoutMs)
+        {
+            int c = port.read();
+            if (c < 0)
+            {
+                continue;
+            }
+            if (c == '\n')
+            {
+                line[length] = '\0';
+                Result result;
+                if (lineResult(expect, result))
+                {
+                    return result;
+                }
+                length = 0;
+                continue;
+            }
+            if (c == '\r')
+            {
+                continue;
+            }
+            if (length < AT_LINE_MAX - 1)
+            {
+                line[length++] = (char)c;
+            }
+            // Matched as it arrives, the CIPSEND prompt has no line end
+            line[length] = '\0';
+            if (expect != nullptr && strcmp_P(line, expect) == 0)
+            {
+                return Ok;
+            }
+        }
+        return Timeout;
+    }
+
+    bool lineResult(PGM_P expect, Result &result)
+    {
+        if (strcmp_P(line, PSTR("ERROR")) == 0 || strcmp_P(line, PSTR("FAIL")) == 0)
+        {
+            result = Error;
+            return true;
+        }
+        if (expect == nullptr && strcmp_P(line, PSTR("OK")) == 0)
+        {
+            result = Ok;
+            return true;
+        }
+        return false;
+    }
+
+    void discardInput()
+    {
+        while (port.available() > 0)
+        {
+            port.read();
+        }
+    }
+};
+
+#endif // AT_LINK_H
@@ -0,0 +1,77 @@
+#ifndef BYTE_RING_H
+#define BYTE_RING_H
+
+#include <stdint.h>
+
+// Single producer / single consumer byte queue between a receive ISR and
+// the loop. Size is a power of two up to 256 so both indices are one byte:
+// each side only writes its own index and reading the other one cannot
+// tear on an 8-bit AVR, no interrupt masking needed. Holds Size - 1 bytes.
+template <uint16_t Size>
+class ByteRing
+{
+    static_assert(Size >= 2 && Size <= 256 && (Size & (Size - 1)) == 0, "ByteRing size must be a power of two up to 256");
+
+public:
+    ByteRing() : head(0), tail(0), dropped(0) {}
+
+    // Producer (ISR) side, a byte that does not fit is counted and lost
+    bool push(uint8_t value)
+    {
+        uint8_t next = (uint8_t)((head + 1) & (Size - 1));
+        if (next == tail)
+        {
+            dropped++;
+            return false;
+        }
+        buffer[head] = value;
+        head = next;
+        return true;
+    }
+
+    // Consumer (loop) side, -1 when empty
+    int pop()
+    {
+        if (head == tail)
+        {
+            return -1;
+        }
+        uint8_t value = buffer[tail];
+        tail = (uint8_t)((tail + 1) & (Size - 1));
+        return value;
+    }
+
+    int peek() const
+    {
+        return head == tail ? -1 : buffer[tail];
+    }
+
+    uint16_t size() const
+    {
+        return (uint16_t)((head - tail) & (Size - 1));
+    }
+
+    static uint16_t capacity()
+    {
+        return Size - 1;
+    }
+
+    void clear()
+    {
+        tail = head;
+    }
+
+    // Written by the producer, read it with interrupts masked
+    uint16_t getDropped() const
+    {
+        return dropped;
+    }
+
+private:
+    uint8_t buffer[Size];
+    volatile uint8_t head;
+    volatile uint8_t tail;
+    volatile uint16_t dropped;
+};
+
+#endif // BYTE_RING_H
@@ -0,0 +1,75 @@
+#ifndef ISR_SNAPSHOT_H
+#define ISR_SNAPSHOT_H
+
+#include <stdint.h>
+
+// Compiler barrier: keeps the sequence and payload accesses in program order
+#define ISR_SNAPSHOT_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+// Sequence-counter publication of multi-byte state from an ISR to the loop.
+// The ISR (single writer) brackets its update with beginWrite()/endWrite(),
+// the loop copies the value and retries if the counter moved meanwhile, so
+// readers never see a half-written value and interrupts are never masked.
+// The counter is one byte so reading it cannot tear on an 8-bit AVR; a copy
+// must not span 128 writes, far beyond any ISR rate the loop keeps up with.
+template <typename T>
+class IsrSnapshot
+{
+public:
+    IsrSnapshot() : sequence(0), value() {}
+
+    // Writer side: returns the live value to modify in place
+    T &beginWrite()
+    {
+        sequence = sequence + 1; // Odd while the value is inconsistent
+        ISR_SNAPSHOT_BARRIER();
+        return value;
+    }
+
+    void endWrite()
+    {
+        ISR_SNAPSHOT_BARRIER();
+        sequence = sequence + 1;
+    }
+
+    void write(const T &next)
+    {
+        beginWrite() = next;
+        endWrite();
+    }
+
+    // Reader side: single attempt, false if a write was in progress or overlapped
+    bool tryRead(T &out) const
+    {
+        uint8_t before = sequence;
+        ISR_SNAPSHOT_BARRIER();
+        if (before & 1)
+        {
+            return false;
+        }
+        out = value;
+        ISR_SNAPSHOT_BARRIER();
+        return sequence == before;
+    }
+
+    T read() const
+    {
+        T out;
+        while (!tryRead(out))
+        {
+        }
+        return out;
+    }
+
+    // Even number that changes with every published write
+    uint8_t getSequence() const
+    {
+        return sequence;
+    }
+
+private:
+    volatile uint8_t sequence;
+    T value;
+};
+
+#endif // ISR_SNAPSHOT_H
@@ -0,0 +1,80 @@
+#ifndef ISR_TRAMPOLINE_H
+#define ISR_TRAMPOLINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Type-erased handle so a runtime sensor object can carry the trampoline
+// that was chosen for it at compile time.
+struct IsrBinding
+{
+    void (*handler)();
+    bool (*bind)(void *instance);
+    void (*unbind)(void *instance);
+};
+
+// Compile-time ISR trampoline: every (Source, T) pair gets its own static
+// target pointer and its own handler function, so an interrupt jumps
+// straight to its instance with no table lookup. Source is the pin (or any
+// unique id) of the interrupt, T must provide onInterrupt().
+template <uint8_t Source, typename T>
+class IsrTrampoline
+{
+public:
+    // Fails instead of silently stealing an interrupt bound to another instance
+    static bool bind(T *instance)
+    {
+        if (target != nullptr && target != instance)
+        {
+            return false;
+        }
+        target = instance;
+        return true;
+    }
+
+    static void unbind(T *instance)
+    {
+        if (target == instance)
+        {
+            target = nullptr;
+        }
+    }
+
+    static T *get()
+    {
+        return target;
+    }
+
+    static void handle()
+    {
+        T *instance = target;
+        if (instance != nullptr)
+        {
+            instance->onInterrupt();
+        }
+    }
+
+    static IsrBinding binding()
+    {
+        IsrBinding result = {handle, bindErased, unbindErased};
+        return result;
+    }
+
+private:
+    static T *volatile target;
+
+    static bool bindErased(void *instance)
+    {
+        return bind(static_cast<T *>(instance));
+    }
+
+    static void unbindErased(void *instance)
+    {
+        unbind(static_cast<T *>(instance));
+    }
+};
+
+template <uint8_t Source, typename T>
+T *volatile IsrTrampoline<Source, T>::target = nullptr;
+
+#endif // ISR_TRAMPOLINE_H
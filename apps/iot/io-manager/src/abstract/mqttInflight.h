@@ -0,0 +1,303 @@
+#ifndef MQTT_INFLIGHT_H
+#define MQTT_INFLIGHT_H
+
+#include <stdint.h>
+
+#define MQTT_PUBLISH_QOS1 0x32 // PUBLISH, QoS 1, not retained
+#define MQTT_PUBLISH_DUP 0x08
+#define MQTT_PUBACK 0x40
+#define MQTT_PINGREQ 0xC0
+#define MQTT_PINGRESP 0xD0
+
+// Fixed header, remaining length and topic length prefix of a QoS 1
+// PUBLISH; the topic, the two byte packet id and the payload follow.
+// Returns the bytes written (at most 7).
+inline uint8_t mqttWritePublishHeader(uint8_t *out, uint16_t topicLength, uint16_t payloadLength)
+{
+    uint32_t remaining = 2UL + topicLength + 2 + payloadLength;
+    uint8_t n = 0;
+    out[n++] = MQTT_PUBLISH_QOS1;
+    do
+    {
+        uint8_t digit = remaining & 0x7F;
+        remaining >>= 7;
+        out[n++] = remaining > 0 ? (digit | 0x80) : digit;
+    } while (remaining > 0);
+    out[n++] = (uint8_t)(topicLength >> 8);
+    out[n++] = (uint8_t)(topicLength & 0xFF);
+    return n;
+}
+
+// Follows the packet boundaries of the inbound MQTT stream one byte at a
+// time and reports the packet id of every PUBACK. PubSubClient drops
+// PUBACKs, so the bytes are fed from a Client it reads through.
+// completed() tells which packet type the last byte finished (PINGRESP).
+class MqttAckScanner
+{
+public:
+    MqttAckScanner()
+    {
+        reset();
+    }
+
+    // Start of a new connection
+    void reset()
+    {
+        state = Header;
+        type = 0;
+        remaining = 0;
+        shift = 0;
+        packetId = 0;
+        idBytes = 0;
+        last = 0;
+    }
+
+    // Type of the packet the last fed byte completed, 0 mid-packet
+    uint8_t completed() const
+    {
+        return last;
+    }
+
+    // Packet id when this byte completes a PUBACK, 0 otherwise
+    uint16_t feed(uint8_t c)
+    {
+        last = 0;
+        switch (state)
+        {
+        case Header:
+            type = c & 0xF0;
+            remaining = 0;
+            shift = 0;
+            state = Length;
+            return 0;
+        case Length:
+            remaining |= (uint32_t)(c & 0x7F) << shift;
+            shift += 7;
+            if (c & 0x80)
+            {
+                if (shift > 21)
+                {
+                    reset(); // Malformed, resynchronise on the next byte
+                }
+                return 0;
+            }
+            packetId = 0;
+            idBytes = 0;
+            if (remaining == 0)
+            {
+                last = type;
+                state = Header;
+                return 0;
+            }
+            state = Body;
+            return 0;
+        case Body:
+            if (type == MQTT_PUBACK && idBytes < 2)
+            {
+                packetId = (uint16_t)((packetId << 8) | c);
+                idBytes++;
+            }
+            if (--remaining > 0)
+            {
+                return 0;
+            }
+            state = Header;
+            last = type;
+            return type == MQTT_PUBACK && idBytes == 2 ? packetId : 0;
+        }
+        return 0;
+    }
+
+private:
+    enum State
+    {
+        Header,
+        Length,
+        Body
+    };
+
+    State state;
+    uint8_t type;
+    uint32_t remaining;
+    uint8_t shift;
+    uint16_t packetId;
+    uint8_t idBytes;
+    uint8_t last;
+};
+
+// Unacknowledged QoS 1 PUBLISH packets, stored complete in preallocated
+// slots so a retransmission is a single write of the same bytes with DUP
+// set. Nothing here waits: the owner sends, feeds PUBACKs to acknowledge()
+// and asks nextDue() each loop for at most one packet to resend.
+template <uint8_t Slots, uint16_t PacketMax>
+class MqttInflightWindow
+{
+public:
+    struct Slot
+    {
+        uint16_t packetId; // 0 while free
+        uint16_t length;
+        unsigned long sentAt;
+        uint8_t attempts; // 0 until first sent
+        bool due;         // Resend at the next opportunity (reconnect)
+        uint8_t packet[PacketMax];
+    };
+
+    MqttInflightWindow() : nextId(1), acked(0), retransmits(0), expired(0)
+    {
+        for (uint8_t i = 0; i < Slots; i++)
+        {
+            slots[i].packetId = 0;
+        }
+    }
+
+    // A free slot with a fresh packet id, nullptr when the window is full.
+    // The owner writes the packet (id at its place) and sets length.
+    Slot *claim()
+    {
+        for (uint8_t i = 0; i < Slots; i++)
+        {
+            Slot &slot = slots[i];
+            if (slot.packetId == 0)
+            {
+                slot.packetId = nextId;
+                nextId = nextId == 0xFFFF ? 1 : nextId + 1;
+                slot.length = 0;
+                slot.sentAt = 0;
+                slot.attempts = 0;
+                slot.due = true;
+                return &slot;
+            }
+        }
+        return nullptr;
+    }
+
+    void markSent(Slot &slot, unsigned long now)
+    {
+        if (slot.attempts > 0)
+        {
+            retransmits++;
+        }
+        slot.attempts++;
+        slot.sentAt = now;
+        slot.due = false;
+        slot.packet[0] |= MQTT_PUBLISH_DUP; // Every later copy is a duplicate
+    }
+
+    // The oldest packet that was never sent, is marked due or whose ack is
+    // overdue; nullptr when nothing needs sending
+    Slot *nextDue(unsigned long now, unsigned long timeoutMs)
+    {
+        Slot *oldest = nullptr;
+        for (uint8_t i = 0; i < Slots; i++)
+        {
+            Slot &slot = slots[i];
+            if (slot.packetId == 0 || (!slot.due && now - slot.sentAt < timeoutMs))
+            {
+                continue;
+            }
+            if (oldest == nullptr || (int16_t)(slot.packetId - oldest->packetId) < 0)
+            {
+                oldest = &slot;
+            }
+        }
+        return oldest;
+    }
+
+    // After a reconnect every unacknowledged packet goes out again
+    void resendAll()
+    {
+        for (uint8_t i = 0; i < Slots; i++)
+        {
+            slots[i].due = slots[i].packetId != 0;
+        }
+    }
+
+    // Sent slot waiting for this id, nullptr when unknown
+    const Slot *find(uint16_t packetId) const
+    {
+        for (uint8_t i = 0; i < Slots; i++)
+        {
+            if (packetId != 0 && slots[i].packetId == packetId && slots[i].attempts > 0)
+            {
+                return &slots[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // How long the longest outstanding send has gone without its PUBACK
+    unsigned long longestWait(unsigned long now) const
+    {
+        unsigned long longest = 0;
+        for (uint8_t i = 0; i < Slots; i++)
+        {
+            const Slot &slot = slots[i];
+            if (slot.packetId != 0 && slot.attempts > 0 && !slot.due && now - slot.sentAt > longest)
+            {
+                longest = now - slot.sentAt;
+            }
+        }
+        return longest;
+    }
+
+    bool acknowledge(uint16_t packetId)
+    {
+        for (uint8_t i = 0; i < Slots; i++)
+        {
+            if (packetId != 0 && slots[i].packetId == packetId)
+            {
+                slots[i].packetId = 0;
+                acked++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Gives up on a packet (too many attempts)
+    void expire(Slot &slot)
+    {
+        slot.packetId = 0;
+        expired++;
+    }
+
+    uint8_t inFlight() const
+    {
+        uint8_t count = 0;
+        for (uint8_t i = 0; i < Slots; i++)
+        {
+            count += slots[i].packetId != 0;
+        }
+        return count;
+    }
+
+    static uint16_t capacity()
+    {
+        return PacketMax;
+    }
+
+    uint32_t getAcked() const
+    {
+        return acked;
+    }
+
+    uint32_t getRetransmits() const
+    {
+        return retransmits;
+    }
+
+    uint32_t getExpired() const
+    {
+        return expired;
+    }
+
+private:
+    Slot slots[Slots];
+    uint16_t nextId;
+    uint32_t acked;
+    uint32_t retransmits;
+    uint32_t expired;
+};
+
+#endif // MQTT_INFLIGHT_H
@@ -35,7 +35,8 @@
 //   5. Ensure router/DNS can resolve the hostname
 //   6. For local network, try mDNS: "mqtt-broker.local"
 
-// Using IP address until hostname resolution is configured
+// Names are resolved in the background and cached (services/broker-resolver),
+// an address is used as is. "set-broker" overrides both at runtime.
 #define MQTT_BROKER_HOST "192.168.100.102"  // Your MQTT broker's local IP
 #define MQTT_BROKER_PORT 3011
 
@@ -47,6 +48,75 @@
 // #define WIFI_SSID "your-ssid"
 // #define WIFI_PASSWORD "your-password"
 
+// ESP-AT Link (services/esp-link)
+// The AT firmware boots at ESP_BAUD_DEFAULT; the link is moved to
+// ESP_BAUD_FAST with AT+UART_CUR after the module starts and falls back to
+// the default when that rate does not work (0 disables the negotiation).
+// 250000 and 500000 are exact on the 16 MHz Mega, 230400 is 3.5% off.
+#define ESP_BAUD_DEFAULT 115200UL
+#define ESP_BAUD_FAST 250000UL
+// Receive ring filled by the USART1 ISR (the core's Serial1 has 64 bytes)
+#define ESP_RX_RING_SIZE 256
+// Pin wired to the module's CTS (GPIO13 on ESP-12 boards), -1 when not
+// wired. When set the ISR holds the module's output before the ring fills.
+#define ESP_RTS_PIN -1
+// 1: the broker socket uses the transparent mode of the AT firmware (no
+// AT+CIPSEND framing per packet). The module then carries only that socket,
+// so /metrics and /api/snapshot are served in portal mode only.
+#define ESP_PASSTHROUGH 0
+
+// Broker Resolution (services/broker-resolver)
+// Answers are kept for their TTL, clamped to BROKER_TTL_MIN_S..BROKER_TTL_MAX_S
+// seconds. Each lookup step (DNS at the gateway, then mDNS) waits
+// BROKER_QUERY_TIMEOUT_MS, lookups start at most every BROKER_RETRY_MS.
+// A broker set with "set-broker" is given up for the previous one after
+// BROKER_SWITCH_ATTEMPTS failed connects or lookups without an answer.
+#define BROKER_QUERY_TIMEOUT_MS 2000UL
+#define BROKER_RETRY_MS 30000UL
+#define BROKER_TTL_MIN_S 60UL
+#define BROKER_TTL_MAX_S 86400UL
+#define BROKER_SWITCH_ATTEMPTS 5
+
+// MQTT QoS 1 (sensor-data, rollups, alerts)
+// Unacknowledged packets are kept whole for retransmission, the window
+// costs MQTT_QOS1_WINDOW * MQTT_QOS1_PACKET_MAX bytes of SRAM. A packet is
+// resent with DUP after MQTT_QOS1_RETRY_MS without PUBACK and after every
+// reconnect, and dropped after MQTT_QOS1_MAX_ATTEMPTS sends. A slot holds
+// a whole rollup period (all channels, about 340 bytes of JSON).
+// Two slots (768 bytes) hold the short and long rollup due together at the
+// top of a long period; the raw frame of that pass waits for the first
+// PUBACK. Rollups claim their slots first; publishes that find the window
+// full are retried next loop (frames, rollups) or go out as QoS 0 (alerts).
+// A third slot costs another 384 bytes, check the SRAM report before.
+#define MQTT_QOS1_WINDOW 2
+#define MQTT_QOS1_PACKET_MAX 384
+#define MQTT_QOS1_RETRY_MS 10000UL
+#define MQTT_QOS1_MAX_ATTEMPTS 5
+
+// MQTT Link Health
+// PubSubClient pings after MQTT_KEEPALIVE_S idle seconds ("set-mqtt-keepalive",
+// persisted as "mqtt-keepalive"). A ping or PUBACK unanswered for
+// MQTT_RESPONSE_FACTOR times the p90 round trip, at least
+// MQTT_RESPONSE_TIMEOUT_MIN_MS and at most the keepalive, closes the socket,
+// so a dead link is noticed within seconds. The socket timeout follows it.
+#define MQTT_KEEPALIVE_S 10
+#define MQTT_RESPONSE_FACTOR 4
+#define MQTT_RESPONSE_TIMEOUT_MIN_MS 2000UL
+// Round trips kept for the percentiles, 2 bytes each per measurement
+#define MQTT_HEALTH_SAMPLES 16
+// "link-health" is published this often and on "get-link-health"
+#define MQTT_HEALTH_PERIOD_MS 60000UL
+
+// Joining a network is polled every WIFI_POLL_MS; without a connection
+// after WIFI_CONNECT_TIMEOUT_MS the device falls back to the access point
+// and tries the same network again in the background, first after
+// WIFI_RETRY_MIN_MS, doubling up to WIFI_RETRY_MAX_MS (a router that boots
+// slower than the Mega after a power cut).
+#define WIFI_CONNECT_TIMEOUT_MS 20000UL
+#define WIFI_POLL_MS 500UL
+#define WIFI_RETRY_MIN_MS 30000UL
+#define WIFI_RETRY_MAX_MS 300000UL
+
 // Access Point Configuration
 #define AP_SSID "ESP8266"
 #define AP_PASSWORD "12345678"
@@ -54,4 +124,50 @@
 #define AP_GATEWAY IPAddress(5, 5, 5, 5)
 #define AP_SUBNET IPAddress(255, 255, 255, 0)
 
+// Sensor Statistics
+// Capacity of the per-channel rolling window (samples). Each sample keeps a
+// float value, its timestamp and two queue slots, about 190 bytes per channel
+// at 16 samples plus the std::map node (roughly 1.3 KB for the analog
+// channels; the binary pump channels have none). There is one window per
+// channel, a second length would double that. The active window can be
+// shortened at runtime with "set-stats-window", for all channels or one.
+#define ROLLING_STATS_CAPACITY 16
+
+// Telemetry Rollups
+// Each period is published as one "sensor-rollup" message with all channels.
+// In "rollup-only" telemetry mode a raw frame is still sent when any channel
+// moved more than EXCURSION_SIGMA standard deviations (rolling window) away
+// from the last frame that was sent.
+#define ROLLUP_SHORT_PERIOD_MS 60000UL
+#define ROLLUP_LONG_PERIOD_MS 300000UL
+#define EXCURSION_SIGMA 3.0
+
+// Sensor Sampling
+// The poll tick only checks which sensors are due, each sensor has its own
+// interval ("set-sensor-interval", persisted as "rate-<sensor>").
+#define SENSOR_TICK_MS 100
+// A pass stops starting reads once this much time is spent ("set-sensor-budget").
+// The first read of a pass always runs. Slow sensors split their reads into
+// short steps on consecutive passes (DS18B20: start, then fetch after the
+// conversion; pH: 5 of its 50 ADC samples per pass), so a pass stays within
+// the budget and an overrun is the exception.
+#define SENSOR_BUDGET_US 20000UL
+
+// Water Flow (sensor wiring lives in sensors/sensors.config.h)
+#define FLOW_GATE_MS 1000UL
+// The total volume is written to EEPROM at most this often (and only after a full liter)
+#define FLOW_PERSIST_INTERVAL_MS 600000UL
+
+// Logging (utility/logger.util.h)
+// Levels above LOG_LEVEL are compiled out. Production keeps warnings and
+// errors; debug builds add -DLOG_LEVEL=LOG_LEVEL_DEBUG to build_flags.
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_WARN
+#endif
+// Lines queue here until the UART has room, a line that does not fit is dropped
+#define LOG_RING_SIZE 256
+#define LOG_LINE_MAX 96
+// Lines per call site per second, the rest are counted as throttled
+#define LOG_SITE_BURST 3
+
 #endif // CONFIG_H
@@ -1,5 +1,8 @@
 #include "app.context.h"
 #include "config.h"
+#include "utility/flashString.util.h"
+#include "utility/logger.util.h"
+#include "utility/sramHeadroom.util.h"
 // Replace raw pointers with UniquePtr
 UniquePtr<ActiveMQClientService> activeMQService;
 UniquePtr<DataCollector> dataCollector;
@@ -15,74 +18,200 @@ AppContext::AppContext()
       diskManager(new DiskManagerService()),
       wifiService(new WiFiService()),
       webServerService(new WebServerService(*diskManager, *wifiService)),
-      sensorPollTimer(1000),
+      alertEngine(new AlertEngineService(*diskManager)),
+      scheduler(new SchedulerService(*diskManager, *moduleManager, wallClock)),
+      brokerResolver(new BrokerResolverService(*diskManager)),
+      sensorPollTimer(SENSOR_TICK_MS),
       lcdUpdateTimer(2000),
       dataSendTimer(2000),
-      eventHandleTimer(1000) {}
+      eventHandleTimer(1000),
+      linkHealthTimer(MQTT_HEALTH_PERIOD_MS) {}
 
 // No need to manually delete resources in the destructor
 AppContext::~AppContext() = default;
 
 void AppContext::initialize()
 {
+    // Setup lines wait for the UART, the loop never does
+    Logger::begin(Serial);
 
     dataCollector->initializeSensors();
 
     moduleManager->initializeModules(dataCollector, wifiService, activeMQService);
 
     diskManager->initialize();
+    alertEngine->initialize();
+    scheduler->initialize();
+    bootId = diskManager->read("boot-id").toInt() + 1;
+    diskManager->save("boot-id", String(bootId));
+    String savedBudget = diskManager->read("sensor-budget");
+    if (savedBudget.length() > 0)
+    {
+        dataCollector->setBudget(savedBudget.toInt());
+    }
+    String savedTelemetryMode = diskManager->read("telemetry-mode");
+    if (savedTelemetryMode.length() > 0)
+    {
+        telemetryMode = savedTelemetryMode;
+    }
+    String savedKeepAlive = diskManager->read("mqtt-keepalive");
+    if (savedKeepAlive.length() > 0)
+    {
+        activeMQService->setKeepAlive(savedKeepAlive.toInt());
+    }
 
+    // Setup may block: let the reads split across passes complete, so the
+    // first snapshot has every channel
+    unsigned long firstPassAt = millis();
     dataCollector->collectData();
-    dataCollector->printData(dataCollector->currentData);
+    while (dataCollector->isAcquiring() && millis() - firstPassAt < 2000)
+    {
+        delay(SENSOR_TICK_MS);
+        dataCollector->collectData();
+    }
+    dataCollector->loadSampling(*diskManager);
+    dataCollector->printData(dataCollector->getSnapshot());
 
     clientId = wifiService->begin();
-    Serial.println("Client ID: " + clientId);
+    LOG_INFO("app", "Client ID: %s", clientId.c_str());
     // diskManager->remove("ssid");
     // diskManager->remove("password");
     ssid = "TI_EIXAME_TI_XASAME"; // diskManager->read("ssid");
     password = "denkserw";        // diskManager->read("password");
 
-    // Build broker address from config.h settings
-    brokerAddress = String("mqtt://") + MQTT_BROKER_HOST + ":" + String(MQTT_BROKER_PORT);
+    // config.h settings unless moved with "set-broker"
+    brokerResolver->initialize(MQTT_BROKER_HOST, MQTT_BROKER_PORT);
+    brokerAddress = String("mqtt://") + brokerResolver->getHost() + ":" + String(brokerResolver->getPort());
     if (ssid.length() > 0 && password.length() > 0)
     {
-        Serial.println("Credentials found, connecting to WiFi...");
+        LOG_INFO("app", "Credentials found, connecting to WiFi");
         wifiService->connectToWiFi(ssid.c_str(), password.c_str());
-        activeMQService->initialize(MQTT_BROKER_HOST, MQTT_BROKER_PORT, clientId.c_str());
-        activeMQService->subscribe("pump-on");
-        activeMQService->subscribe("pump-off");
-        activeMQService->subscribe("air-pump-on");
-        activeMQService->subscribe("air-pump-off");
-        activeMQService->subscribe("scan-networks");
-        activeMQService->subscribe("connect-to-wifi");
-        activeMQService->subscribe("turn-to-ap");
-        activeMQService->subscribe("set-sensor-poll-interval");
-        activeMQService->subscribe("close-lcd");
-        activeMQService->subscribe("open-lcd");
-        activeMQService->subscribe("time-sync");
+        // Setup may block, but only until the join times out
+        while (wifiService->isConnecting())
+        {
+            delay(WIFI_POLL_MS);
+            wifiService->loop();
+        }
     }
-    else
+    if (flashEquals(wifiService->mode, F("client")))
+    {
+        activeMQService->initialize(*brokerResolver, clientId.c_str());
+        subscribeTopics();
+    }
+    else if (!flashEquals(wifiService->mode, F("ap")))
     {
-        Serial.println("No credentials found, turning to Access Point mode...");
+        LOG_INFO("app", "No credentials found, starting the access point");
         wifiService->turnToAccessPointMode(AP_SSID, AP_PASSWORD);
+    }
+    // Portal in AP mode, /metrics and /api/snapshot in both modes (portal
+    // only with ESP_PASSTHROUGH, the module then carries just the broker)
+    if (!ESP_PASSTHROUGH || flashEquals(wifiService->mode, F("ap")))
+    {
         webServerService->begin();
     }
+    Logger::setBlocking(false);
+}
+
+// Recorded while offline too, reconnect() subscribes them all
+void AppContext::subscribeTopics()
+{
+    activeMQService->subscribe(F("pump-on"));
+    activeMQService->subscribe(F("pump-off"));
+    activeMQService->subscribe(F("air-pump-on"));
+    activeMQService->subscribe(F("air-pump-off"));
+    activeMQService->subscribe(F("scan-networks"));
+    activeMQService->subscribe(F("connect-to-wifi"));
+    activeMQService->subscribe(F("turn-to-ap"));
+    activeMQService->subscribe(F("set-sensor-poll-interval"));
+    activeMQService->subscribe(F("set-sensor-interval"));
+    activeMQService->subscribe(F("get-sensor-intervals"));
+    activeMQService->subscribe(F("get-sensor-health"));
+    activeMQService->subscribe(F("set-sensor-budget"));
+    activeMQService->subscribe(F("get-sensor-budget"));
+    activeMQService->subscribe(F("close-lcd"));
+    activeMQService->subscribe(F("open-lcd"));
+    activeMQService->subscribe(F("time-sync"));
+    activeMQService->subscribe(F("get-stats"));
+    activeMQService->subscribe(F("set-stats-window"));
+    activeMQService->subscribe(F("stats-telemetry"));
+    activeMQService->subscribe(F("set-telemetry-mode"));
+    activeMQService->subscribe(F("set-alert-rule"));
+    activeMQService->subscribe(F("clear-alert-rule"));
+    activeMQService->subscribe(F("get-alert-rules"));
+    activeMQService->subscribe(F("set-schedule"));
+    activeMQService->subscribe(F("clear-schedule"));
+    activeMQService->subscribe(F("get-schedules"));
+    activeMQService->subscribe(F("get-link-health"));
+    activeMQService->subscribe(F("set-mqtt-keepalive"));
+    activeMQService->subscribe(F("set-broker"));
+    mqttStarted = true;
 }
 
 void AppContext::loop()
 {
-    if (wifiService->mode == "ap")
+    unsigned long loopStart = micros();
+    if (loopStartedAt != 0)
     {
-        if (webServerService->getState() == "stopped")
+        lastLoopUs = loopStart - loopStartedAt;
+        maxLoopUs = lastLoopUs > maxLoopUs ? lastLoopUs : maxLoopUs;
+    }
+    loopStartedAt = loopStart;
+    loopIterations++;
+    Logger::drain();
+
+    if (!ESP_PASSTHROUGH || flashEquals(wifiService->mode, F("ap")))
+    {
+        if (flashEquals(webServerService->getState(), F("stopped")))
         {
             webServerService->begin();
         }
         webServerService->handleClient();
+    }
+    // No background join while a portal client is being served
+    wifiService->loop(webServerService->getOpenConnections() == 0);
+    if (dataCollector->getSnapshot().isNewerThan(renderedVersion) && renderSnapshot())
+    {
+        renderedVersion = dataCollector->getSnapshot().getVersion();
+    }
+
+    // Local logic (sensors, alerts, schedules) keeps running while the
+    // portal is up or the broker is away
+    if (sensorPollTimer.canRun() && dataCollector->collectData())
+    {
+        alertEngine->evaluate(dataCollector->getSnapshot().getValues(), millis());
+        handleAlertEvents();
+        if (dataCollector->takeHealthChanged())
+        {
+            publishHealth();
+        }
+        // moduleManager->lcd->update();
+    }
+
+    if (eventHandleTimer.canRun())
+    {
+        scheduler->update(millis());
+    }
+
+    if (lcdUpdateTimer.canRun())
+    {
+        // Update carousel to cycle through pages
+        moduleManager->lcd->updateCarousel();
+    }
+
+    if (flashEquals(wifiService->mode, F("ap")))
+    {
         return;
     }
+    // Joined in the background after a fallback to the access point
+    if (!mqttStarted)
+    {
+        activeMQService->attach(*brokerResolver);
+        subscribeTopics();
+    }
+    brokerResolver->loop();
     if (!activeMQService->isConnected())
     {
-        activeMQService->initialize(MQTT_BROKER_HOST, MQTT_BROKER_PORT, clientId.c_str());
+        activeMQService->reconnect(clientId.c_str());
     }
 
     activeMQService->loop();
@@ -90,63 +219,124 @@ void AppContext::loop()
     {
 
         auto message = activeMQService->getNextMessage();
-        Serial.println("Message received: " + message.topic + " - " + message.message);
+        LOG_DEBUG("app", "Handling %s", message.topic.c_str());
         JsonDocument response;
         // split topic with "/" separator
         String topic = message.topic;
-        if (topic == "pump-on")
+        if (flashEquals(topic, F("pump-on")))
         {
             moduleManager->waterPump->setPower(true);
-            response["pump-status"] = "on";
-            activeMQService->publish("pump-status", response);
+            response[F("pump-status")] = "on";
+            activeMQService->publish(F("pump-status"), response);
         }
-        else if (topic == "pump-off")
+        else if (flashEquals(topic, F("pump-off")))
         {
             moduleManager->waterPump->setPower(false);
-            activeMQService->publish("pump-status", response);
+            activeMQService->publish(F("pump-status"), response);
         }
-        else if (topic == "air-pump-on")
+        else if (flashEquals(topic, F("air-pump-on")))
         {
             moduleManager->airPump->setPower(true);
-            activeMQService->publish("air-pump-status", response);
+            activeMQService->publish(F("air-pump-status"), response);
         }
-        else if (topic == "air-pump-off")
+        else if (flashEquals(topic, F("air-pump-off")))
         {
             moduleManager->airPump->setPower(false);
-            activeMQService->publish("air-pump-status", response);
+            activeMQService->publish(F("air-pump-status"), response);
         }
-        else if (topic == "scan-networks")
+        else if (flashEquals(topic, F("scan-networks")))
         {
             wifiService->scanNetworks();
-            activeMQService->publish("networks", response);
+            activeMQService->publish(F("networks"), response);
         }
-        else if (topic == "connect-to-wifi")
+        else if (flashEquals(topic, F("connect-to-wifi")))
         {
             wifiService->connectToWiFi(message.message.c_str(), "12345678");
-            activeMQService->publish("wifi-status", response);
+            activeMQService->publish(F("wifi-status"), response);
         }
-        else if (topic == "turn-to-ap")
+        else if (flashEquals(topic, F("turn-to-ap")))
         {
             wifiService->turnToAccessPointMode("ESP8266", "12345678");
 
-            // activeMQService->publish("wifi-status", response);
+            // activeMQService->publish(F("wifi-status"), response);
+        }
+        else if (flashEquals(topic, F("set-sensor-poll-interval")))
+        {
+            // Legacy: same base interval for every sensor, not persisted
+            dataCollector->setAllIntervals(message.message.toInt());
+            activeMQService->publish(F("sensor-poll-interval"), response);
         }
-        else if (topic == "set-sensor-poll-interval")
+        else if (flashEquals(topic, F("set-sensor-interval")))
         {
-            sensorPollTimer = Timer(message.message.toInt());
-            activeMQService->publish("sensor-poll-interval", response);
+            // {"sensor": "SEN0161", "ms": 10000, "adaptive": true}, "ch": "ph" names it by a channel
+            JsonDocument doc;
+            DeserializationError error = deserializeJson(doc, message.message);
+            String name = doc["sensor"] | (doc["ch"] | "");
+            unsigned long intervalMs = doc["ms"] | 0UL;
+            bool adaptive = doc["adaptive"] | false;
+            const std::string *sensor = error ? nullptr : dataCollector->findSensor(name.c_str());
+            bool saved = sensor != nullptr && dataCollector->setSampling(*sensor, intervalMs, adaptive);
+            if (saved)
+            {
+                diskManager->save(String("rate-") + sensor->c_str(), String(intervalMs) + "," + (adaptive ? "1" : "0"));
+            }
+            response[F("sensor")] = sensor != nullptr ? sensor->c_str() : name.c_str();
+            response[F("saved")] = saved;
+            activeMQService->publish(F("sensor-interval-status"), response);
         }
-        else if (topic == "close-lcd")
+        else if (flashEquals(topic, F("get-sensor-intervals")))
+        {
+            for (const auto &entry : dataCollector->getSampling())
+            {
+                JsonDocument intervalDoc;
+                intervalDoc[F("client-id")] = clientId;
+                intervalDoc[F("sensor")] = entry.first;
+                JsonArray channels = intervalDoc[F("ch")].to<JsonArray>();
+                for (const auto &channel : dataCollector->getChannelSensors())
+                {
+                    if (channel.second == entry.first)
+                    {
+                        channels.add(channel.first);
+                    }
+                }
+                intervalDoc[F("ms")] = entry.second->intervalMs;
+                intervalDoc[F("current")] = entry.second->currentMs;
+                intervalDoc[F("min")] = entry.second->minIntervalMs;
+                intervalDoc[F("adaptive")] = entry.second->adaptive;
+                activeMQService->publish(F("sensor-intervals"), intervalDoc);
+            }
+        }
+        else if (flashEquals(topic, F("get-sensor-health")))
+        {
+            publishHealth();
+        }
+        else if (flashEquals(topic, F("set-sensor-budget")) || flashEquals(topic, F("get-sensor-budget")))
+        {
+            long budget = message.message.toInt();
+            if (flashEquals(topic, F("set-sensor-budget")) && budget > 0)
+            {
+                dataCollector->setBudget(budget);
+                diskManager->save("sensor-budget", String(budget));
+            }
+            response[F("client-id")] = clientId;
+            response[F("budget-us")] = dataCollector->getBudget();
+            response[F("last-pass-us")] = dataCollector->getLastPassUs();
+            response[F("max-pass-us")] = dataCollector->getMaxPassUs();
+            response[F("overruns")] = dataCollector->getOverruns();
+            response[F("deferrals")] = dataCollector->getDeferrals();
+            activeMQService->publish(F("sensor-budget"), response);
+        }
+        else if (flashEquals(topic, F("close-lcd")))
         {
             moduleManager->lcd->setPower(false);
-            activeMQService->publish("lcd-status", response);
+            activeMQService->publish(F("lcd-status"), response);
         }
-        else if (topic == "open-lcd")
+        else if (flashEquals(topic, F("open-lcd")))
         {
             moduleManager->lcd->setPower(true);
-            activeMQService->publish("lcd-status", response);
+            activeMQService->publish(F("lcd-status"), response);
         }
-        else if (topic == "time-sync")
+        else if (flashEquals(topic, F("time-sync")))
         {
             // Parse JSON: {"time": "14:30:45", "date": "20/10/2025"}
             JsonDocument doc;
@@ -157,41 +347,474 @@ void AppContext::loop()
                 String time = doc["time"].as<String>();
                 String date = doc["date"].as<String>();
                 moduleManager->lcd->setTime(time, date);
-                Serial.println("Time synced: " + time + " " + date);
+                uint32_t secondsOfDay = time.substring(0, 2).toInt() * 3600UL + time.substring(3, 5).toInt() * 60UL + time.substring(6, 8).toInt();
+                wallClock.sync(epochFromCivil(date.substring(6, 10).toInt(), date.substring(3, 5).toInt(), date.substring(0, 2).toInt(), secondsOfDay), millis());
+                LOG_INFO("app", "Time synced: %s %s", time.c_str(), date.c_str());
+            }
+        }
+        else if (flashEquals(topic, F("get-stats")))
+        {
+            publishStats();
+        }
+        else if (flashEquals(topic, F("set-stats-window")))
+        {
+            // "16" for every channel or {"ch": "ph", "samples": 8} for one
+            JsonDocument doc;
+            if (message.message.startsWith("{") && !deserializeJson(doc, message.message) && doc["ch"].is<const char *>() &&
+                doc["samples"].is<int>())
+            {
+                dataCollector->setStatsWindow(doc["samples"].as<int>(), doc["ch"].as<const char *>());
+            }
+            else
+            {
+                dataCollector->setStatsWindow(message.message.toInt());
+            }
+        }
+        else if (flashEquals(topic, F("stats-telemetry")))
+        {
+            statsTelemetry = flashEquals(message.message, F("on"));
+        }
+        else if (flashEquals(topic, F("set-telemetry-mode")))
+        {
+            if (flashEquals(message.message, F("raw")) || flashEquals(message.message, F("rollup")) || flashEquals(message.message, F("rollup-only")))
+            {
+                telemetryMode = message.message;
+                diskManager->save("telemetry-mode", telemetryMode);
+            }
+            response[F("telemetry-mode")] = telemetryMode;
+            activeMQService->publish(F("telemetry-mode"), response);
+        }
+        else if (flashEquals(topic, F("set-alert-rule")))
+        {
+            // {"slot": 0, "ch": "ph", "op": "<", "th": 5.5, "hy": 0.2, "dur": 60, "guard": "", "action": ""}
+            JsonDocument doc;
+            DeserializationError error = deserializeJson(doc, message.message);
+            AlertRule rule;
+            // Only "guard" and "action" may be left out, a missing number
+            // must not turn into a 0 threshold or duration
+            bool complete = !error && doc["slot"].is<int>() && doc["ch"].is<const char *>() && doc["op"].is<const char *>() &&
+                            doc["th"].is<float>() && doc["hy"].is<float>() && doc["dur"].is<long>();
+            String encoded = String(doc["ch"] | "") + "," + String(doc["op"] | "") + "," +
+                             String(doc["th"] | 0.0f, 3) + "," + String(doc["hy"] | 0.0f, 3) + "," +
+                             String(doc["dur"] | 0L) + "," + String(doc["guard"] | "") + "," + String(doc["action"] | "");
+            bool saved = complete && AlertEngineService::decodeRule(encoded, rule) && alertEngine->setRule(doc["slot"] | 0, rule);
+            response[F("slot")] = doc["slot"] | 0;
+            response[F("saved")] = saved;
+            activeMQService->publish(F("alert-rule-status"), response);
+        }
+        else if (flashEquals(topic, F("clear-alert-rule")))
+        {
+            alertEngine->clearRule(message.message.toInt());
+        }
+        else if (flashEquals(topic, F("get-alert-rules")))
+        {
+            for (uint8_t slot = 0; slot < MAX_ALERT_RULES; slot++)
+            {
+                const AlertRule &rule = alertEngine->getRule(slot);
+                if (rule.op == 0)
+                {
+                    continue;
+                }
+                JsonDocument ruleDoc;
+                ruleDoc[F("slot")] = slot;
+                ruleDoc[F("rule")] = AlertEngineService::encodeRule(rule);
+                ruleDoc[F("active")] = alertEngine->isActive(slot);
+                activeMQService->publish(F("alert-rules"), ruleDoc);
+            }
+        }
+        else if (flashEquals(topic, F("set-schedule")))
+        {
+            // {"actuator": 0, "on": 300, "off": 900, "start": 360, "end": 1200, "minOn": 60, "minOff": 60, "maxRun": 600}
+            JsonDocument doc;
+            DeserializationError error = deserializeJson(doc, message.message);
+            ActuatorSchedule schedule;
+            // Every key is required, a missing one must not become 0
+            bool complete = !error;
+            const char *keys[] = {"actuator", "on", "off", "start", "end", "minOn", "minOff", "maxRun"};
+            for (const char *key : keys)
+            {
+                complete = complete && doc[key].is<long>();
+            }
+            String encoded = String(doc["on"] | 0) + "," + String(doc["off"] | 0) + "," + String(doc["start"] | 0) + "," +
+                             String(doc["end"] | 0) + "," + String(doc["minOn"] | 0) + "," + String(doc["minOff"] | 0) + "," +
+                             String(doc["maxRun"] | 0);
+            bool saved = complete && SchedulerService::decodeSchedule(encoded, schedule) && scheduler->setSchedule(doc["actuator"] | 0, schedule);
+            response[F("actuator")] = doc["actuator"] | 0;
+            response[F("saved")] = saved;
+            activeMQService->publish(F("schedule-status"), response);
+        }
+        else if (flashEquals(topic, F("clear-schedule")))
+        {
+            scheduler->clearSchedule(message.message.toInt());
+        }
+        else if (flashEquals(topic, F("get-link-health")))
+        {
+            publishLinkHealth();
+        }
+        else if (flashEquals(topic, F("set-mqtt-keepalive")))
+        {
+            long seconds = message.message.toInt();
+            if (seconds > 0)
+            {
+                activeMQService->setKeepAlive(seconds);
+                diskManager->save("mqtt-keepalive", String(activeMQService->getKeepAlive()));
+            }
+            publishLinkHealth();
+        }
+        else if (flashEquals(topic, F("set-broker")))
+        {
+            // {"host": "mqtt-broker.local", "port": 3011}
+            JsonDocument doc;
+            DeserializationError error = deserializeJson(doc, message.message);
+            String host = doc["host"] | "";
+            uint16_t port = doc["port"] | MQTT_BROKER_PORT;
+            bool accepted = !error && host.length() > 0 && host.length() < 64 && port > 0; // EEPROM value limit
+            if (accepted)
+            {
+                brokerResolver->setBroker(host, port);
+                brokerAddress = String("mqtt://") + host + ":" + String(port);
+            }
+            response[F("host")] = brokerResolver->getHost();
+            response[F("port")] = brokerResolver->getPort();
+            response[F("accepted")] = accepted;
+            // Persisted once the new broker takes a CONNECT, until then a
+            // reboot or BROKER_SWITCH_ATTEMPTS failures go back to the old one
+            response[F("pending")] = brokerResolver->isSwitching();
+            activeMQService->publish(F("broker-status"), response);
+            if (accepted)
+            {
+                // Reconnects to the new broker once its address is known
+                activeMQService->disconnect();
+            }
+        }
+        else if (flashEquals(topic, F("get-schedules")))
+        {
+            for (uint8_t actuator = 0; actuator < ModuleManager::actuatorCount; actuator++)
+            {
+                const ActuatorSchedule &schedule = scheduler->getSchedule(actuator);
+                if (!schedule.enabled)
+                {
+                    continue;
+                }
+                JsonDocument scheduleDoc;
+                scheduleDoc[F("actuator")] = actuator;
+                scheduleDoc[F("schedule")] = SchedulerService::encodeSchedule(schedule);
+                scheduleDoc[F("clock-synced")] = scheduler->isClockSynced();
+                activeMQService->publish(F("schedules"), scheduleDoc);
             }
         }
-
-        Serial.println("Message received: " + message.topic + " - " + message.message);
     }
 
-    if (sensorPollTimer.canRun())
+    if (linkHealthTimer.canRun() && activeMQService->isConnected())
     {
-        auto data = dataCollector->collectData();
-        // moduleManager->lcd->update();
+        publishLinkHealth();
     }
 
-    if (lcdUpdateTimer.canRun())
+    if (!flashEquals(telemetryMode, F("raw")))
     {
-        // Update carousel to cycle through pages
-        moduleManager->lcd->updateCarousel();
+        // Ahead of the raw frame for the QoS 1 window. A period that finds
+        // the window full stays pending and is retried next loop, until the
+        // next period of the same rollup replaces it
+        if (dataCollector->shortRollup.isPending() && publishRollup(dataCollector->shortRollup))
+        {
+            dataCollector->shortRollup.takePending();
+        }
+        if (dataCollector->longRollup.isPending() && publishRollup(dataCollector->longRollup))
+        {
+            dataCollector->longRollup.takePending();
+        }
     }
 
-    if (dataSendTimer.canRun())
+    // Only frames with something new since the last one sent
+    const TelemetrySnapshot &snapshot = dataCollector->getSnapshot();
+    if (dataSendTimer.canRun() && snapshot.isNewerThan(sentVersion))
     {
+        bool sendRaw = !flashEquals(telemetryMode, F("rollup-only")) || dataCollector->hasExcursion(lastSentData);
 
-        if (dataCollector->currentData.size() > 0)
+        if (sendRaw && !snapshot.empty())
         {
 
             JsonDocument jsonDoc;
-            jsonDoc["client-id"] = clientId;
-            for (const auto &entry : dataCollector->currentData)
+            jsonDoc[F("client-id")] = clientId;
+            for (const auto &entry : snapshot.getValues())
             {
                 jsonDoc[entry.first] = entry.second;
             }
-            serializeJson(jsonDoc, Serial);
             // deserializeJson(jsonDoc, "{\"temperature\": 25.0, \"humidity\": 50.0, \"ph\": 7.0, \"tds\": 100.0}");
-            activeMQService->publish("sensor-data", jsonDoc);
-            Serial.println(jsonDoc.overflowed());
+            if (jsonDoc.overflowed())
+            {
+                LOG_WARN("app", "sensor-data frame overflowed");
+            }
+            // A full QoS 1 window keeps the frame pending, a later pass
+            // sends the then current values
+            if (activeMQService->publish(F("sensor-data"), jsonDoc, 1))
+            {
+                sentVersion = snapshot.getVersion();
+                // Updated in place, the channel set rarely changes
+                for (const auto &entry : snapshot.getValues())
+                {
+                    lastSentData[entry.first] = entry.second;
+                }
+
+                if (statsTelemetry)
+                {
+                    publishStats();
+                }
+            }
+        }
+    }
+}
+
+// One message per channel keeps each payload inside the MQTT packet limit
+void AppContext::publishStats()
+{
+    for (const auto &entry : dataCollector->getAllStats())
+    {
+        const ChannelStats &channelStats = entry.second;
+        JsonDocument jsonDoc;
+        jsonDoc[F("client-id")] = clientId;
+        jsonDoc[F("ch")] = entry.first;
+        jsonDoc[F("n")] = channelStats.size();
+        jsonDoc[F("window")] = channelStats.getWindow();
+        jsonDoc[F("min")] = channelStats.getMin();
+        jsonDoc[F("max")] = channelStats.getMax();
+        jsonDoc[F("mean")] = channelStats.getMean();
+        jsonDoc[F("var")] = channelStats.getVariance();
+        jsonDoc[F("slope")] = channelStats.getSlope();
+        activeMQService->publish(F("sensor-stats"), jsonDoc);
+    }
+}
+
+// One message per sensor, age is -1 until the first good sample
+void AppContext::publishHealth()
+{
+    unsigned long now = millis();
+    for (const auto &entry : dataCollector->getHealthReports())
+    {
+        const SensorHealth &health = *entry.second.health;
+        JsonDocument jsonDoc;
+        jsonDoc[F("client-id")] = clientId;
+        jsonDoc[F("sensor")] = entry.first.c_str();
+        jsonDoc[F("state")] = SensorHealth::stateName(health.state);
+        jsonDoc[F("failures")] = health.consecutiveFailures;
+        jsonDoc[F("total-failures")] = health.totalFailures;
+        jsonDoc[F("age")] = health.lastGoodAt ? (long)(now - health.lastGoodAt) : -1L;
+        jsonDoc[F("reason")] = health.reason;
+        jsonDoc[F("status")] = entry.second.status->c_str();
+        activeMQService->publish(F("sensor-health"), jsonDoc);
+    }
+}
+
+// Latency arrays are [p50, p90, max, samples] in ms, reconnect is
+// [last, max, count]; kept flat to stay inside one MQTT packet
+void AppContext::publishLinkHealth()
+{
+    const auto &rtt = activeMQService->getPingRtt();
+    const auto &ack = activeMQService->getAckLatency();
+    const auto &reconnects = activeMQService->getReconnectTimes();
+    JsonDocument jsonDoc;
+    jsonDoc[F("client-id")] = clientId;
+    JsonArray rttStats = jsonDoc[F("rtt")].to<JsonArray>();
+    rttStats.add(rtt.percentile(50));
+    rttStats.add(rtt.percentile(90));
+    rttStats.add(rtt.getMax());
+    rttStats.add(rtt.getTotal());
+    JsonArray ackStats = jsonDoc[F("ack")].to<JsonArray>();
+    ackStats.add(ack.percentile(50));
+    ackStats.add(ack.percentile(90));
+    ackStats.add(ack.getMax());
+    ackStats.add(ack.getTotal());
+    JsonArray reconnectStats = jsonDoc[F("reconnect")].to<JsonArray>();
+    reconnectStats.add(reconnects.getLast());
+    reconnectStats.add(reconnects.getMax());
+    reconnectStats.add(reconnects.getTotal());
+    jsonDoc[F("in")] = activeMQService->getBytesIn();
+    jsonDoc[F("out")] = activeMQService->getBytesOut();
+    jsonDoc[F("failures")] = activeMQService->getPublishFailures();
+    jsonDoc[F("keepalive")] = activeMQService->getKeepAlive();
+    jsonDoc[F("timeout")] = activeMQService->getResponseTimeout();
+    activeMQService->publish(F("link-health"), jsonDoc);
+}
+
+// One sample line, dropped whole when it does not fit
+static void appendMetric(TextBuffer &text, FlashString name, FlashString label, const char *labelValue, double value, uint8_t decimals)
+{
+    uint16_t mark = text.mark();
+    bool fits = text.append(name);
+    if (fits && label != nullptr)
+    {
+        fits = text.append('{') && text.append(label) && text.append(F("=\"")) && text.append(labelValue) && text.append(F("\"}"));
+    }
+    fits = fits && text.append(' ') && text.append(value, decimals) && text.append('\n');
+    if (!fits)
+    {
+        text.rollback(mark);
+    }
+}
+
+bool AppContext::renderSnapshot()
+{
+    uint16_t capacity;
+    char *buffer = webServerService->beginSnapshot(capacity);
+    if (buffer == nullptr)
+    {
+        return false;
+    }
+    unsigned long now = millis();
+
+    JsonDocument jsonDoc;
+    jsonDoc[F("client-id")] = clientId;
+    jsonDoc[F("uptime-ms")] = now;
+    JsonObject data = jsonDoc["data"].to<JsonObject>();
+    const TelemetrySnapshot &snapshot = dataCollector->getSnapshot();
+    jsonDoc[F("version")] = snapshot.getVersion();
+    jsonDoc[F("taken-at")] = snapshot.getTakenAt();
+    for (const auto &entry : snapshot.getValues())
+    {
+        data[entry.first.c_str()] = entry.second;
+    }
+    JsonObject health = jsonDoc["health"].to<JsonObject>();
+    for (const auto &entry : dataCollector->getHealthReports())
+    {
+        health[entry.first.c_str()] = SensorHealth::stateName(entry.second.health->state);
+    }
+    jsonDoc[F("last-pass-us")] = dataCollector->getLastPassUs();
+    jsonDoc[F("last-loop-us")] = lastLoopUs;
+
+    // Half the cache for JSON at most, the metrics text gets the rest
+    uint16_t jsonLength = 0;
+    if (measureJson(jsonDoc) < capacity / 2)
+    {
+        jsonLength = serializeJson(jsonDoc, buffer, capacity / 2);
+    }
+    uint16_t metricsOffset = jsonLength + 1;
+    TextBuffer text(buffer + metricsOffset, capacity - metricsOffset);
+
+    // No "# TYPE" lines, the cache is kept for samples: scrapers ingest
+    // them untyped and the _total suffix still marks the counters
+    for (const auto &entry : snapshot.getValues())
+    {
+        appendMetric(text, F("iomanager_sensor_value"), F("channel"), entry.first.c_str(), entry.second, 3);
+    }
+    // 0 ok, 1 degraded, 2 breaker open
+    for (const auto &entry : dataCollector->getHealthReports())
+    {
+        appendMetric(text, F("iomanager_sensor_health"), F("sensor"), entry.first.c_str(), entry.second.health->state, 0);
+    }
+    for (const auto &entry : dataCollector->getHealthReports())
+    {
+        appendMetric(text, F("iomanager_sensor_failures_total"), F("sensor"), entry.first.c_str(), entry.second.health->totalFailures, 0);
+    }
+    appendMetric(text, F("iomanager_sensor_pass_last_us"), nullptr, nullptr, dataCollector->getLastPassUs(), 0);
+    appendMetric(text, F("iomanager_sensor_pass_max_us"), nullptr, nullptr, dataCollector->getMaxPassUs(), 0);
+    appendMetric(text, F("iomanager_sensor_budget_us"), nullptr, nullptr, dataCollector->getBudget(), 0);
+    appendMetric(text, F("iomanager_sensor_overruns_total"), nullptr, nullptr, dataCollector->getOverruns(), 0);
+    appendMetric(text, F("iomanager_sensor_deferrals_total"), nullptr, nullptr, dataCollector->getDeferrals(), 0);
+    appendMetric(text, F("iomanager_loop_iterations_total"), nullptr, nullptr, loopIterations, 0);
+    appendMetric(text, F("iomanager_loop_last_us"), nullptr, nullptr, lastLoopUs, 0);
+    appendMetric(text, F("iomanager_loop_max_us"), nullptr, nullptr, maxLoopUs, 0);
+    appendMetric(text, F("iomanager_http_connections"), nullptr, nullptr, webServerService->getOpenConnections(), 0);
+    appendMetric(text, F("iomanager_snapshot_version"), nullptr, nullptr, snapshot.getVersion(), 0);
+    appendMetric(text, F("iomanager_log_dropped_total"), F("reason"), "ring", Logger::getDroppedLines(), 0);
+    appendMetric(text, F("iomanager_log_dropped_total"), F("reason"), "rate", Logger::getThrottledLines(), 0);
+    appendMetric(text, F("iomanager_esp_baud"), nullptr, nullptr, EspSerial.getBaud(), 0);
+    appendMetric(text, F("iomanager_esp_rx_overruns_total"), nullptr, nullptr, EspSerial.getOverruns(), 0);
+    appendMetric(text, F("iomanager_mqtt_inflight"), nullptr, nullptr, activeMQService->getInFlight(), 0);
+    appendMetric(text, F("iomanager_mqtt_retransmits_total"), nullptr, nullptr, activeMQService->getRetransmits(), 0);
+    appendMetric(text, F("iomanager_mqtt_expired_total"), nullptr, nullptr, activeMQService->getExpired(), 0);
+    // Least free SRAM between heap and stack since boot, 0 off the device
+    appendMetric(text, F("iomanager_sram_headroom_bytes"), nullptr, nullptr, sramHeadroom(), 0);
+    appendMetric(text, F("iomanager_uptime_seconds"), nullptr, nullptr, now / 1000, 0);
+
+    webServerService->commitSnapshot(jsonLength, metricsOffset, text.size());
+    return true;
+}
+
+// One message per period, every channel as [datapoints, min, max, average]
+// after the API's squashed sensor log. "start" is the Unix time of the
+// bucket once time-sync ran, before that "uptime-ms" and "boot" place it.
+bool AppContext::publishRollup(const TimeRollup &rollup)
+{
+    JsonDocument jsonDoc;
+    jsonDoc[F("client-id")] = clientId;
+    jsonDoc[F("interval")] = rollup.getInterval();
+    jsonDoc[F("seq")] = rollup.getSequence();
+    if (wallClock.isSynced())
+    {
+        jsonDoc[F("start")] = wallClock.at(rollup.getCompletedStart());
+    }
+    else
+    {
+        jsonDoc[F("uptime-ms")] = rollup.getCompletedStart();
+        jsonDoc[F("boot")] = bootId;
+    }
+    JsonObject channels = jsonDoc[F("channels")].to<JsonObject>();
+    for (const auto &entry : rollup.getCompleted())
+    {
+        const RollupBucket &bucket = entry.second;
+        // Two decimals keep the whole period within one QoS 1 slot
+        JsonArray values = channels[entry.first].to<JsonArray>();
+        values.add(bucket.count);
+        values.add(serialized(String(bucket.min, 2)));
+        values.add(serialized(String(bucket.max, 2)));
+        values.add(serialized(String(bucket.getMean(), 2)));
+    }
+    // QoS 1 only, a whole period does not fit PubSubClient's QoS 0 buffer
+    return activeMQService->publish(F("sensor-rollup"), jsonDoc, 1);
+}
+
+// Apply rule actions right away, reporting is best effort while offline
+void AppContext::handleAlertEvents()
+{
+    while (alertEngine->hasEvent())
+    {
+        AlertEvent event = alertEngine->getNextEvent();
+        const AlertRule &rule = alertEngine->getRule(event.slot);
+        String action = rule.action;
+
+        // An "-off" action also keeps the schedule from switching it back on
+        if (flashEquals(action, F("wp-off")))
+        {
+            scheduler->setInhibited(0, event.raised);
+        }
+        else if (flashEquals(action, F("ap-off")))
+        {
+            scheduler->setInhibited(1, event.raised);
+        }
+
+        if (event.raised)
+        {
+            if (flashEquals(action, F("wp-off")))
+            {
+                moduleManager->waterPump->setPower(false);
+            }
+            else if (flashEquals(action, F("ap-off")))
+            {
+                moduleManager->airPump->setPower(false);
+            }
+            else if (flashEquals(action, F("wp-on")))
+            {
+                moduleManager->waterPump->setPower(true);
+            }
+            else if (flashEquals(action, F("ap-on")))
+            {
+                moduleManager->airPump->setPower(true);
+            }
+        }
+
+        LOG_WARN("alert", "Slot %d %s: %s", event.slot, event.raised ? "raised" : "cleared",
+                 AlertEngineService::encodeRule(rule).c_str());
+
+        JsonDocument jsonDoc;
+        jsonDoc[F("client-id")] = clientId;
+        jsonDoc[F("slot")] = event.slot;
+        jsonDoc[F("ch")] = rule.channel;
+        jsonDoc[F("value")] = event.value;
+        jsonDoc[F("state")] = event.raised ? "raised" : "cleared";
+        jsonDoc[F("action")] = action;
+        if (!activeMQService->publish(F("alert"), jsonDoc, 1))
+        {
+            activeMQService->publish(F("alert"), jsonDoc);
         }
     }
-}
\ No newline at end of file
+}
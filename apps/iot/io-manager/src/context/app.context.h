@@ -9,7 +9,12 @@
 #include "services/wifi-manager/wifiManager.service.h"
 #include "services/webserver/webserver.service.h"
 #include "services/activeMQ-client/activeMQ-client.service.h"
+#include "services/alert-engine/alertEngine.service.h"
+#include "services/scheduler/scheduler.service.h"
+#include "services/broker-resolver/brokerResolver.service.h"
 #include "utility/timer.util.h"
+#include "utility/textBuffer.util.h"
+#include "utility/wallClock.util.h"
 #include "abstract/singleton.h"
 #include "abstract/uniquePointer.h" // Include the custom UniquePtr implementation
 
@@ -24,14 +29,45 @@ public:
     DiskManagerService *diskManager;
     WiFiService *wifiService;
     WebServerService *webServerService;
+    AlertEngineService *alertEngine;
+    SchedulerService *scheduler;
+    BrokerResolverService *brokerResolver;
     Timer sensorPollTimer;
     Timer lcdUpdateTimer;
     Timer dataSendTimer;
     Timer eventHandleTimer;
+    Timer linkHealthTimer;
     String ssid, password, brokerAddress, clientId;
     void initialize();
+    void subscribeTopics();
     void handleEvents();
     void loop();
+    void publishStats();
+    void publishHealth();
+    void publishLinkHealth();
+    bool publishRollup(const TimeRollup &rollup);
+    void handleAlertEvents();
+    // Renders /api/snapshot and /metrics into the web server cache, false
+    // while a scrape still streams the previous rendering
+    bool renderSnapshot();
+    // Snapshot versions already rendered for HTTP and sent as sensor-data
+    uint32_t renderedVersion = 0;
+    uint32_t sentVersion = 0;
+    // Main loop timing, measured start to start
+    unsigned long loopIterations = 0;
+    unsigned long lastLoopUs = 0;
+    unsigned long maxLoopUs = 0;
+    unsigned long loopStartedAt = 0;
+    bool statsTelemetry = false;
+    // Topics subscribed and the broker client set up, at boot or once WiFi joins
+    bool mqttStarted = false;
+    // "raw" (default), "rollup" (raw + rollups) or "rollup-only" (rollups + raw on excursion)
+    String telemetryMode = "raw";
+    TelemetrySnapshot::Values lastSentData;
+    // Set by time-sync, rollup buckets carry Unix time once it is
+    WallClock wallClock;
+    // Counts boots, tells uptime stamps of different runs apart before a sync
+    uint16_t bootId = 0;
 private:
     AppContext();
     ~AppContext();
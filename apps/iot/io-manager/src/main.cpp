@@ -1,16 +1,16 @@
 #include "context/app.context.h"
-auto dr = new DataCollector();
+#include "utility/sramHeadroom.util.h"
 
 void setup()
 {
+    // Before anything allocates, for the SRAM headroom metric
+    sramPaint();
     Serial.begin(115200);
     // initialize
     Wire.begin();
     AppContext &context = AppContext::getInstance();
     context.initialize();
     // context.initialize();
-
-    // dr->initializeSensors();
 }
 
 boolean once = false;
@@ -19,6 +19,4 @@ void loop()
     AppContext &context = AppContext::getInstance();
     context.loop();
     // Serial.println("Looping...");
-    // auto data = dr->collectData();
-    // delay(1000);
 }
@@ -1,4 +1,5 @@
 #include "air-pump.module.h"
+#include "utility/logger.util.h"
 #include <Arduino.h>
 
 AirPumpModule::AirPumpModule(SingleRelay *relay) : relay(relay)
@@ -11,7 +12,7 @@ AirPumpModule::~AirPumpModule()
 
 void AirPumpModule::initialize()
 {
-    Serial.println("Initializing Air Pump Module...");
+    LOG_INFO("air-pump", "Initializing");
 
     relay->initialize();
 }
@@ -34,8 +35,7 @@ const char *AirPumpModule::getStatus()
 void AirPumpModule::setPower(bool power)
 {
     // print state
-    Serial.print("Setting pump power to: ");
-    Serial.println(power ? "On" : "Off");
+    LOG_INFO("air-pump", "Power %s", power ? "on" : "off");
     powerState = power;
     relay->setPower(power);
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "lcd.module.h"
+#include "utility/logger.util.h"
 #include <queue>
 #include <string>
+#include "utility/flashString.util.h"
 
 // Constructor
 LCDModule::LCDModule(DataCollector *dataCollector, WiFiService *wifiService, ActiveMQClientService *mqttService)
@@ -18,11 +20,11 @@ LCDModule::~LCDModule()
 // Initialize the LCD module
 void LCDModule::initialize()
 {
-    Serial.println("Initializing LCD Module...");
+    LOG_INFO("lcd", "Initializing");
     screen->init();
 
     screen->setCursor(0, 0);
-    screen->send_string("AutoHarvest v0.111");
+    sendFlash(F("AutoHarvest v0.111"));
     screen->send_string(status.c_str());
     screen->blink();
 
@@ -45,7 +47,7 @@ void LCDModule::processMessageQueue()
             messageQueue.pop();
 
             screen->setCursor(0, 0);
-            screen->send_string("                "); // Clear the line
+            sendFlash(F("                ")); // Clear the line
             screen->send_string(message.c_str());
 
             // Add a delay before removing the last message
@@ -111,6 +113,12 @@ void LCDModule::displayPage(int pageIndex)
     case 6: // Service statuses
         displayServiceStatus();
         break;
+    case 7: // Rolling pH statistics
+        displayTrends();
+        break;
+    case 8: // MQTT link health
+        displayLinkHealth();
+        break;
     }
 }
 
@@ -118,7 +126,7 @@ void LCDModule::displayPage(int pageIndex)
 void LCDModule::displaySystemInfo()
 {
     screen->setCursor(0, 0);
-    screen->send_string(" AutoHarvest   "); // 16 chars max
+    sendFlash(F(" AutoHarvest   ")); // 16 chars max
 
     screen->setCursor(0, 1);
     String wifiStatus = getWiFiStatus();
@@ -128,41 +136,41 @@ void LCDModule::displaySystemInfo()
 // Page 1: Water Quality (pH + TDS)
 void LCDModule::displayWaterQuality()
 {
-    auto data = dataCollector->currentData;
+    const TelemetrySnapshot &data = dataCollector->getSnapshot();
 
     screen->setCursor(0, 0);
-    String phLine = "pH:" + String(data["ph"], 2); // Compact format
+    String phLine = "pH:" + String(data.get("ph"), 2); // Compact format
     screen->send_string(phLine.c_str());
 
     screen->setCursor(0, 1);
-    String tdsLine = "TDS:" + String(data["tds"], 0) + "ppm"; // Compact format
+    String tdsLine = "TDS:" + String(data.get("tds"), 0) + "ppm"; // Compact format
     screen->send_string(tdsLine.c_str());
 }
 
 // Page 2: Temperature & Humidity
 void LCDModule::displayTemperatureHumidity()
 {
-    auto data = dataCollector->currentData;
+    const TelemetrySnapshot &data = dataCollector->getSnapshot();
 
     screen->setCursor(0, 0);
-    String tempLine = "Temp:" + String(data["t"], 1) + "C"; // Compact format
+    String tempLine = "Temp:" + String(data.get("t"), 1) + "C"; // Compact format
     screen->send_string(tempLine.c_str());
 
     screen->setCursor(0, 1);
-    String humLine = "Humid:" + String(data["h"], 0) + "%"; // Compact format
+    String humLine = "Humid:" + String(data.get("h"), 0) + "%"; // Compact format
     screen->send_string(humLine.c_str());
 }
 
 // Page 3: Flow Data
 void LCDModule::displayFlowData()
 {
-    auto data = dataCollector->currentData;
+    const TelemetrySnapshot &data = dataCollector->getSnapshot();
 
     screen->setCursor(0, 0);
-    screen->send_string("Water Flow      ");
+    sendFlash(F("Water Flow      "));
 
     screen->setCursor(0, 1);
-    String litersLine = String(data["lpm"], 2) + " L/min";
+    String litersLine = String(data.get("lpm"), 2) + " L/min";
     String centeredLine = centerText(litersLine, 16);
     screen->send_string(centeredLine.c_str());
 }
@@ -171,7 +179,7 @@ void LCDModule::displayFlowData()
 void LCDModule::displayUptime()
 {
     screen->setCursor(0, 0);
-    screen->send_string("Uptime");
+    sendFlash(F("Uptime"));
 
     screen->setCursor(0, 1);
     unsigned long uptimeMillis = millis() - uptimeStartMillis;
@@ -201,9 +209,9 @@ void LCDModule::displayDateTime()
     }
     else
     {
-        screen->send_string("Time Not Synced ");
+        sendFlash(F("Time Not Synced "));
         screen->setCursor(0, 1);
-        screen->send_string("Waiting...      ");
+        sendFlash(F("Waiting...      "));
     }
 }
 
@@ -218,11 +226,12 @@ void LCDModule::setTime(const String &time, const String &date)
 // Helper: Get WiFi connection status
 String LCDModule::getWiFiStatus()
 {
-    if (WiFi.status() == WL_CONNECTED)
+    // No AT status query while the broker socket is in passthrough
+    if (EspSerial.isPassthrough() || WiFi.status() == WL_CONNECTED)
     {
         return "WiFi:Connected  "; // 16 chars
     }
-    else if (wifiService->mode == "ap")
+    else if (flashEquals(wifiService->mode, F("ap")))
     {
         return "WiFi: AP Mode   "; // 16 chars
     }
@@ -284,14 +293,14 @@ void LCDModule::displayServiceStatus()
     String sensorStat = dataCollector->getStatus();
 
     // Abbreviate status names for compact display
-    if (wifiStat == "Connected") wifiStat = "Conn";
-    else if (wifiStat == "Connecting") wifiStat = "Conn...";
-    else if (wifiStat == "Disconnected") wifiStat = "Disc";
-    else if (wifiStat == "AP Mode") wifiStat = "AP";
-    else if (wifiStat == "Ready") wifiStat = "Rdy";
+    if (flashEquals(wifiStat, F("Connected"))) wifiStat = "Conn";
+    else if (flashEquals(wifiStat, F("Connecting"))) wifiStat = "Conn...";
+    else if (flashEquals(wifiStat, F("Disconnected"))) wifiStat = "Disc";
+    else if (flashEquals(wifiStat, F("AP Mode"))) wifiStat = "AP";
+    else if (flashEquals(wifiStat, F("Ready"))) wifiStat = "Rdy";
 
-    if (sensorStat == "Active") sensorStat = "Act";
-    else if (sensorStat == "Initializing") sensorStat = "Init";
+    if (flashEquals(sensorStat, F("Active"))) sensorStat = "Act";
+    else if (flashEquals(sensorStat, F("Initializing"))) sensorStat = "Init";
 
     String line1 = "W:" + wifiStat + " S:" + sensorStat;
     screen->send_string(line1.c_str());
@@ -300,3 +309,63 @@ void LCDModule::displayServiceStatus()
 
  
 }
+
+// Page 8: pH rolling mean and range over the stats window
+void LCDModule::displayTrends()
+{
+    const ChannelStats *ph = dataCollector->getStats("ph");
+
+    screen->setCursor(0, 0);
+    if (ph == nullptr || ph->size() == 0)
+    {
+        sendFlash(F("pH trend        "));
+        screen->setCursor(0, 1);
+        sendFlash(F("Collecting...   "));
+        return;
+    }
+
+    String meanLine = "pH avg:" + String(ph->getMean(), 2) + (ph->getSlope() > 0 ? " +" : " -");
+    screen->send_string(meanLine.c_str());
+
+    screen->setCursor(0, 1);
+    String rangeLine = String(ph->getMin(), 2) + "-" + String(ph->getMax(), 2);
+    screen->send_string(centerText(rangeLine, 16).c_str());
+}
+
+// Page 9: median ping round trip while up, time since the loss while down,
+// p90 ping and PUBACK latency below
+void LCDModule::displayLinkHealth()
+{
+    screen->setCursor(0, 0);
+    if (mqttService == nullptr)
+    {
+        sendFlash(F("MQTT link       "));
+        screen->setCursor(0, 1);
+        sendFlash(F("Not started     "));
+        return;
+    }
+
+    char line[17];
+    unsigned long downFor = mqttService->getDownFor();
+    if (downFor > 0 || !mqttService->isConnected())
+    {
+        snprintf_P(line, sizeof(line), PSTR("MQTT down %lus"), downFor / 1000);
+    }
+    else
+    {
+        snprintf_P(line, sizeof(line), PSTR("MQTT rtt %ums"), mqttService->getPingRtt().percentile(50));
+    }
+    screen->send_string(line);
+
+    screen->setCursor(0, 1);
+    snprintf_P(line, sizeof(line), PSTR("p90 %u ack %u"), mqttService->getPingRtt().percentile(90),
+               mqttService->getAckLatency().percentile(90));
+    screen->send_string(line);
+}
+
+void LCDModule::sendFlash(FlashString text)
+{
+    char line[41]; // One DDRAM row, the visible part is 16 characters
+    flashCopy(line, sizeof(line), text);
+    screen->send_string(line);
+}
@@ -31,6 +31,8 @@ public:
     void displayDeviceStatus();         // Page 5: Device status
     void displayDateTime();             // Page 6: Date and Time
     void displayServiceStatus();        // Page 7: Service statuses
+    void displayTrends();               // Page 8: pH rolling mean/range
+    void displayLinkHealth();           // Page 9: MQTT round trip / reconnect
 
     void setPower(bool power);
     const char *getType();
@@ -58,9 +60,11 @@ private:
     String currentTime = "--:--:--";
     String currentDate = "--/--/----";
 
-    int getPageCount() const { return 7; } // 7 pages in carousel
+    int getPageCount() const { return 9; } // 9 pages in carousel
     String getWiFiStatus();
     String centerText(String text, int width);
+    // Writes a flash string at the cursor without a RAM copy of the literal
+    void sendFlash(FlashString text);
 };
 
 #endif // LCD_MODULE_H
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "pump.module.h"
+#include "utility/logger.util.h"
 #include <Arduino.h>
 
 PumpModule::PumpModule(SingleRelay *relay) : relay(relay)
@@ -11,7 +12,7 @@ PumpModule::~PumpModule()
 
 void PumpModule::initialize()
 {
-    Serial.println("Initializing Water Pump Module...");
+    LOG_INFO("pump", "Initializing");
 
     relay->initialize();
 }
@@ -34,8 +35,7 @@ const char *PumpModule::getStatus()
 void PumpModule::setPower(bool power)
 {
     // print state
-    Serial.print("Setting pump power to: ");
-    Serial.println(power ? "On" : "Off");
+    LOG_INFO("pump", "Power %s", power ? "on" : "off");
     powerState = power;
     relay->setPower(power);
 }
\ No newline at end of file
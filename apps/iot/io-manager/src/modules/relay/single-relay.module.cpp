@@ -1,4 +1,5 @@
 #include "single-relay.module.h"
+#include "utility/logger.util.h"
 
 // Constructor
 SingleRelay::SingleRelay(uint8_t relayPin) : relayPin(relayPin), powerState(false)
@@ -14,8 +15,7 @@ SingleRelay::~SingleRelay()
 // Initialize the relay pin as output
 void SingleRelay::initialize()
 {
-    Serial.print("Initializing Single Relay on pin: ");
-    Serial.println(relayPin);
+    LOG_INFO("relay", "Initializing on pin %d", relayPin);
     pinMode(relayPin, OUTPUT);
     digitalWrite(relayPin, HIGH); // Initially turn off the relay
 }
@@ -1,4 +1,5 @@
 #include "wifi.module.h"
+#include "services/esp-link/espLink.service.h"
 
 WiFiModule::WiFiModule() : status("Initializing...")
 {
@@ -40,6 +41,7 @@ void WiFiModule::setPower(bool power)
     else
     {
         // Turn off the WiFi module
+        EspSerial.endPassthrough();
         WiFi.disconnect();
         status = "WiFi Module is OFF";
     }
@@ -1,38 +1,200 @@
 #include "humidity.sensor.h"
+#include "utility/logger.util.h"
+#include "sensors/sensors.config.h"
 
-DHT11Sensor::DHT11Sensor(uint8_t pin) : pin(pin), dht(pin, DHT11)
+// The PCINT group and Timer0 compare B have a single owner, bound through this trampoline
+typedef IsrTrampoline<DHT11_PIN, DHT11Sensor> DhtTrampoline;
+
+DHT11Sensor::DHT11Sensor(uint8_t pin, IsrBinding isr)
+    : AbstractSensor(5000, 1000, 200, 1), pin(pin), isr(isr), bound(false), inputRegister(nullptr), bitMask(0),
+      pcmsk(nullptr), pcmskBit(0), phase(Idle), startTicks(0), edgeCount(0), startedAt(0), retried(false)
 {
 }
 
 void DHT11Sensor::initialize()
 {
-    Serial.println("Initializing DHT11 Sensor...");
-    dht.begin();
+    LOG_INFO("dht11", "Initializing");
+    pinMode(pin, INPUT_PULLUP);
+
+    if (digitalPinToPCICR(pin) == 0 || isr.handler != DhtTrampoline::handle)
+    {
+        LOG_ERROR("dht11", "Pin %d has no pin change interrupt", pin);
+        setStatus("No PCINT");
+        return;
+    }
+    if (!isr.bind(this))
+    {
+        LOG_ERROR("dht11", "Interrupt already owned by another sensor");
+        setStatus("Interrupt in use");
+        return;
+    }
+    bound = true;
+
+    inputRegister = portInputRegister(digitalPinToPort(pin));
+    bitMask = digitalPinToBitMask(pin);
+    pcmsk = digitalPinToPCMSK(pin);
+    pcmskBit = bit(digitalPinToPCMSKbit(pin));
+    // The group stays enabled, the pin itself is unmasked only while receiving
+    *digitalPinToPCICR(pin) |= bit(digitalPinToPCICRbit(pin));
+    // First frame is ready by the first readData()
+    startRead();
 }
 
 DHT11Sensor::~DHT11Sensor()
 {
-    // Destructor implementation (if needed)
+    if (bound)
+    {
+        abortRead();
+        isr.unbind(this);
+    }
 }
 
 std::map<std::string, double> DHT11Sensor::readData()
 {
     std::map<std::string, double> data;
-    float temperature = dht.readTemperature();
-    float humidity = dht.readHumidity();
-
-    // Check if any reads failed and return empty map if so
-    if (isnan(temperature) || isnan(humidity))
+    if (!bound)
     {
-        Serial.println("Failed to read from DHT sensor!");
         return data;
     }
+    unsigned long now = millis();
+
+    if (phase == StartPulse || phase == Receiving)
+    {
+        // Still on the wire (the first pass after boot comes early): no
+        // verdict, come back once the frame had time to finish
+        if (now - startedAt <= responseTimeoutMs)
+        {
+            sampling.resumeAfter(now, responseTimeoutMs - (now - startedAt) + 1);
+            return data;
+        }
+        setStatus("No response");
+        abortRead();
+    }
+    else if (phase == Done)
+    {
+        float temperature, humidity;
+        phase = Idle;
+        if (decodeFrame(edges, temperature, humidity))
+        {
+            data["t"] = temperature;
+            data["h"] = humidity;
+            setStatus("OK");
+            retried = false;
+            startRead();
+            return data;
+        }
+        setStatus("Bad frame");
+    }
 
-    data["t"] = temperature;
-    data["h"] = humidity;
+    // A failed frame is retried right away instead of an interval later,
+    // only a second failure in a row is reported
+    startRead();
+    if (!retried)
+    {
+        retried = true;
+        sampling.resumeAfter(now, responseTimeoutMs + 1);
+        return data;
+    }
+    retried = false;
     return data;
 }
 
+// Pull the line low, the timer tick releases it after the start pulse
+void DHT11Sensor::startRead()
+{
+    pinMode(pin, OUTPUT);
+    digitalWrite(pin, LOW);
+    startedAt = millis();
+    startTicks = 0;
+    edgeCount = 0;
+    phase = StartPulse;
+    setStartTimer(true);
+}
+
+void DHT11Sensor::abortRead()
+{
+    noInterrupts();
+    setStartTimer(false);
+    *pcmsk &= ~pcmskBit;
+    phase = Idle;
+    interrupts();
+    pinMode(pin, INPUT_PULLUP);
+}
+
+void DHT11Sensor::onTimerTick()
+{
+    if (phase != StartPulse || ++startTicks < startPulseTicks)
+    {
+        return;
+    }
+    setStartTimer(false);
+    phase = Receiving;
+    // Releasing the line is a rising edge, onInterrupt() ignores it
+    pinMode(pin, INPUT_PULLUP);
+    *pcmsk |= pcmskBit;
+}
+
+// Compare B fires once per Timer0 overflow period (1.024 ms) without
+// touching millis(), which runs from the overflow interrupt.
+void DHT11Sensor::setStartTimer(bool enabled)
+{
+#if defined(TIMER0_COMPB_vect)
+    if (enabled)
+    {
+        TIFR0 = bit(OCF0B);
+        TIMSK0 |= bit(OCIE0B);
+    }
+    else
+    {
+        TIMSK0 &= ~bit(OCIE0B);
+    }
+#endif
+}
+
+// edges[0] starts the 80 us low + 80 us high response, every following
+// falling edge closes a bit: 50 us low + 26-28 us high (0) or 70 us high (1).
+bool DHT11Sensor::decodeFrame(const volatile uint32_t *edges, float &temperature, float &humidity)
+{
+    uint32_t response = edges[1] - edges[0];
+    if (response < 120 || response > 200)
+    {
+        return false;
+    }
+
+    uint8_t bytes[5] = {0, 0, 0, 0, 0};
+    for (uint8_t i = 0; i < 40; i++)
+    {
+        uint32_t period = edges[i + 2] - edges[i + 1];
+        if (period < 60 || period > 160)
+        {
+            return false;
+        }
+        bytes[i / 8] = (bytes[i / 8] << 1) | (period > 100 ? 1 : 0);
+    }
+
+    if ((uint8_t)(bytes[0] + bytes[1] + bytes[2] + bytes[3]) != bytes[4])
+    {
+        return false;
+    }
+
+    humidity = bytes[0] + bytes[1] * 0.1f;
+    temperature = bytes[2] + (bytes[3] & 0x7F) * 0.1f;
+    if (bytes[3] & 0x80)
+    {
+        temperature = -temperature;
+    }
+    return true;
+}
+
+bool DHT11Sensor::isPlausible(const std::string &channel, double value) const
+{
+    if (channel == "h")
+    {
+        return value >= 0.0 && value <= 100.0;
+    }
+    return value > -20.0 && value < 60.0;
+}
+
 const char *DHT11Sensor::getType()
 {
     return "DHT11";
@@ -41,4 +203,20 @@ const char *DHT11Sensor::getType()
 const char *DHT11Sensor::getSensorName()
 {
     return "DHT11";
-}
\ No newline at end of file
+}
+
+#if SENSOR_DHT11 && defined(TIMER0_COMPB_vect) && defined(DHT11_PCINT_VECT)
+ISR(DHT11_PCINT_VECT)
+{
+    DhtTrampoline::handle();
+}
+
+ISR(TIMER0_COMPB_vect)
+{
+    DHT11Sensor *sensor = DhtTrampoline::get();
+    if (sensor != nullptr)
+    {
+        sensor->onTimerTick();
+    }
+}
+#endif
@@ -1,22 +1,82 @@
 #ifndef DHT11_SENSOR_H
 #define DHT11_SENSOR_H
 
+#include <Arduino.h>
 #include "sensor.abstract.class.h"
-#include <DHT.h>
+#include "abstract/isrTrampoline.h"
 
-class DHT11Sensor : public AbstractSensor
+// Falling edges in one frame: response start, then one per bit boundary
+#define DHT11_FRAME_EDGES 42
+
+// Interrupt driven DHT11 driver. The 18 ms start pulse is ended from a
+// Timer0 compare tick and the response is timed edge by edge from a pin
+// change interrupt, so the loop never waits and interrupts stay enabled.
+// readData() returns the frame captured since the previous call (one
+// sampling interval old) and starts the next one. A frame still in flight
+// or a failed one makes the collector call back within the same interval.
+class DHT11Sensor final : public AbstractSensor<DHT11Sensor>
 {
 public:
-    DHT11Sensor(uint8_t pin);
+    DHT11Sensor(uint8_t pin, IsrBinding isr);
     ~DHT11Sensor();
-    void initialize() override;
-    std::map<std::string, double> readData() override;
-    const char *getType() override;
-    const char *getSensorName() override;
+    void initialize();
+    std::map<std::string, double> readData();
+    const char *getType();
+    const char *getSensorName();
+    bool isPlausible(const std::string &channel, double value) const;
+
+    // Pin change interrupt: timestamps the falling edges of the response
+    void onInterrupt()
+    {
+        if (phase != Receiving || (*inputRegister & bitMask))
+        {
+            return;
+        }
+        edges[edgeCount] = micros();
+        if (++edgeCount == DHT11_FRAME_EDGES)
+        {
+            *pcmsk &= ~pcmskBit;
+            phase = Done;
+        }
+    }
+
+    // Timer0 compare B, every 1.024 ms while the start pulse is held
+    void onTimerTick();
+
+    // Turns edge timestamps into readings, false on timing or checksum error
+    static bool decodeFrame(const volatile uint32_t *edges, float &temperature, float &humidity);
 
 private:
+    enum Phase : uint8_t
+    {
+        Idle,
+        StartPulse,
+        Receiving,
+        Done
+    };
+
+    static const uint8_t startPulseTicks = 20;           // >= 18 ms low
+    static const unsigned long responseTimeoutMs = 100;  // Start pulse + 5 ms frame
+
     uint8_t pin;
-    DHT dht;
+    IsrBinding isr;
+    bool bound;
+
+    volatile uint8_t *inputRegister;
+    uint8_t bitMask;
+    volatile uint8_t *pcmsk;
+    uint8_t pcmskBit;
+
+    volatile Phase phase;
+    volatile uint8_t startTicks;
+    volatile uint8_t edgeCount;
+    volatile uint32_t edges[DHT11_FRAME_EDGES];
+    unsigned long startedAt;
+    bool retried; // The current frame is the retry of a failed one
+
+    void startRead();
+    void abortRead();
+    void setStartTimer(bool enabled);
 };
 
-#endif // DHT11_SENSOR_H
\ No newline at end of file
+#endif // DHT11_SENSOR_H
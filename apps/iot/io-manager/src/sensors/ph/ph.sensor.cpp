@@ -1,70 +1,98 @@
 #include "ph.sensor.h"
+#include "utility/logger.util.h"
 #include <Arduino.h> // Required for analogRead and millis functions
 #define PHADDR 0x00
 float neutralVoltage = 1950.0;
 float acidVoltage = 1615.0;
-// Constructor
+// Constructor. One read sums 50 ADC samples, taken samplesPerStep at a
+// time on consecutive passes (about a second) instead of 50 x 10 ms at once.
 PHSensor::PHSensor(int phPin, WaterTemperatureSensor &tempSensor)
-    : pin(phPin), temperature(25.0), voltage(0), phValue(0), tempSensor(tempSensor) {}
+    : AbstractSensor(5000, 1000, 1000, 1), pin(phPin), temperature(25.0), voltage(0), phValue(0), rawSum(0), hasRaw(false),
+      partialSum(0), collected(0), tempSensor(tempSensor)
+{
+    // 50 summed ADC samples never repeat exactly unless the input is railed
+    health.stuckLimit = 30;
+}
 
-// Read the voltage and calculate the pH value
+// Blocking read of all samples, for callers outside the sensor pass
 float PHSensor::readPH()
 {
-    // Take multiple samples and average them
-    const int numSamples = 50;
-    float totalVoltage = 0;
+    while (!sampleStep())
+    {
+        delay(10);
+    }
+    return phValue;
+}
 
-    for (int i = 0; i < numSamples; i++)
+// Adds the next samplesPerStep samples, true once the sum is complete and
+// phValue is updated
+bool PHSensor::sampleStep()
+{
+    for (uint8_t i = 0; i < samplesPerStep && collected < sampleCount; i++)
     {
-        totalVoltage += analogRead(pin);
-        delay(10); // Small delay to allow for stable readings
+        partialSum += analogRead(pin);
+        collected++;
     }
+    if (collected < sampleCount)
+    {
+        return false;
+    }
+    uint16_t total = partialSum;
+    partialSum = 0;
+    collected = 0;
 
-    // Convert averaged ADC value to millivolts
-    voltage = (totalVoltage / numSamples) / 1023.0 * 5000.0;
-    // Read the analog voltage
+    // Reported alongside, the conversion does not depend on it
     temperature = tempSensor.lastTemperature;
 
-    // Adjust slope based on temperature (Nernst equation)
-
-    float k = 0.33; // sensitivity factor
-    float tempSlope = (59.16 + 0.1984 * (temperature - 25.0)) * k; // mV adjustment for given temperature
-
-    float slope = (7.0 - 4.0) / ((neutralVoltage - 1500.0) / tempSlope - (acidVoltage - 1500.0) / tempSlope);
-    float intercept = 7.0 - slope * (neutralVoltage - 1500.0) / (tempSlope);
-
-    // Calculate pH
-    float rawPh = slope * ((voltage - 1500.0) / tempSlope) + intercept; // y = mx + b
-
-    // Debugging information
+    // Only recompute when the reading changed
+    bool inputChanged = !hasRaw || total != rawSum;
+    rawSum = total;
+    hasRaw = true;
+    if (inputChanged)
+    {
+        convert();
+    }
+    return true;
+}
 
-    // Serial.print("Temperature: ");
-    // Serial.println(temperature);
-    // Serial.print("Slope: ");
-    // Serial.println(slope);
-    // Serial.print("Intercept: ");
-    // Serial.println(intercept);
-    // Serial.print("pH Value: ");
-    // Serial.println(phValue);
+// Calculate pH from the cached ADC sum. The calibration coefficients are
+// only rebuilt when the calibration changed, the per sample conversion is
+// integer math.
+void PHSensor::convert()
+{
+    if (!kernel.isValid())
+    {
+        kernel.configure(neutralVoltage, acidVoltage, sampleCount);
+    }
+    phValue = kernel.convert(rawSum);
+}
 
-    return rawPh;
+// Two point calibration voltages (mV at pH 7 and pH 4)
+void PHSensor::setCalibration(float neutralMv, float acidMv)
+{
+    neutralVoltage = neutralMv;
+    acidVoltage = acidMv;
+    kernel.configure(neutralVoltage, acidVoltage, sampleCount);
+    if (hasRaw)
+    {
+        phValue = kernel.convert(rawSum);
+    }
 }
 
 // Perform pH sensor calibration
 void PHSensor::calibrate(const char *cmd)
 {
     voltage = analogRead(pin) / 1024.0 * 5000;
-    Serial.print("Voltage: ");
-    Serial.println(voltage);
+    LOG_INFO("ph", "Calibration voltage %ld mV", (long)voltage);
 }
 
-// Set the temperature for compensation
+// Set the water temperature reported with the reading
 void PHSensor::setTemperature(float temp)
 {
     temperature = temp;
 }
 
-// Get the temperature used for compensation
+// Get the water temperature at the last reading
 float PHSensor::getTemperature() const
 {
     return temperature;
@@ -73,7 +101,7 @@ float PHSensor::getTemperature() const
 // Get the last voltage value
 float PHSensor::getVoltage() const
 {
-    return voltage;
+    return hasRaw ? rawSum / (float)sampleCount / 1023.0 * 5000.0 : voltage;
 }
 
 // Get the last pH value
@@ -91,10 +119,20 @@ void PHSensor::initialize()
 std::map<std::string, double> PHSensor::readData()
 {
     std::map<std::string, double> data;
-    data["ph"] = readPH();
+    if (!sampleStep())
+    {
+        sampling.resumeAfter(millis(), 0); // Next pass
+        return data;
+    }
+    data["ph"] = phValue;
     return data;
 }
 
+bool PHSensor::isPlausible(const std::string &channel, double value) const
+{
+    return value >= 0.0 && value <= 14.0;
+}
+
 // Implement the getType method
 const char *PHSensor::getType()
 {
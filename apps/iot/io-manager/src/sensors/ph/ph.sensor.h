@@ -2,15 +2,27 @@
 #define PH_SENSOR_H
 #include "sensors/water-temperature/waterTemperature.sensor.h"
 #include "sensor.abstract.class.h"
+#include "utility/sensorKernels.util.h"
 
-class PHSensor : public AbstractSensor
+class PHSensor final : public AbstractSensor<PHSensor>
 {
 private:
     int pin;           // Analog pin for the pH sensor
-    float temperature; // Temperature value for compensation
+    float temperature; // Water temperature at the last reading
     float voltage;     // Voltage value read from the sensor
     float phValue;     // Calculated pH value
+    uint16_t rawSum;   // Sum of the last complete set of samples
+    bool hasRaw;
+    uint16_t partialSum; // Set being collected
+    uint8_t collected;
     WaterTemperatureSensor &tempSensor;
+    PhKernel kernel;   // Coefficients for the current calibration
+
+    static const int sampleCount = 50;
+    static const uint8_t samplesPerStep = 5;
+
+    void convert();
+    bool sampleStep();
 
 public:
     // Constructor to initialize the pin and default temperature
@@ -25,10 +37,13 @@ public:
     // Perform pH sensor calibration
     void calibrate(const char *cmd);
 
-    // Set the temperature for compensation
+    // Replace the two point calibration (mV at pH 7 and pH 4)
+    void setCalibration(float neutralMv, float acidMv);
+
+    // Set the water temperature reported with the reading
     void setTemperature(float temp);
 
-    // Get the temperature used for compensation
+    // Get the water temperature at the last reading
     float getTemperature() const;
 
     // Get the last voltage value
@@ -38,16 +53,19 @@ public:
     float getPHValue() const;
 
     // Implement the initialize method
-    void initialize() override;
+    void initialize();
 
     // Implement the readData method
-    std::map<std::string, double> readData() override;
+    std::map<std::string, double> readData();
 
     // Implement the getType method
-    const char *getType() override;
+    const char *getType();
 
     // Implement the getSensorName method
-    const char *getSensorName() override;
+    const char *getSensorName();
+
+    // pH outside 0..14 means a floating or shorted probe
+    bool isPlausible(const std::string &channel, double value) const;
 };
 
 #endif // PH_SENSOR_H
@@ -0,0 +1,120 @@
+#ifndef SENSORS_CONFIG_H
+#define SENSORS_CONFIG_H
+
+// Hardware build: which sensors are wired up and where. Disabled sensors
+// are compiled out entirely (no object, no code, no library pulled in).
+// Builds for other boards override these from build_flags, e.g.
+// -DSENSOR_DHT11=0
+#ifndef SENSOR_WATER_TEMPERATURE
+#define SENSOR_WATER_TEMPERATURE 1
+#endif
+#ifndef SENSOR_DHT11
+#define SENSOR_DHT11 1
+#endif
+#ifndef SENSOR_WATER_LEVEL
+#define SENSOR_WATER_LEVEL 1
+#endif
+#ifndef SENSOR_TDS
+#define SENSOR_TDS 1
+#endif
+#ifndef SENSOR_PH
+#define SENSOR_PH 1
+#endif
+#ifndef SENSOR_WATER_FLOW
+#define SENSOR_WATER_FLOW 1
+#endif
+
+#define WATER_TEMPERATURE_PIN 17 // DS18B20 OneWire bus
+// The DHT11 response is timed with a pin change interrupt, so the data line
+// must sit on a PCINT pin (10-13, 50-53, A8-A15) and DHT11_PCINT_VECT must
+// name its group: PCINT0_vect (10-13, 50-53), PCINT2_vect (A8-A15).
+#define DHT11_PIN A8
+#define DHT11_PCINT_VECT PCINT2_vect
+#define WATER_LEVEL_LOW_PIN 14
+#define WATER_LEVEL_HIGH_PIN 15
+#define TDS_PIN A7
+#define PH_PIN A6
+// Pin 48 is ICP5: pulses are timestamped by Timer5 input capture. Any other
+// external interrupt pin (e.g. 2) falls back to micros() timestamps.
+#define FLOW_SENSOR_PIN 48
+
+#if (SENSOR_TDS || SENSOR_PH) && !SENSOR_WATER_TEMPERATURE
+#error "TDS temperature compensation and the pH temperature readout need SENSOR_WATER_TEMPERATURE"
+#endif
+
+#if SENSOR_WATER_TEMPERATURE
+#include "sensors/water-temperature/waterTemperature.sensor.h"
+#endif
+#if SENSOR_DHT11
+#include "sensors/humidity/humidity.sensor.h"
+#endif
+#if SENSOR_WATER_LEVEL
+#include "sensors/water-level/waterLevel.sensor.h"
+#endif
+#if SENSOR_TDS
+#include "sensors/tds/tds.sensor.h"
+#endif
+#if SENSOR_PH
+#include "sensors/ph/ph.sensor.h"
+#endif
+#if SENSOR_WATER_FLOW
+#include "sensors/water-flow/waterFlow.sensor.h"
+#endif
+
+// Statically composed sensor list and its dependency graph. Members are
+// declared producers first, so dependencies are constructed and visited
+// before their consumers: within one pass a consumer always sees the
+// producer's reading from that same pass.
+//   waterTemperature -> tds (temperature compensation, by epoch)
+// PHSensor keeps a reference to the probe only to report the water
+// temperature next to pH, the pH value does not depend on it.
+struct SensorSet
+{
+#if SENSOR_WATER_TEMPERATURE
+    WaterTemperatureSensor waterTemperature{WATER_TEMPERATURE_PIN};
+#endif
+#if SENSOR_DHT11
+    DHT11Sensor dht11{DHT11_PIN, IsrTrampoline<DHT11_PIN, DHT11Sensor>::binding()};
+#endif
+#if SENSOR_WATER_LEVEL
+    WaterLevelSensor waterLevel{WATER_LEVEL_LOW_PIN, WATER_LEVEL_HIGH_PIN};
+#endif
+#if SENSOR_TDS
+    GravityTDSMeter tds{TDS_PIN, waterTemperature};
+#endif
+#if SENSOR_PH
+    PHSensor ph{PH_PIN, waterTemperature};
+#endif
+#if SENSOR_WATER_FLOW
+    WaterFlowSensor waterFlow{FLOW_SENSOR_PIN, IsrTrampoline<FLOW_SENSOR_PIN, WaterFlowSensor>::binding()};
+#endif
+
+    static const uint8_t count = SENSOR_WATER_TEMPERATURE + SENSOR_DHT11 + SENSOR_WATER_LEVEL + SENSOR_TDS +
+                                 SENSOR_PH + SENSOR_WATER_FLOW;
+
+    // Calls visitor(sensor) with each concrete sensor type, no virtual dispatch
+    template <typename Visitor>
+    void forEach(Visitor &visitor)
+    {
+#if SENSOR_WATER_TEMPERATURE
+        visitor(waterTemperature);
+#endif
+#if SENSOR_DHT11
+        visitor(dht11);
+#endif
+#if SENSOR_WATER_LEVEL
+        visitor(waterLevel);
+#endif
+#if SENSOR_TDS
+        visitor(tds);
+#endif
+#if SENSOR_PH
+        visitor(ph);
+#endif
+#if SENSOR_WATER_FLOW
+        visitor(waterFlow);
+#endif
+    }
+};
+
+#endif // SENSORS_CONFIG_H
@@ -1,7 +1,10 @@
 #include "tds.sensor.h"
+#include "utility/logger.util.h"
 
-GravityTDSMeter::GravityTDSMeter(uint8_t pin, WaterTemperatureSensor&tempSensor) : pin(pin), tempSensor(tempSensor)
+GravityTDSMeter::GravityTDSMeter(uint8_t pin, WaterTemperatureSensor&tempSensor)
+    : AbstractSensor(5000, 500, 300, 1), pin(pin), tempSensor(tempSensor), analogValue(0), hasRaw(false), configured(false), usedEpoch(0), tdsValue(0)
 {
+    health.stuckLimit = 30;
 }
 
 GravityTDSMeter::~GravityTDSMeter()
@@ -11,19 +14,46 @@ GravityTDSMeter::~GravityTDSMeter()
 
 void GravityTDSMeter::initialize()
 {
-    Serial.println("Initializing Gravity TDS Meter...");
+    LOG_INFO("tds", "Initializing");
     pinMode(pin, INPUT);
 }
 
 std::map<std::string, double> GravityTDSMeter::readData()
 {
     std::map<std::string, double> data;
-    double temperature = tempSensor.lastTemperature;
-    double tdsValue = readTDS(temperature);
+    int value = analogRead(pin);
+    // Only recompute when the reading or the water temperature changed
+    if (!hasRaw || value != analogValue || tempSensor.getEpoch() != usedEpoch)
+    {
+        analogValue = value;
+        hasRaw = true;
+        tdsValue = readTDS();
+    }
     data["tds"] = tdsValue;
     return data;
 }
 
+// Water temperature moved while TDS is not due: re-compensate the last reading
+void GravityTDSMeter::refreshDerived(std::map<std::string, double> &data)
+{
+    if (hasRaw && tempSensor.getEpoch() != usedEpoch)
+    {
+        tdsValue = readTDS();
+        data["tds"] = tdsValue;
+    }
+}
+
+uint16_t GravityTDSMeter::getCompensationEpoch() const
+{
+    return usedEpoch;
+}
+
+// The probe is specified to 1000 ppm, readings far above mean a shorted probe
+bool GravityTDSMeter::isPlausible(const std::string &channel, double value) const
+{
+    return value >= 0.0 && value <= 2000.0;
+}
+
 const char *GravityTDSMeter::getType()
 {
     return "GravityTDS";
@@ -34,20 +64,15 @@ const char *GravityTDSMeter::getSensorName()
     return "SEN0244";
 }
 
-double GravityTDSMeter::readTDS(double temperature)
+// Converts the last analog reading, the cubic's coefficients are only
+// rebuilt when the water temperature epoch changed
+double GravityTDSMeter::readTDS()
 {
-    // Read the analog value from the TDS sensor
-    int analogValue = analogRead(pin);
-
-    // Convert the analog value to voltage
-    double voltage = analogValue * (5.0 / 1024.0);
-
-    // Calculate the TDS value using the voltage and temperature
-    double compensationCoefficient = 1.0 + 0.02 * (temperature - 25.0);
-    double compensationVoltage = voltage / compensationCoefficient;
-    double tdsValue = (133.42 * compensationVoltage * compensationVoltage * compensationVoltage 
-        - 255.86 * compensationVoltage * compensationVoltage 
-        + 857.39 * compensationVoltage) * 0.5; // TDS conversion factor
-
-    return tdsValue;
-}
\ No newline at end of file
+    if (!configured || tempSensor.getEpoch() != usedEpoch)
+    {
+        usedEpoch = tempSensor.getEpoch();
+        kernel.configure(tempSensor.lastTemperature);
+        configured = true;
+    }
+    return kernel.convert(analogValue);
+}
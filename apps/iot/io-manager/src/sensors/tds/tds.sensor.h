@@ -5,23 +5,37 @@
 #include <map>
 #include <string>
 #include "sensor.abstract.class.h"
+#include "utility/sensorKernels.util.h"
 #include "sensors/water-temperature/waterTemperature.sensor.h"
 
-class GravityTDSMeter : public AbstractSensor
+class GravityTDSMeter final : public AbstractSensor<GravityTDSMeter>
 {
 public:
     GravityTDSMeter(uint8_t pin, WaterTemperatureSensor &tempSensor);
     ~GravityTDSMeter();
 
-    void initialize() override;
-    std::map<std::string, double> readData() override;
-    const char *getType() override;
-    const char *getSensorName() override;
+    void initialize();
+    std::map<std::string, double> readData();
+    const char *getType();
+    const char *getSensorName();
+    bool isPlausible(const std::string &channel, double value) const;
+
+    // Republishes TDS when the water temperature changed since the last read
+    void refreshDerived(std::map<std::string, double> &data);
+
+    // Temperature epoch the current TDS value was compensated with
+    uint16_t getCompensationEpoch() const;
 
 private:
     uint8_t pin;
     WaterTemperatureSensor &tempSensor;
-    double readTDS(double temperature);
+    int analogValue; // Last ADC reading
+    bool hasRaw;
+    bool configured;
+    uint16_t usedEpoch;
+    double tdsValue;
+    TdsKernel kernel; // Coefficients for the current water temperature
+    double readTDS();
 };
 
 #endif // GRAVITYTDSMETER_H
\ No newline at end of file
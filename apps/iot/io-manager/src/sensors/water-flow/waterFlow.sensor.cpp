@@ -1,50 +1,165 @@
 #include "waterFlow.sensor.h"
+#include "utility/logger.util.h"
+#include "services/disk-manager/diskManager.service.h"
+#include "config.h"
+#include "sensors/sensors.config.h"
 
-WaterFlowSensor *WaterFlowSensor::instance = nullptr;
+volatile uint16_t WaterFlowSensor::captureOverflows = 0;
 
-WaterFlowSensor::WaterFlowSensor(uint8_t pin)
-    : pulses(0), lastPulseTime(0), lastInterruptTime(0), flowRate(0), pin(pin)
+// Timer5 capture has a single owner, bound through this trampoline
+typedef IsrTrampoline<FLOW_CAPTURE_PIN, WaterFlowSensor> CaptureTrampoline;
+
+WaterFlowSensor::WaterFlowSensor(uint8_t pin, IsrBinding isr)
+    : AbstractSensor(FLOW_GATE_MS, FLOW_GATE_MS, 200, 3), pin(pin), isr(isr), bound(false), useCapture(false), flowRate(0),
+      gateStart(0), gatePulses(0), gateEdgeUs(0), gateHasEdge(false), persistedPulses(0), savedTotal(0), lastSave(0)
 {
-    instance = this;
 }
 
 WaterFlowSensor::~WaterFlowSensor()
 {
-    instance = nullptr;
-    detachInterrupt(digitalPinToInterrupt(pin));
+    if (!bound)
+    {
+        return;
+    }
+    if (useCapture)
+    {
+        TIMSK5 = 0;
+    }
+    else
+    {
+        detachInterrupt(digitalPinToInterrupt(pin));
+    }
+    isr.unbind(this);
 }
 
 void WaterFlowSensor::initialize()
 {
     pinMode(pin, INPUT);
-    attachInterrupt(digitalPinToInterrupt(pin), flowISR, FALLING);
-    Serial.println("Flow sensor initialized");
+
+    DiskManagerService *disk = DiskManagerService::getInstance();
+    if (disk != nullptr)
+    {
+        persistedPulses = strtoul(disk->read("flow-total").c_str(), nullptr, 10);
+        savedTotal = persistedPulses;
+    }
+
+    if (!isr.bind(this))
+    {
+        LOG_ERROR("flow", "Interrupt on pin %d already owned by another sensor", pin);
+        setStatus("Interrupt in use");
+        return;
+    }
+    bound = true;
+
+#if defined(TIMER5_CAPT_vect)
+    if (pin == FLOW_CAPTURE_PIN && isr.handler == CaptureTrampoline::handle)
+    {
+        beginCapture();
+        LOG_INFO("flow", "Initialized (Timer5 input capture)");
+        return;
+    }
+#endif
+    attachInterrupt(digitalPinToInterrupt(pin), isr.handler, FALLING);
+    LOG_INFO("flow", "Initialized on pin %d", pin);
+}
+
+// Timer5 free running at F_CPU/64 (4 us per tick), capture on the falling edge
+// with the noise canceler, overflow interrupt extends it to 32 bits.
+void WaterFlowSensor::beginCapture()
+{
+#if defined(TIMER5_CAPT_vect)
+    noInterrupts();
+    TCCR5A = 0;
+    TCCR5B = (1 << ICNC5) | (1 << CS51) | (1 << CS50);
+    TCNT5 = 0;
+    TIFR5 = (1 << ICF5) | (1 << TOV5);
+    TIMSK5 = (1 << ICIE5) | (1 << TOIE5);
+    captureOverflows = 0;
+    useCapture = true;
+    interrupts();
+#endif
 }
 
 std::map<std::string, double> WaterFlowSensor::readData()
 {
     std::map<std::string, double> data;
 
-    float currentFlowRate = flowRate;
-    uint16_t currentPulses = pulses;
-    unsigned long timeSinceLastPulse = millis() - lastPulseTime;
+    FlowSample current = sample.read();
 
-    // Reset flow rate if no pulse detected in the last 1 second
-    if (timeSinceLastPulse > 1000)
+    unsigned long now = millis();
+    if (now - gateStart >= FLOW_GATE_MS)
     {
-        currentFlowRate = 0;
+        uint32_t edges = current.pulses - gatePulses;
+        if (edges == 0)
+        {
+            if (now - current.pulseMillis > noFlowMs)
+            {
+                flowRate = 0;
+            }
+            gateHasEdge = false;
+        }
+        else
+        {
+            // Reciprocal counting: `edges` whole periods between the last edge of each gate.
+            // Without an edge in the previous gate only the last period counts, and
+            // only when it joins two edges of this run (not the first since boot or
+            // one across a stop); the rate then waits for the next gate.
+            uint32_t spanUs = gateHasEdge ? current.edgeUs - gateEdgeUs : current.periodUs;
+            uint32_t counted = gateHasEdge ? edges : 1;
+            if (!gateHasEdge && spanUs > noFlowMs * 1000UL)
+            {
+                spanUs = 0;
+            }
+            if (spanUs > 0)
+            {
+                flowRate = counted * (60.0e6f / pulsesPerLiter) / spanUs;
+            }
+            gateHasEdge = true;
+        }
+        gatePulses = current.pulses;
+        gateEdgeUs = current.edgeUs;
+        gateStart = now;
     }
 
-    // Calculate total liters
-    float liters = currentPulses / (7.5 * 60.0);
+    uint32_t total = persistedPulses + current.pulses;
+    persistTotal(total, now);
 
-    // data["flow-rate-hz"] = currentFlowRate;
-    // data["pulses"] = currentPulses;
-    // data["flow-rate-liters"] = liters;
-    data["lpm"] = currentFlowRate; // flowRate is already in L/min from ISR
+    data["lpm"] = flowRate;
+    data["lt"] = (float)total / pulsesPerLiter;
     return data;
 }
 
+uint32_t WaterFlowSensor::getTotalPulses()
+{
+    return persistedPulses + sample.read().pulses;
+}
+
+// EEPROM endurance is limited, so only write after a liter and a quiet interval
+void WaterFlowSensor::persistTotal(uint32_t total, unsigned long now)
+{
+    if (total - savedTotal < pulsesPerLiter || now - lastSave < FLOW_PERSIST_INTERVAL_MS)
+    {
+        return;
+    }
+    DiskManagerService *disk = DiskManagerService::getInstance();
+    if (disk != nullptr)
+    {
+        disk->save("flow-total", String(total));
+        savedTotal = total;
+        lastSave = now;
+    }
+}
+
+// YF-S201 is rated 1-30 L/min, the total only has to be non-negative
+bool WaterFlowSensor::isPlausible(const std::string &channel, double value) const
+{
+    if (channel == "lpm")
+    {
+        return value >= 0.0 && value <= 60.0;
+    }
+    return value >= 0.0;
+}
+
 const char *WaterFlowSensor::getType()
 {
     return "Flow Sensor";
@@ -55,35 +170,29 @@ const char *WaterFlowSensor::getSensorName()
     return "YF-S201";
 }
 
-void WaterFlowSensor::flowISR()
+// Vectors are always linked, so only claim Timer5 when a flow meter is built in
+#if SENSOR_WATER_FLOW && defined(TIMER5_CAPT_vect)
+ISR(TIMER5_CAPT_vect)
 {
-    // NULL check to prevent crashes
-    if (instance == nullptr)
-    {
-        return;
-    }
-
-    unsigned long currentTime = millis();
+    uint16_t capture = ICR5;
+    uint16_t overflows = WaterFlowSensor::captureOverflows;
 
-    // Debounce: ignore pulses within 10ms of each other
-    if (currentTime - instance->lastInterruptTime < 10)
+    // Overflow still pending and the capture happened after the wrap
+    if ((TIFR5 & (1 << TOV5)) && capture < 0x8000)
     {
-        return;
+        overflows++;
     }
 
-    instance->lastInterruptTime = currentTime;
-    instance->pulses++;
-
-    // Calculate flow rate based on pulse frequency
-    // Time between pulses in seconds
-    float timeDiff = (currentTime - instance->lastPulseTime) / 1000.0;
-
-    if (timeDiff > 0)
+    WaterFlowSensor *sensor = CaptureTrampoline::get();
+    if (sensor != nullptr)
     {
-        // YF-S201: Flow rate (L/min) = Frequency (Hz) / 7.5
-        // Optimized: 1/timeDiff/7.5 = 1/(timeDiff*7.5) = 0.1333.../timeDiff
-        instance->flowRate = 0.13333333f / timeDiff;
+        uint32_t ticks = ((uint32_t)overflows << 16) | capture;
+        sensor->onEdge(ticks << 2); // 4 us per tick
     }
+}
 
-    instance->lastPulseTime = currentTime;
+ISR(TIMER5_OVF_vect)
+{
+    WaterFlowSensor::captureOverflows++;
 }
+#endif
@@ -5,27 +5,91 @@
 #include <string>
 #include <Arduino.h>
 #include "sensor.abstract.class.h"
+#include "abstract/isrSnapshot.h"
+#include "abstract/isrTrampoline.h"
 
-class WaterFlowSensor : public AbstractSensor
+// Input capture pin of Timer5 on the Mega
+#define FLOW_CAPTURE_PIN 48
+
+// Consistent view of the pulse train, published by the ISR
+struct FlowSample
+{
+    uint32_t pulses;         // Accepted edges since boot
+    uint32_t periodUs;       // Time between the last two edges, 0 after the first
+    uint32_t edgeUs;         // Timestamp of the latest edge
+    unsigned long pulseMillis; // millis() at the latest edge
+};
+
+// Each meter owns its interrupt through a trampoline, e.g.
+// new WaterFlowSensor(3, IsrTrampoline<3, WaterFlowSensor>::binding())
+class WaterFlowSensor final : public AbstractSensor<WaterFlowSensor>
 {
 public:
-    explicit WaterFlowSensor(uint8_t pin);
+    WaterFlowSensor(uint8_t pin, IsrBinding isr);
     ~WaterFlowSensor();
 
     void initialize();
     std::map<std::string, double> readData();
     const char *getType();
     const char *getSensorName();
+    bool isPlausible(const std::string &channel, double value) const;
+
+    // Pulses since boot plus the persisted total
+    uint32_t getTotalPulses();
 
     uint8_t pin;
 
-    // Shared variables between ISR and main code
-    volatile uint16_t pulses;
-    volatile unsigned long lastPulseTime;
-    volatile unsigned long lastInterruptTime; // For debouncing
-    volatile float flowRate;
-    static WaterFlowSensor *instance; // For static ISR access
-    static void flowISR(); // Pin change ISR (simple, fast, no millis())
+    // Shared between ISR and main code, read with sample.read()
+    IsrSnapshot<FlowSample> sample;
+    static volatile uint16_t captureOverflows; // Upper half of the Timer5 timestamp
+
+    // External interrupt path, called through the trampoline
+    void onInterrupt()
+    {
+        onEdge(micros());
+    }
+
+    // Called from either ISR with a microsecond timestamp
+    void onEdge(uint32_t edgeUs)
+    {
+        FlowSample &current = sample.beginWrite();
+        uint32_t period = edgeUs - current.edgeUs;
+        // Edges faster than the meter can spin are glitches
+        if (current.pulses == 0 || period >= minPeriodUs)
+        {
+            // The first edge has no predecessor, edgeUs was still 0
+            current.periodUs = current.pulses == 0 ? 0 : period;
+            current.edgeUs = edgeUs;
+            current.pulseMillis = millis();
+            current.pulses++;
+        }
+        sample.endWrite();
+    }
+
+private:
+    // YF-S201: f(Hz) = 7.5 * Q(L/min), 450 pulses per liter
+    static const uint16_t pulsesPerLiter = 450;
+    static const uint32_t minPeriodUs = 2000;   // ~225 Hz max at 30 L/min
+    static const unsigned long noFlowMs = 1000; // No pulse for this long means no flow
+
+    IsrBinding isr;
+    bool bound;
+    bool useCapture;
+    float flowRate;
+
+    // Gate window state (loop side)
+    unsigned long gateStart;
+    uint32_t gatePulses;
+    uint32_t gateEdgeUs;
+    bool gateHasEdge;
+
+    // Totalizer persistence
+    uint32_t persistedPulses;
+    uint32_t savedTotal;
+    unsigned long lastSave;
+
+    void beginCapture();
+    void persistTotal(uint32_t total, unsigned long now);
 };
 
 #endif // WATERFLOW_SENSOR_H
@@ -1,6 +1,6 @@
 #include "waterLevel.sensor.h"
 
-WaterLevelSensor::WaterLevelSensor(uint8_t lowPin, uint8_t highPin) : lowPin(lowPin), highPin(highPin)
+WaterLevelSensor::WaterLevelSensor(uint8_t lowPin, uint8_t highPin) : AbstractSensor(500, 100, 50, 3), lowPin(lowPin), highPin(highPin)
 {
     this->lowPin = lowPin;
     this->highPin = highPin;
@@ -18,13 +18,17 @@ void WaterLevelSensor::initialize()
 
 std::map<std::string, double> WaterLevelSensor::readData()
 {
-    Serial.println(digitalRead(lowPin) == HIGH);
-    Serial.println(digitalRead(highPin) == HIGH);
     std::map<std::string, double> data;
     data["wl"] = waterLevelIs();
     return data;
 }
 
+// Low/adequate/high only, 101010 (both floats inverted) is a wiring fault
+bool WaterLevelSensor::isPlausible(const std::string &channel, double value) const
+{
+    return value == -1.0 || value == 0.0 || value == 1.0;
+}
+
 const char *WaterLevelSensor::getType()
 {
     return "WaterLevel";
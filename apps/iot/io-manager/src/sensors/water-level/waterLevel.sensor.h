@@ -6,16 +6,17 @@
 #include <string>
 #include "sensor.abstract.class.h"
 
-class WaterLevelSensor : public AbstractSensor
+class WaterLevelSensor final : public AbstractSensor<WaterLevelSensor>
 {
 public:
     WaterLevelSensor(uint8_t lowPin, uint8_t highPin);
     ~WaterLevelSensor();
-    void initialize() override;
+    void initialize();
 
-    std::map<std::string, double> readData() override;
-    const char *getType() override;
-    const char *getSensorName() override;
+    std::map<std::string, double> readData();
+    const char *getType();
+    const char *getSensorName();
+    bool isPlausible(const std::string &channel, double value) const;
     bool isWaterLevelLow();
     bool isWaterLevelAdequate();
     bool isWaterLevelHigh();
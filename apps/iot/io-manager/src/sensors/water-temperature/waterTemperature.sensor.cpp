@@ -1,6 +1,15 @@
 #include "waterTemperature.sensor.h"
+#include "utility/logger.util.h"
 
-WaterTemperatureSensor::WaterTemperatureSensor(uint8_t pin) : pin(pin), oneWire(pin), sensors(&oneWire)
+static const unsigned long MIN_SCAN_BACKOFF_MS = 1000;
+static const unsigned long MAX_SCAN_BACKOFF_MS = 60000;
+static const unsigned long CONVERSION_MS = 375; // 11-bit resolution
+
+// A read is two steps: start the conversion, then fetch the scratchpads on
+// a pass after it completed. Neither waits for the 375 ms conversion.
+WaterTemperatureSensor::WaterTemperatureSensor(uint8_t pin)
+    : AbstractSensor(5000, 1000, 15000, 2), lastTemperature(25.0), pin(pin), oneWire(pin), sensors(&oneWire),
+      probeCount(0), epoch(0), converting(false), nextScanAt(0), scanBackoffMs(MIN_SCAN_BACKOFF_MS)
 {
 }
 
@@ -10,20 +19,121 @@ WaterTemperatureSensor::~WaterTemperatureSensor()
 }
 
 void WaterTemperatureSensor::initialize()
+{
+    scanProbes();
+}
+
+// Walks the bus once and caches the ROM addresses
+void WaterTemperatureSensor::scanProbes()
 {
     sensors.begin();
-    sensors.setResolution(11);
+    sensors.setWaitForConversion(false);
+    converting = false;
+    probeCount = 0;
+    uint8_t found = sensors.getDeviceCount();
+    for (uint8_t i = 0; i < found && probeCount < maxProbes; i++)
+    {
+        if (sensors.getAddress(addresses[probeCount], i))
+        {
+            sensors.setResolution(addresses[probeCount], 11);
+            probeCount++;
+        }
+    }
+    LOG_INFO("sensor", "%s: %d probes found", getSensorName(), probeCount);
+    setStatus(probeCount ? "OK" : "No probe");
+}
+
+void WaterTemperatureSensor::scheduleRescan()
+{
+    nextScanAt = millis() + scanBackoffMs;
+    scanBackoffMs = scanBackoffMs * 2 > MAX_SCAN_BACKOFF_MS ? MAX_SCAN_BACKOFF_MS : scanBackoffMs * 2;
 }
 
 std::map<std::string, double> WaterTemperatureSensor::readData()
 {
     std::map<std::string, double> data;
-    sensors.requestTemperatures();
-    this->lastTemperature = sensors.getTempCByIndex(0);
-    data["wt"] = lastTemperature;
+
+    if (!converting)
+    {
+        if (nextScanAt != 0 && (long)(millis() - nextScanAt) >= 0)
+        {
+            nextScanAt = 0;
+            scanProbes();
+        }
+        if (probeCount == 0)
+        {
+            if (nextScanAt == 0)
+            {
+                scheduleRescan();
+            }
+            return data;
+        }
+
+        // Skip ROM broadcast: every probe converts at once, the results are
+        // collected on the pass after the conversion time
+        sensors.requestTemperatures();
+        converting = true;
+        sampling.resumeAfter(millis(), CONVERSION_MS);
+        return data;
+    }
+    converting = false;
+
+    bool missing = false;
+    for (uint8_t i = 0; i < probeCount; i++)
+    {
+        float temperature = sensors.getTempC(addresses[i]);
+        if (temperature == DEVICE_DISCONNECTED_C)
+        {
+            missing = true;
+            continue;
+        }
+        if (i == 0)
+        {
+            if (temperature != lastTemperature)
+            {
+                lastTemperature = temperature;
+                epoch++;
+            }
+            data["wt"] = temperature;
+        }
+        else
+        {
+            data["wt" + std::string(1, '1' + i)] = temperature;
+        }
+    }
+
+    if (missing)
+    {
+        setStatus("Probe disconnected");
+        if (nextScanAt == 0)
+        {
+            scheduleRescan();
+        }
+    }
+    else
+    {
+        setStatus("OK");
+        scanBackoffMs = MIN_SCAN_BACKOFF_MS;
+    }
     return data;
 }
 
+uint8_t WaterTemperatureSensor::getProbeCount() const
+{
+    return probeCount;
+}
+
+uint16_t WaterTemperatureSensor::getEpoch() const
+{
+    return epoch;
+}
+
+// 85 °C is the DS18B20 power-on value, read back after a brown-out mid conversion
+bool WaterTemperatureSensor::isPlausible(const std::string &channel, double value) const
+{
+    return value > -10.0 && value < 60.0 && value != 85.0;
+}
+
 const char *WaterTemperatureSensor::getType()
 {
     return "DS18B20";
@@ -32,4 +142,4 @@ const char *WaterTemperatureSensor::getType()
 const char *WaterTemperatureSensor::getSensorName()
 {
     return "DS18B20";
-}
\ No newline at end of file
+}
@@ -8,22 +8,44 @@
 #include <string>
 #include "sensor.abstract.class.h"
 
-class WaterTemperatureSensor : public AbstractSensor
+// All DS18B20 probes on one OneWire bus. Addresses are enumerated once and
+// cached, a single broadcast conversion serves every probe. The first probe
+// reports "wt" (used for TDS compensation), the others "wt2", "wt3", ...
+class WaterTemperatureSensor final : public AbstractSensor<WaterTemperatureSensor>
 {
 public:
+    static const uint8_t maxProbes = 4;
+
     WaterTemperatureSensor(uint8_t pin);
     ~WaterTemperatureSensor();
 
-    void initialize() override;
-    std::map<std::string, double> readData() override;
-    const char *getType() override;
-    const char *getSensorName() override;
+    void initialize();
+    std::map<std::string, double> readData();
+    const char *getType();
+    const char *getSensorName();
+    bool isPlausible(const std::string &channel, double value) const;
+    uint8_t getProbeCount() const;
+    // Bumped whenever lastTemperature changes, compensated channels compare it
+    uint16_t getEpoch() const;
+    // Last good reading of the first probe, 25 °C until one arrives
     double lastTemperature;
 
 private:
     uint8_t pin;
     OneWire oneWire;
     DallasTemperature sensors;
+
+    DeviceAddress addresses[maxProbes];
+    uint8_t probeCount;
+    uint16_t epoch;
+    bool converting; // Conversion started, results are read on the next step
+
+    // Re-scan backoff after a probe went missing (-127)
+    unsigned long nextScanAt;
+    unsigned long scanBackoffMs;
+
+    void scanProbes();
+    void scheduleRescan();
 };
 
-#endif // DS18B20SENSOR_H
\ No newline at end of file
+#endif // DS18B20SENSOR_H
@@ -1,10 +1,11 @@
 #include "activeMQ-client.service.h"
+#include "utility/logger.util.h"
 
 // Initialize the static instance pointer
 ActiveMQClientService *ActiveMQClientService::instance = nullptr;
 
 // Constructor
-ActiveMQClientService::ActiveMQClientService() : mqttClient(wifiClient)
+ActiveMQClientService::ActiveMQClientService() : linkTap(netClient, onPuback, onPingResponse), mqttClient(linkTap)
 {
     // Set this instance as the static instance
     instance = this;
@@ -25,70 +26,366 @@ bool ActiveMQClientService::isConnected()
 }
 
 // Initialize the MQTT client
-void ActiveMQClientService::initialize(const char *brokerAddress, int port, const char *clientId)
+void ActiveMQClientService::initialize(BrokerResolverService &brokerResolver, const char *clientId)
 {
-    // Set the static instance
-    Serial.println("Initializing ActiveMQ client service. " + String(brokerAddress) + " " + String(port) + " " + String(clientId));
-    mqttClient.setServer("192.168.100.102", 3011);
+    attach(brokerResolver);
+    LOG_INFO("mqtt", "Initializing, broker %s:%u as %s", resolver->getHost().c_str(), resolver->getPort(), clientId);
 
     // Attempt to connect to the MQTT broker
     while (!mqttClient.connected())
-    { 
-        Serial.println("Connecting to ActiveMQ broker with clientId: " + String(clientId));
-        if (mqttClient.connect(clientId))
+    {
+        resolver->loop();
+        IPAddress address;
+        if (!resolver->getAddress(address))
+        {
+            delay(BROKER_POLL_MS); // First lookup, nothing cached yet
+            continue;
+        }
+        if (connectTo(address, clientId))
         {
-            Serial.println("Connected to ActiveMQ broker."); 
+            LOG_INFO("mqtt", "Connected to broker");
         }
         else
         {
-            Serial.print("Failed to connect. Retry in 5 seconds. Error code: ");
-            Serial.println(mqttClient.state());
+            LOG_WARN("mqtt", "Connect failed, state %d, retry in 5 s", mqttClient.state());
             delay(5000);
-        } 
+        }
+    }
+}
+
+void ActiveMQClientService::attach(BrokerResolverService &brokerResolver)
+{
+    resolver = &brokerResolver;
+    mqttClient.setKeepAlive(keepAlive);
+    mqttClient.setSocketTimeout(getSocketTimeout());
+}
+
+// By address, PubSubClient would otherwise have the module resolve the
+// name on every connect
+bool ActiveMQClientService::connectTo(const IPAddress &address, const char *clientId)
+{
+    mqttClient.setServer(address, resolver->getPort());
+    if (!mqttClient.connect(clientId))
+    {
+        resolver->reportFailed();
+        return false;
+    }
+    resolver->reportConnected(address);
+    return true;
+}
+
+void ActiveMQClientService::disconnect()
+{
+    mqttClient.disconnect();
+}
+
+// Try to reconnect once without blocking the main loop for the retry delay
+bool ActiveMQClientService::reconnect(const char *clientId)
+{
+    unsigned long now = millis();
+    if (downSince == 0)
+    {
+        downSince = now;
+    }
+    if (lastReconnectAttempt != 0 && now - lastReconnectAttempt < reconnectInterval)
+    {
+        return false;
+    }
+    lastReconnectAttempt = now;
+
+    IPAddress address;
+    if (resolver == nullptr || !resolver->getAddress(address))
+    {
+        LOG_WARN("mqtt", "Broker address not known yet");
+        return false;
+    }
+    mqttClient.setKeepAlive(keepAlive);
+    mqttClient.setSocketTimeout(getSocketTimeout());
+    if (!connectTo(address, clientId))
+    {
+        LOG_WARN("mqtt", "Reconnect failed, state %d", mqttClient.state());
+        return false;
+    }
+
+    // Clean session, the broker forgot our subscriptions
+    char name[MQTT_TOPIC_MAX];
+    for (FlashString topic : subscriptions)
+    {
+        flashCopy(name, sizeof(name), topic);
+        mqttClient.subscribe(name);
     }
+    // Whatever was in flight may have died with the old socket
+    inflight.resendAll();
+    reconnectTimes.add(millis() - downSince);
+    downSince = 0;
+    LOG_INFO("mqtt", "Reconnected after %lu ms, %d packets in flight", reconnectTimes.getLast(), inflight.inFlight());
+    return true;
 }
 
 // Subscribe to a topic
-void ActiveMQClientService::subscribe(const String &topic)
+void ActiveMQClientService::subscribe(FlashString topic)
 {
+    // Hash first, the full compare only runs on a hash match
+    uint16_t hash = flashHash(topic);
+    bool known = false;
+    for (FlashString subscription : subscriptions)
+    {
+        known = known || (subscription == topic) ||
+                (flashHash(subscription) == hash && strcmp_P(flashChars(topic), flashChars(subscription)) == 0);
+    }
+    if (!known)
+    {
+        subscriptions.push_back(topic);
+    }
+
     if (mqttClient.connected())
     {
-        mqttClient.subscribe(topic.c_str());
-        Serial.println("Subscribed to topic: " + topic);
+        char name[MQTT_TOPIC_MAX];
+        flashCopy(name, sizeof(name), topic);
+        mqttClient.subscribe(name);
+        LOG_DEBUG("mqtt", "Subscribed to %s", name);
     }
     else
     {
-        Serial.println("Cannot subscribe. MQTT not connected.");
+        LOG_WARN("mqtt", "Cannot subscribe, not connected");
     }
 }
 
 // Publish a JSON-formatted message to a topic
-void ActiveMQClientService::publish(const String &topic, const JsonDocument &message)
+bool ActiveMQClientService::publish(FlashString topic, const JsonDocument &message, uint8_t qos)
 {
+    if (qos > 0)
+    {
+        return publishReliable(topic, message);
+    }
     if (!mqttClient.connected())
     {
-        Serial.println("Cannot publish. MQTT not connected.");
-        return;
+        LOG_WARN("mqtt", "Cannot publish, not connected");
+        publishFailures++;
+        return false;
     }
 
+    // PubSubClient's packet buffer is 256 bytes as well, a cut JSON would
+    // reach subscribers unparseable
     char buffer[256];
-    
+    if (measureJson(message) >= sizeof(buffer))
+    {
+        LOG_WARN("mqtt", "%u byte payload too large for QoS 0", (unsigned)measureJson(message));
+        publishFailures++;
+        return false;
+    }
     serializeJson(message, buffer);
 
-    if (mqttClient.publish(topic.c_str(), buffer))
+    char name[MQTT_TOPIC_MAX];
+    flashCopy(name, sizeof(name), topic);
+    if (!mqttClient.publish(name, buffer))
     {
-        Serial.println("Message published to topic: " + topic);
+        LOG_WARN("mqtt", "Publish to %s failed", name);
+        publishFailures++;
+        return false;
     }
-    else
+    LOG_DEBUG("mqtt", "Published to %s", name);
+    return true;
+}
+
+// The packet is built once into its window slot and sent from there, also
+// while offline: it then goes out after the reconnect
+bool ActiveMQClientService::publishReliable(FlashString topic, const JsonDocument &message)
+{
+    uint16_t topicLength = flashLength(topic);
+    size_t payloadLength = measureJson(message);
+    // Header, topic, packet id, payload and serializeJson's terminator
+    if (7 + topicLength + 2 + payloadLength + 1 > inflight.capacity())
+    {
+        LOG_WARN("mqtt", "%u byte payload too large for QoS 1", (unsigned)payloadLength);
+        return publish(topic, message, 0);
+    }
+    auto *slot = inflight.claim();
+    if (slot == nullptr)
+    {
+        publishFailures++;
+        return false;
+    }
+    uint16_t n = mqttWritePublishHeader(slot->packet, topicLength, payloadLength);
+    memcpy_P(slot->packet + n, flashChars(topic), topicLength);
+    n += topicLength;
+    slot->packet[n++] = (uint8_t)(slot->packetId >> 8);
+    slot->packet[n++] = (uint8_t)(slot->packetId & 0xFF);
+    serializeJson(message, (char *)slot->packet + n, inflight.capacity() - n);
+    slot->length = n + payloadLength;
+    sendDue();
+    return true;
+}
+
+void ActiveMQClientService::sendDue()
+{
+    if (!mqttClient.connected())
+    {
+        return;
+    }
+    auto *slot = inflight.nextDue(millis(), MQTT_QOS1_RETRY_MS);
+    if (slot == nullptr)
+    {
+        return;
+    }
+    if (slot->attempts >= MQTT_QOS1_MAX_ATTEMPTS)
+    {
+        LOG_WARN("mqtt", "Packet %u never acknowledged, dropped", slot->packetId);
+        inflight.expire(*slot);
+        return;
+    }
+    // One write, the packet stays in its slot until the PUBACK
+    size_t written = mqttClient.write(slot->packet, slot->length);
+    if (written == 0)
+    {
+        return; // Nothing went out, the slot is still due
+    }
+    inflight.markSent(*slot, millis());
+    if (written < slot->length)
+    {
+        // The broker would read the next packet as the rest of this one.
+        // Close the link, the reconnect resends every slot whole.
+        LOG_WARN("mqtt", "Short write of packet %u (%u of %u bytes), closing the link", slot->packetId,
+                 (unsigned)written, slot->length);
+        linkTap.stop();
+    }
+}
+
+void ActiveMQClientService::onPuback(uint16_t packetId)
+{
+    if (instance == nullptr)
+    {
+        return;
+    }
+    const auto *slot = instance->inflight.find(packetId);
+    if (slot != nullptr)
+    {
+        instance->ackLatency.add(millis() - slot->sentAt);
+    }
+    if (instance->inflight.acknowledge(packetId))
+    {
+        LOG_DEBUG("mqtt", "PUBACK %u", packetId);
+    }
+}
+
+void ActiveMQClientService::onPingResponse(unsigned long rttMs)
+{
+    if (instance)
+    {
+        instance->pingRtt.add(rttMs);
+        LOG_DEBUG("mqtt", "PINGRESP after %lu ms", rttMs);
+    }
+}
+
+// PubSubClient itself only gives up on a ping after a second keepalive
+// period; measured round trips allow a much shorter wait
+void ActiveMQClientService::checkResponses()
+{
+    unsigned long now = millis();
+    unsigned long waited = linkTap.pingWait(now);
+    unsigned long ackWait = inflight.longestWait(now);
+    waited = ackWait > waited ? ackWait : waited;
+    if (waited > getResponseTimeout())
     {
-        Serial.println("Failed to publish message to topic: " + topic);
+        LOG_WARN("mqtt", "No answer for %lu ms, closing the link", waited);
+        linkTap.stop();
     }
 }
 
+unsigned long ActiveMQClientService::getResponseTimeout() const
+{
+    unsigned long limit = keepAlive * 1000UL;
+    if (pingRtt.size() == 0 && ackLatency.size() == 0)
+    {
+        return limit;
+    }
+    unsigned long p90 = pingRtt.percentile(90);
+    unsigned long ackP90 = ackLatency.percentile(90);
+    unsigned long timeout = (ackP90 > p90 ? ackP90 : p90) * MQTT_RESPONSE_FACTOR;
+    timeout = timeout < MQTT_RESPONSE_TIMEOUT_MIN_MS ? MQTT_RESPONSE_TIMEOUT_MIN_MS : timeout;
+    return timeout < limit ? timeout : limit;
+}
+
+uint16_t ActiveMQClientService::getSocketTimeout() const
+{
+    return constrain((getResponseTimeout() + 999) / 1000, 2UL, 15UL);
+}
+
+void ActiveMQClientService::setKeepAlive(uint16_t seconds)
+{
+    seconds = constrain(seconds, 2, 600);
+    if (seconds < keepAlive || !mqttClient.connected())
+    {
+        mqttClient.setKeepAlive(seconds);
+    }
+    keepAlive = seconds;
+}
+
+uint16_t ActiveMQClientService::getKeepAlive() const
+{
+    return keepAlive;
+}
+
+const LatencyWindow<MQTT_HEALTH_SAMPLES> &ActiveMQClientService::getPingRtt() const
+{
+    return pingRtt;
+}
+
+const LatencyWindow<MQTT_HEALTH_SAMPLES> &ActiveMQClientService::getAckLatency() const
+{
+    return ackLatency;
+}
+
+const LatencyWindow<8, uint32_t> &ActiveMQClientService::getReconnectTimes() const
+{
+    return reconnectTimes;
+}
+
+uint32_t ActiveMQClientService::getBytesIn() const
+{
+    return linkTap.getBytesIn();
+}
+
+uint32_t ActiveMQClientService::getBytesOut() const
+{
+    return linkTap.getBytesOut();
+}
+
+uint32_t ActiveMQClientService::getPublishFailures() const
+{
+    return publishFailures;
+}
+
+unsigned long ActiveMQClientService::getDownFor() const
+{
+    return downSince ? millis() - downSince : 0;
+}
+
+uint8_t ActiveMQClientService::getInFlight() const
+{
+    return inflight.inFlight();
+}
+
+uint32_t ActiveMQClientService::getRetransmits() const
+{
+    return inflight.getRetransmits();
+}
+
+uint32_t ActiveMQClientService::getExpired() const
+{
+    return inflight.getExpired();
+}
+
 // MQTT loop for processing
 bool ActiveMQClientService::loop()
 {
-    return mqttClient.loop();
+    bool alive = mqttClient.loop();
+    if (alive)
+    {
+        checkResponses();
+    }
+    sendDue();
+    return alive;
 }
 
 // Check if there are messages in the queue
@@ -129,10 +426,127 @@ void ActiveMQClientService::onMessageCallback(char *topic, byte *payload, unsign
 // Helper to handle incoming messages
 void ActiveMQClientService::handleIncomingMessage(const String &topic, const String &message)
 {
-    Serial.println("Processing message from topic: " + topic);
-    Serial.println("Message: " + message);
+    LOG_DEBUG("mqtt", "Received %s: %s", topic.c_str(), message.c_str());
     MQTTMessage mqttMessage = {topic, message};
 
     // Queue the message for later processing
     messageQueue.push(mqttMessage);
 }
+
+MqttLinkTap::MqttLinkTap(Client &inner, void (*onAck)(uint16_t packetId), void (*onPingResponse)(unsigned long rttMs))
+    : inner(inner), onAck(onAck), onPingResponse(onPingResponse), bytesIn(0), bytesOut(0), pingSentAt(0), pingPending(false) {}
+
+int MqttLinkTap::connect(IPAddress ip, uint16_t port)
+{
+    scanner.reset();
+    pingPending = false;
+    return inner.connect(ip, port);
+}
+
+int MqttLinkTap::connect(const char *host, uint16_t port)
+{
+    scanner.reset();
+    pingPending = false;
+    return inner.connect(host, port);
+}
+
+size_t MqttLinkTap::write(uint8_t c)
+{
+    size_t written = inner.write(c);
+    bytesOut += written;
+    return written;
+}
+
+// PubSubClient hands over each packet in one write
+size_t MqttLinkTap::write(const uint8_t *data, size_t size)
+{
+    if (size > 0 && data[0] == MQTT_PINGREQ)
+    {
+        pingSentAt = millis();
+        pingPending = true;
+    }
+    size_t written = inner.write(data, size);
+    bytesOut += written;
+    return written;
+}
+
+int MqttLinkTap::available()
+{
+    return inner.available();
+}
+
+int MqttLinkTap::read()
+{
+    int c = inner.read();
+    if (c >= 0)
+    {
+        inspect((uint8_t)c);
+    }
+    return c;
+}
+
+int MqttLinkTap::read(uint8_t *data, size_t size)
+{
+    int count = inner.read(data, size);
+    for (int i = 0; i < count; i++)
+    {
+        inspect(data[i]);
+    }
+    return count;
+}
+
+void MqttLinkTap::inspect(uint8_t c)
+{
+    bytesIn++;
+    uint16_t packetId = scanner.feed(c);
+    if (packetId != 0)
+    {
+        onAck(packetId);
+    }
+    else if (scanner.completed() == MQTT_PINGRESP && pingPending)
+    {
+        pingPending = false;
+        onPingResponse(millis() - pingSentAt);
+    }
+}
+
+int MqttLinkTap::peek()
+{
+    return inner.peek();
+}
+
+void MqttLinkTap::flush()
+{
+    inner.flush();
+}
+
+void MqttLinkTap::stop()
+{
+    pingPending = false;
+    inner.stop();
+}
+
+uint8_t MqttLinkTap::connected()
+{
+    return inner.connected();
+}
+
+MqttLinkTap::operator bool()
+{
+    return (bool)inner;
+}
+
+uint32_t MqttLinkTap::getBytesIn() const
+{
+    return bytesIn;
+}
+
+uint32_t MqttLinkTap::getBytesOut() const
+{
+    return bytesOut;
+}
+
+unsigned long MqttLinkTap::pingWait(unsigned long now) const
+{
+    return pingPending ? now - pingSentAt : 0;
+}
@@ -4,32 +4,126 @@
 #include <Arduino.h>
 #include <PubSubClient.h>
 #include <queue>
+#include <vector>
 #include <WiFi.h>
 #include <ArduinoJson.h>
+#include "utility/flashString.util.h"
+#include "config.h"
+#include "services/esp-link/espLink.service.h"
+#include "services/broker-resolver/brokerResolver.service.h"
+#include "abstract/mqttInflight.h"
+#include "utility/latencyWindow.util.h"
+
+#define MQTT_TOPIC_MAX 32 // RAM copy of a flash topic while it is handed to PubSubClient
 struct MQTTMessage
 {
     String topic;
     String message;
 };
+
+// Sits between PubSubClient and the socket: watches the inbound stream for
+// PUBACKs and PINGRESPs, which PubSubClient reads and discards, times its
+// PINGREQs and counts the bytes both ways
+class MqttLinkTap : public Client
+{
+public:
+    MqttLinkTap(Client &inner, void (*onAck)(uint16_t packetId), void (*onPingResponse)(unsigned long rttMs));
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char *host, uint16_t port) override;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *data, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t *data, size_t size) override;
+    int peek() override;
+    void flush() override;
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override;
+
+    uint32_t getBytesIn() const;
+    uint32_t getBytesOut() const;
+    // How long the last PINGREQ has gone unanswered, 0 when none is
+    unsigned long pingWait(unsigned long now) const;
+
+private:
+    Client &inner;
+    void (*onAck)(uint16_t packetId);
+    void (*onPingResponse)(unsigned long rttMs);
+    MqttAckScanner scanner;
+    uint32_t bytesIn;
+    uint32_t bytesOut;
+    unsigned long pingSentAt;
+    bool pingPending;
+
+    void inspect(uint8_t c);
+};
+
 class ActiveMQClientService
 {
 public:
     ActiveMQClientService();
     ~ActiveMQClientService();
 
-    void initialize(const char *brokerAddress, int port, const char *clientId);
-    void subscribe(const String &topic);
-    void publish(const String &topic, const JsonDocument &message);
+    // Connects to the resolver's broker, blocks until the first CONNECT succeeds
+    void initialize(BrokerResolverService &resolver, const char *clientId);
+    // Same setup without connecting, reconnect() connects from the loop
+    void attach(BrokerResolverService &resolver);
+    bool reconnect(const char *clientId); // Single attempt, rate limited, keeps the loop running offline.
+    void disconnect();                    // The next reconnect() picks up a moved broker
+    // Topics are flash strings (F("...")), only their address is kept
+    void subscribe(FlashString topic);
+    // QoS 1 goes through the in-flight window and is retransmitted until
+    // acknowledged; it returns false, nothing sent, while the window is full
+    bool publish(FlashString topic, const JsonDocument &message, uint8_t qos = 0);
     bool loop(); // Call this in the main loop for MQTT processing.
 
     bool hasMessage();            // Check if there are messages in the queue.
     MQTTMessage getNextMessage(); // Get the next message from the queue.
     bool isConnected();           // Check if the MQTT client is connected.
+
+    uint8_t getInFlight() const;
+    uint32_t getRetransmits() const;
+    uint32_t getExpired() const;
+
+    // Link health, all times in milliseconds
+    const LatencyWindow<MQTT_HEALTH_SAMPLES> &getPingRtt() const;
+    const LatencyWindow<MQTT_HEALTH_SAMPLES> &getAckLatency() const; // Last send to PUBACK
+    const LatencyWindow<8, uint32_t> &getReconnectTimes() const;     // Link lost to connected again
+    uint32_t getBytesIn() const;
+    uint32_t getBytesOut() const;
+    uint32_t getPublishFailures() const;
+    unsigned long getDownFor() const; // 0 while connected
+
+    // A shorter keepalive applies right away, a longer one with the next
+    // CONNECT (the broker holds us to the negotiated one until then)
+    void setKeepAlive(uint16_t seconds);
+    uint16_t getKeepAlive() const;
+    // A ping or PUBACK outstanding this long closes the socket
+    unsigned long getResponseTimeout() const;
+    uint16_t getSocketTimeout() const; // Seconds, CONNACK and packet reads
 private:    
-    WiFiClient wifiClient;
+#if ESP_PASSTHROUGH
+    EspPassthroughClient netClient; // Broker socket in the module's transparent mode
+#else
+    WiFiClient netClient;
+#endif
+    MqttLinkTap linkTap;
     PubSubClient mqttClient;
+    BrokerResolverService *resolver = nullptr;
+    MqttInflightWindow<MQTT_QOS1_WINDOW, MQTT_QOS1_PACKET_MAX> inflight;
+    LatencyWindow<MQTT_HEALTH_SAMPLES> pingRtt;
+    LatencyWindow<MQTT_HEALTH_SAMPLES> ackLatency;
+    LatencyWindow<8, uint32_t> reconnectTimes;
+    uint32_t publishFailures = 0;
+    unsigned long downSince = 0;
+    uint16_t keepAlive = MQTT_KEEPALIVE_S;
 
     std::queue<MQTTMessage> messageQueue; // Queue to store incoming messages.
+    std::vector<FlashString> subscriptions; // Replayed after a reconnect.
+    unsigned long lastReconnectAttempt = 0;
+    static const unsigned long reconnectInterval = 5000;
 
     // Static pointer to access the class instance
     static ActiveMQClientService *instance;
@@ -37,6 +131,13 @@ private:
     // MQTT callback for handling incoming messages.
     static void onMessageCallback(char *topic, byte *payload, unsigned int length);
 
+    bool connectTo(const IPAddress &address, const char *clientId);
+    bool publishReliable(FlashString topic, const JsonDocument &message);
+    void sendDue(); // At most one packet per call, never waits for an ack
+    static void onPuback(uint16_t packetId);
+    static void onPingResponse(unsigned long rttMs);
+    void checkResponses(); // Closes a socket that stopped answering
+
     // Helper to handle message processing.
     void handleIncomingMessage(const String &topic, const String &message);
 };
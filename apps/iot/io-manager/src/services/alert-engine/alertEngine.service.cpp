@@ -0,0 +1,146 @@
+#include "alertEngine.service.h"
+#include "utility/logger.util.h"
+
+AlertEngineService::AlertEngineService(DiskManagerService &diskManager) : diskManager(diskManager)
+{
+    memset(rules, 0, sizeof(rules));
+    memset(states, 0, sizeof(states));
+}
+
+void AlertEngineService::initialize()
+{
+    // First boot: seed the safety rules once, after that EEPROM is authoritative
+    if (diskManager.read("alert-rules") == "")
+    {
+        loadDefaults();
+        diskManager.save("alert-rules", "1");
+        return;
+    }
+
+    for (uint8_t slot = 0; slot < MAX_ALERT_RULES; slot++)
+    {
+        String encoded = diskManager.read(slotKey(slot));
+        if (encoded.length() > 0 && !decodeRule(encoded, rules[slot]))
+        {
+            LOG_WARN("alert", "Invalid alert rule in %s", slotKey(slot).c_str());
+        }
+    }
+}
+
+void AlertEngineService::loadDefaults()
+{
+    AlertRule rule;
+
+    decodeRule("ph,<,5.0,0.2,60,,", rule);
+    setRule(0, rule);
+    decodeRule("ph,>,7.5,0.2,60,,", rule);
+    setRule(1, rule);
+    decodeRule("wl,=,-1,0,0,,wp-off", rule);
+    setRule(2, rule);
+    decodeRule("lpm,<,0.1,0,10,wp,wp-off", rule);
+    setRule(3, rule);
+}
+
+void AlertEngineService::evaluate(const std::map<std::string, double> &data, unsigned long now)
+{
+    for (uint8_t slot = 0; slot < MAX_ALERT_RULES; slot++)
+    {
+        const AlertRule &rule = rules[slot];
+        if (rule.op == 0)
+        {
+            continue;
+        }
+
+        auto it = data.find(rule.channel);
+        if (it == data.end())
+        {
+            continue;
+        }
+        float value = it->second;
+
+        bool guarded = false;
+        if (rule.guard[0] != 0)
+        {
+            auto guard = data.find(rule.guard);
+            guarded = guard == data.end() || guard->second == 0;
+        }
+
+        AlertTransition transition = alertStep(rule, states[slot], value, guarded, now);
+        if (transition != AlertNone)
+        {
+            pushEvent(slot, transition == AlertRaised, value);
+        }
+    }
+}
+
+void AlertEngineService::pushEvent(uint8_t slot, bool raised, float value)
+{
+    if (events.size() >= MAX_ALERT_EVENTS)
+    {
+        events.pop(); // Drop the oldest, the latest state matters most
+    }
+    events.push({slot, raised, value});
+}
+
+bool AlertEngineService::setRule(uint8_t slot, const AlertRule &rule)
+{
+    if (slot >= MAX_ALERT_RULES)
+    {
+        return false;
+    }
+    rules[slot] = rule;
+    states[slot] = {false, false, false, 0};
+    diskManager.save(slotKey(slot), encodeRule(rule));
+    return true;
+}
+
+void AlertEngineService::clearRule(uint8_t slot)
+{
+    if (slot >= MAX_ALERT_RULES)
+    {
+        return;
+    }
+    memset(&rules[slot], 0, sizeof(AlertRule));
+    states[slot] = {false, false, false, 0};
+    diskManager.remove(slotKey(slot));
+}
+
+const AlertRule &AlertEngineService::getRule(uint8_t slot) const
+{
+    return rules[slot < MAX_ALERT_RULES ? slot : 0];
+}
+
+bool AlertEngineService::isActive(uint8_t slot) const
+{
+    return slot < MAX_ALERT_RULES && states[slot].active;
+}
+
+bool AlertEngineService::hasEvent()
+{
+    return !events.empty();
+}
+
+AlertEvent AlertEngineService::getNextEvent()
+{
+    AlertEvent event = events.front();
+    events.pop();
+    return event;
+}
+
+String AlertEngineService::slotKey(uint8_t slot) const
+{
+    return "alert-rule-" + String(slot);
+}
+
+// "channel,op,threshold,hysteresis,duration,guard,action"
+String AlertEngineService::encodeRule(const AlertRule &rule)
+{
+    return String(rule.channel) + "," + String(rule.op) + "," + String(rule.threshold, 3) + "," +
+           String(rule.hysteresis, 3) + "," + String(rule.durationSec) + "," + String(rule.guard) + "," +
+           String(rule.action);
+}
+
+bool AlertEngineService::decodeRule(const String &encoded, AlertRule &rule)
+{
+    return alertRuleDecode(encoded.c_str(), rule);
+}
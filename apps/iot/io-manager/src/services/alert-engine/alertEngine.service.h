@@ -0,0 +1,51 @@
+#ifndef ALERT_ENGINE_SERVICE_H
+#define ALERT_ENGINE_SERVICE_H
+
+#include <Arduino.h>
+#include <map>
+#include <queue>
+#include <string>
+#include "services/disk-manager/diskManager.service.h"
+#include "utility/alertRule.util.h"
+
+#define MAX_ALERT_RULES 8
+#define MAX_ALERT_EVENTS 8
+
+struct AlertEvent
+{
+    uint8_t slot;
+    bool raised;
+    float value;
+};
+
+class AlertEngineService
+{
+public:
+    AlertEngineService(DiskManagerService &diskManager);
+
+    void initialize();
+    void evaluate(const std::map<std::string, double> &data, unsigned long now);
+
+    bool setRule(uint8_t slot, const AlertRule &rule);
+    void clearRule(uint8_t slot);
+    const AlertRule &getRule(uint8_t slot) const;
+    bool isActive(uint8_t slot) const;
+
+    bool hasEvent();
+    AlertEvent getNextEvent();
+
+    static String encodeRule(const AlertRule &rule);
+    static bool decodeRule(const String &encoded, AlertRule &rule);
+
+private:
+    DiskManagerService &diskManager;
+    AlertRule rules[MAX_ALERT_RULES];
+    AlertState states[MAX_ALERT_RULES];
+    std::queue<AlertEvent> events;
+
+    void pushEvent(uint8_t slot, bool raised, float value);
+    void loadDefaults();
+    String slotKey(uint8_t slot) const;
+};
+
+#endif // ALERT_ENGINE_SERVICE_H
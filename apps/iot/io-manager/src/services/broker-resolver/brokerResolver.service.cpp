@@ -0,0 +1,297 @@
+#include "brokerResolver.service.h"
+#include "utility/dnsMessage.util.h"
+#include "utility/logger.util.h"
+
+BrokerResolverService::BrokerResolverService(DiskManagerService &diskManager)
+    : diskManager(diskManager), port(0), hostHash(0), literal(false), hasResolved(false), stale(false), resolvedAt(0),
+      ttl(0), hasLastKnownGood(false), failures(0), previousPort(0), switching(false), step(Idle), queryId(0), queryStartedAt(0), lastLookupAt(0), lastPollAt(0) {}
+
+void BrokerResolverService::initialize(const char *configuredHost, uint16_t configuredPort)
+{
+    String savedHost = diskManager.read("broker-host");
+    if (savedHost.length() > 0)
+    {
+        long savedPort = diskManager.read("broker-port").toInt();
+        select(savedHost, savedPort > 0 ? savedPort : configuredPort);
+    }
+    else
+    {
+        select(configuredHost, configuredPort);
+    }
+    LOG_INFO("broker", "%s:%u, %s", host.c_str(), port, hasResolved ? format(resolved).c_str() : "not cached");
+}
+
+// Nothing is written until the new broker accepted a CONNECT, a typo or
+// an unreachable broker must not survive a reboot
+void BrokerResolverService::setBroker(const String &newHost, uint16_t newPort)
+{
+    if (newHost == host && newPort == port)
+    {
+        return;
+    }
+    if (switching && newHost == previousHost && newPort == previousPort)
+    {
+        revertSwitch();
+        return;
+    }
+    if (!switching)
+    {
+        previousHost = host;
+        previousPort = port;
+    }
+    select(newHost, newPort);
+    switching = true;
+    LOG_WARN("broker", "Trying %s:%u", host.c_str(), port);
+}
+
+bool BrokerResolverService::isSwitching() const
+{
+    return switching;
+}
+
+void BrokerResolverService::commitSwitch()
+{
+    switching = false;
+    previousHost = String();
+    diskManager.save("broker-host", host);
+    diskManager.save("broker-port", String(port));
+    if (hasResolved && !literal)
+    {
+        diskManager.save("broker-cache", format(resolved) + "," + String(ttl) + "," + String(hostHash));
+    }
+    LOG_WARN("broker", "Moved to %s:%u", host.c_str(), port);
+}
+
+// The previous broker's cache and last known good were never overwritten
+void BrokerResolverService::revertSwitch()
+{
+    LOG_WARN("broker", "%s:%u not reachable, back to %s:%u", host.c_str(), port, previousHost.c_str(), previousPort);
+    switching = false;
+    select(previousHost, previousPort);
+    previousHost = String();
+}
+
+void BrokerResolverService::select(const String &newHost, uint16_t newPort)
+{
+    finishQuery();
+    host = newHost;
+    port = newPort;
+    hostHash = stringHash(host.c_str());
+    literal = resolved.fromString(host);
+    hasResolved = literal;
+    stale = false;
+    hasLastKnownGood = false;
+    failures = 0;
+    lastLookupAt = 0;
+    if (!literal)
+    {
+        load();
+    }
+}
+
+// The cached entry is usable right away but refreshed first thing, the
+// time spent powered off is unknown
+void BrokerResolverService::load()
+{
+    // "a.b.c.d,ttl,hash" and "a.b.c.d,hash"
+    String cache = diskManager.read("broker-cache");
+    int first = cache.indexOf(',');
+    int second = cache.indexOf(',', first + 1);
+    if (first > 0 && second > first && cache.substring(second + 1).toInt() == hostHash &&
+        resolved.fromString(cache.substring(0, first)))
+    {
+        hasResolved = true;
+        stale = true;
+        ttl = cache.substring(first + 1, second).toInt();
+    }
+    String good = diskManager.read("broker-lkg");
+    int comma = good.indexOf(',');
+    if (comma > 0 && good.substring(comma + 1).toInt() == hostHash && lastKnownGood.fromString(good.substring(0, comma)))
+    {
+        hasLastKnownGood = true;
+    }
+}
+
+void BrokerResolverService::loop()
+{
+    if (literal)
+    {
+        return;
+    }
+    unsigned long now = millis();
+    if (step == Idle)
+    {
+        // No UDP while the module carries only the broker socket
+        if (needsLookup(now) && !EspSerial.isPassthrough() && WiFi.status() == WL_CONNECTED)
+        {
+            lastLookupAt = now;
+            startQuery(host.endsWith(".local") ? Mdns : Dns, now);
+        }
+        return;
+    }
+    if (now - lastPollAt < BROKER_POLL_MS)
+    {
+        return;
+    }
+    lastPollAt = now;
+
+    if (udp.parsePacket() > 0)
+    {
+        uint8_t packet[BROKER_PACKET_MAX];
+        int length = udp.read(packet, sizeof(packet));
+        uint8_t address[4];
+        uint32_t answerTtl;
+        if (length > 0 && dnsReadAnswer(packet, length, queryId, address, answerTtl))
+        {
+            finishQuery();
+            store(IPAddress(address[0], address[1], address[2], address[3]), answerTtl);
+            return;
+        }
+    }
+    if (now - queryStartedAt < BROKER_QUERY_TIMEOUT_MS)
+    {
+        return;
+    }
+    if (step == Dns && mdnsName().length() > 0 && startQuery(Mdns, now))
+    {
+        return;
+    }
+    finishQuery();
+    LOG_WARN("broker", "No answer for %s, %s", host.c_str(), hasResolved || hasLastKnownGood ? "keeping the last address" : "retrying later");
+    if (switching && !hasResolved)
+    {
+        reportFailed(); // A new broker that never resolves counts as unreachable
+    }
+}
+
+bool BrokerResolverService::needsLookup(unsigned long now) const
+{
+    bool expired = !hasResolved || stale || now - resolvedAt >= ttl * 1000UL;
+    return expired && (lastLookupAt == 0 || now - lastLookupAt >= BROKER_RETRY_MS);
+}
+
+bool BrokerResolverService::startQuery(Step next, unsigned long now)
+{
+    String name = next == Mdns ? mdnsName() : host;
+    uint8_t packet[BROKER_PACKET_MAX];
+    queryId = (uint16_t)(micros() ^ now) | 1;
+    uint16_t length = dnsWriteQuery(packet, sizeof(packet), name.c_str(), queryId, next == Dns);
+    if (length == 0)
+    {
+        finishQuery();
+        return false;
+    }
+    if (step == Idle && !udp.begin(BROKER_LOCAL_PORT))
+    {
+        return false;
+    }
+    // Home routers forward DNS, mDNS goes to the multicast group
+    IPAddress server = next == Mdns ? IPAddress(224, 0, 0, 251) : WiFi.gatewayIP();
+    udp.beginPacket(server, next == Mdns ? MDNS_PORT : DNS_PORT);
+    udp.write(packet, length);
+    if (!udp.endPacket())
+    {
+        finishQuery();
+        return false;
+    }
+    step = next;
+    queryStartedAt = now;
+    lastPollAt = now;
+    LOG_DEBUG("broker", "%s query for %s", next == Mdns ? "mDNS" : "DNS", name.c_str());
+    return true;
+}
+
+void BrokerResolverService::finishQuery()
+{
+    if (step != Idle)
+    {
+        udp.stop();
+        step = Idle;
+    }
+}
+
+// Written only when the address changes, not on every refresh, and not for
+// a broker still on probation (commitSwitch() writes it)
+void BrokerResolverService::store(const IPAddress &address, uint32_t ttlSeconds)
+{
+    ttl = constrain(ttlSeconds, BROKER_TTL_MIN_S, BROKER_TTL_MAX_S);
+    bool changed = !hasResolved || !(resolved == address);
+    resolved = address;
+    hasResolved = true;
+    stale = false;
+    resolvedAt = millis();
+    if (changed && !switching)
+    {
+        diskManager.save("broker-cache", format(address) + "," + String(ttl) + "," + String(hostHash));
+        LOG_INFO("broker", "%s is %s for %lu s", host.c_str(), format(address).c_str(), (unsigned long)ttl);
+    }
+}
+
+bool BrokerResolverService::getAddress(IPAddress &address) const
+{
+    // While connecting fails, alternate between the answer and the last
+    // address that worked
+    if (hasResolved && (literal || !hasLastKnownGood || failures % 2 == 0))
+    {
+        address = resolved;
+        return true;
+    }
+    if (hasLastKnownGood)
+    {
+        address = lastKnownGood;
+        return true;
+    }
+    return false;
+}
+
+const String &BrokerResolverService::getHost() const
+{
+    return host;
+}
+
+uint16_t BrokerResolverService::getPort() const
+{
+    return port;
+}
+
+void BrokerResolverService::reportConnected(const IPAddress &address)
+{
+    failures = 0;
+    if (switching)
+    {
+        commitSwitch();
+    }
+    if (literal || (hasLastKnownGood && lastKnownGood == address))
+    {
+        return;
+    }
+    lastKnownGood = address;
+    hasLastKnownGood = true;
+    diskManager.save("broker-lkg", format(address) + "," + String(hostHash));
+}
+
+void BrokerResolverService::reportFailed()
+{
+    failures++;
+    stale = !literal;
+    if (switching && failures >= BROKER_SWITCH_ATTEMPTS)
+    {
+        revertSwitch();
+    }
+}
+
+String BrokerResolverService::mdnsName() const
+{
+    if (host.endsWith(".local"))
+    {
+        return host;
+    }
+    return host.indexOf('.') < 0 ? host + ".local" : String();
+}
+
+String BrokerResolverService::format(const IPAddress &address)
+{
+    char text[16];
+    snprintf_P(text, sizeof(text), PSTR("%u.%u.%u.%u"), address[0], address[1], address[2], address[3]);
+    return String(text);
+}
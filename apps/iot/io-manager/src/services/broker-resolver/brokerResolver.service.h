@@ -0,0 +1,90 @@
+#ifndef BROKER_RESOLVER_SERVICE_H
+#define BROKER_RESOLVER_SERVICE_H
+
+#include <Arduino.h>
+#include <WiFiEspAT.h>
+#include "config.h"
+#include "services/disk-manager/diskManager.service.h"
+#include "services/esp-link/espLink.service.h"
+#include "utility/flashString.util.h"
+
+#define BROKER_LOCAL_PORT 49153 // Not 5353, responders then answer by unicast
+#define BROKER_PACKET_MAX 192   // Query or answer, on the stack while in use
+#define BROKER_POLL_MS 50       // A poll is an AT round trip
+
+// Broker address for ActiveMQClientService, so a (re)connect never waits
+// for name resolution. The answer is cached for its TTL and persisted
+// ("broker-cache"). Refreshes run in the background: one UDP query to the
+// gateway's DNS, then a one-shot mDNS query for .local and dotless names,
+// polled from loop(). The address that last carried a CONNECT is kept too
+// ("broker-lkg"); attempts alternate between it and the fresh answer while
+// connecting fails. "set-broker" moves to another broker at runtime: the
+// move is kept in RAM until a CONNECT to the new broker succeeds and only
+// then persisted, after BROKER_SWITCH_ATTEMPTS failures it is undone.
+class BrokerResolverService
+{
+public:
+    BrokerResolverService(DiskManagerService &diskManager);
+
+    // A broker saved with setBroker() wins over the configured one
+    void initialize(const char *host, uint16_t port);
+    void setBroker(const String &host, uint16_t port);
+    bool isSwitching() const; // On probation after setBroker()
+    void loop(); // Never blocks, sends or polls at most one query
+
+    // False until anything is known (cached, resolved or last known good)
+    bool getAddress(IPAddress &address) const;
+    const String &getHost() const;
+    uint16_t getPort() const;
+
+    void reportConnected(const IPAddress &address);
+    void reportFailed(); // Refreshes the answer and tries the last known good next
+
+private:
+    enum Step
+    {
+        Idle,
+        Dns,
+        Mdns
+    };
+
+    DiskManagerService &diskManager;
+    WiFiUDP udp;
+    String host;
+    uint16_t port;
+    uint16_t hostHash; // Ties the persisted entries to the host they belong to
+    bool literal;      // The host is an address, nothing to resolve
+
+    IPAddress resolved;
+    bool hasResolved;
+    bool stale; // Past its TTL, loaded from EEPROM or failed to connect
+    unsigned long resolvedAt;
+    uint32_t ttl; // Seconds
+    IPAddress lastKnownGood;
+    bool hasLastKnownGood;
+    uint8_t failures;
+
+    // The broker in use before setBroker(), until the new one connects
+    String previousHost;
+    uint16_t previousPort;
+    bool switching;
+
+    Step step;
+    uint16_t queryId;
+    unsigned long queryStartedAt;
+    unsigned long lastLookupAt;
+    unsigned long lastPollAt;
+
+    bool needsLookup(unsigned long now) const;
+    bool startQuery(Step next, unsigned long now);
+    void finishQuery();
+    void select(const String &host, uint16_t port);
+    void commitSwitch();
+    void revertSwitch();
+    void store(const IPAddress &address, uint32_t ttlSeconds);
+    void load();
+    String mdnsName() const;
+    static String format(const IPAddress &address);
+};
+
+#endif // BROKER_RESOLVER_SERVICE_H
@@ -1,76 +1,474 @@
 #include "dataCollector.service.h"
+#include "utility/logger.util.h"
 
 #include <Arduino.h>
 #include "context/app.context.h"
 DataCollector *DataCollector::instance = nullptr;
 
-DataCollector::DataCollector() : status("Not Initialized")
+// Sensor visitors, instantiated per concrete sensor type by SensorSet::forEach
+struct InitializeSensor
 {
-    // Add sensors to the vector
+    std::map<std::string, SensorReport> &reports;
+    std::map<std::string, SensorSampling *> &sampling;
 
-    // Add other sensors similarly
+    template <typename Sensor>
+    void operator()(Sensor &sensor)
+    {
+        // Instances of one model are told apart like channels: "YF-S201",
+        // then "YF-S201-2", "YF-S201-3", ...
+        std::string key = sensor.getSensorName();
+        for (char n = '2'; reports.count(key) != 0 && n <= '9'; n++)
+        {
+            key = std::string(sensor.getSensorName()) + "-" + std::string(1, n);
+        }
+        sensor.setUniqueID(key);
+
+        sensor.initialize();
+        SensorReport report = {&sensor.getHealth(), &sensor.getStatusMessage()};
+        reports[key] = report;
+        sampling[key] = &sensor.getSampling();
+        delay(100);
+    }
+};
+
+// First half of a pass: which sensors are due and what they would cost
+struct PlanSensor
+{
+    unsigned long now;
+    uint8_t index;
+    uint8_t dueCount;
+    uint8_t due[SensorSet::count];
+    SensorSampling *schedules[SensorSet::count];
+
+    template <typename Sensor>
+    void operator()(Sensor &sensor)
+    {
+        SensorSampling &schedule = sensor.getSampling();
+        if (sensor.getHealth().allowRead(now) && schedule.isDue(now))
+        {
+            due[dueCount] = index;
+            schedules[dueCount] = &schedule;
+            dueCount++;
+        }
+        index++;
+    }
+};
+
+// One bit per sensor, by visit index
+typedef uint16_t SensorMask;
+static_assert(SensorSet::count <= sizeof(SensorMask) * 8, "SensorMask needs a bit for every sensor, widen it");
+
+// Reads the sensors selected for this pass and adapts their interval.
+// Sensors are visited in dependency order, so derived channels pick up
+// inputs that changed earlier in the same pass.
+struct ReadSensor
+{
+    DataCollector &collector;
+    std::map<std::string, double> &data;
+    unsigned long now;
+    SensorMask selected;
+    unsigned long passStart;
+    uint8_t index;
+    bool readAny;
+
+    template <typename Sensor>
+    void operator()(Sensor &sensor)
+    {
+        uint8_t position = index++;
+        SensorSampling &schedule = sensor.getSampling();
+        SensorHealth &health = sensor.getHealth();
+        if (!health.allowRead(now))
+        {
+            return;
+        }
+        if (!schedule.isDue(now))
+        {
+            sensor.refreshDerived(data);
+            return;
+        }
+        // Not selected, or the earlier reads took longer than planned
+        if (!(selected & ((SensorMask)1 << position)) || (readAny && micros() - passStart >= collector.budgetUs))
+        {
+            if (schedule.deferred < 255)
+            {
+                schedule.deferred++;
+            }
+            collector.deferrals++;
+            return;
+        }
+        // The interval counts from the first step of a split read
+        if (!schedule.pending)
+        {
+            schedule.markSampled(now);
+        }
+        schedule.pending = false;
+        schedule.deferred = 0;
+        readAny = true;
+
+        bool changing = false;
+        bool plausible = true;
+        double signature = 0;
+        unsigned long readStart = micros();
+        auto sensorData = sensor.readData();
+        schedule.recordCost(micros() - readStart);
+        if (schedule.pending)
+        {
+            return; // More steps follow, no result and no health verdict yet
+        }
+        for (const auto &entry : sensorData)
+        {
+            // Implausible values are dropped, the last good one stays in the snapshot
+            if (!sensor.isPlausible(entry.first, entry.second))
+            {
+                plausible = false;
+                continue;
+            }
+            data[entry.first] = entry.second;
+            signature += entry.second;
+            collector.channelSensors[entry.first] = sensor.getUniqueID();
+            changing = changing || collector.isChanging(entry.first, entry.second);
+        }
+        if (schedule.adaptive)
+        {
+            schedule.adapt(changing);
+        }
+
+        SensorHealth::State before = health.state;
+        if (sensorData.empty())
+        {
+            health.recordFailure(now, schedule.currentMs, "no data");
+        }
+        else if (!plausible)
+        {
+            health.recordFailure(now, schedule.currentMs, "range");
+        }
+        else
+        {
+            health.recordSuccess(now, signature);
+        }
+        if (health.state != before)
+        {
+            collector.healthChanged = true;
+            LOG_WARN("sensor", "%s health %s (%s)", sensor.getUniqueID().c_str(),
+                     SensorHealth::stateName(health.state), health.reason);
+        }
+    }
+};
+
+DataCollector::DataCollector()
+    : shortRollup("1m", ROLLUP_SHORT_PERIOD_MS),
+      longRollup("5m", ROLLUP_LONG_PERIOD_MS),
+      status("Not Initialized")
+{
     instance = this;
 }
 
 DataCollector::~DataCollector()
 {
     instance = nullptr;
-    // Manually delete the sensors to free memory
-    for (auto sensor : sensors)
-    {
-        delete sensor;
-    }
 }
 
 void DataCollector::initializeSensors()
 {
     status = "Initializing";
-    auto waterTempSensor = new WaterTemperatureSensor(17); //  DS18B20 is connected to pin 17
-    auto phSensor = new PHSensor(A6, *waterTempSensor);
-    sensors.push_back(waterTempSensor);
-    sensors.push_back(new DHT11Sensor(16));          //  DHT11 is connected to pin 16
-    sensors.push_back(new WaterLevelSensor(14, 15)); //  water level sensors are connected to pins 14 and 15
-    sensors.push_back(new GravityTDSMeter(A7, *waterTempSensor));
-    sensors.push_back(phSensor);               //  pH sensor is connected to pin A6
-    sensors.push_back(new WaterFlowSensor(2)); //  water flow sensor is connected to pin 18
-    // Initialize each sensor if needed
-    for (auto sensor : sensors)
-    {
-        sensor->initialize();
-        delay(100);
-    }
+    // Sensors and their pins are declared in sensors/sensors.config.h
+    InitializeSensor initializer = {reports, sampling};
+    sensors.forEach(initializer);
     status = "Active";
 }
 
-std::map<std::string, double> DataCollector::collectData()
+bool DataCollector::collectData()
 {
+    unsigned long now = millis();
+    unsigned long passStart = micros();
+
+    PlanSensor plan;
+    plan.now = now;
+    plan.index = 0;
+    plan.dueCount = 0;
+    sensors.forEach(plan);
+    if (plan.dueCount == 0)
+    {
+        return false;
+    }
+
+    // Highest priority first, aged by consecutive deferrals so every sensor
+    // eventually leads a pass (round-robin among equals). The leader always
+    // runs, the rest only while the planned cost fits the budget.
+    SensorMask selected = 0;
+    uint32_t plannedUs = 0;
+    bool taken[SensorSet::count] = {false};
+    for (uint8_t round = 0; round < plan.dueCount; round++)
+    {
+        int best = -1;
+        for (uint8_t i = 0; i < plan.dueCount; i++)
+        {
+            if (taken[i])
+            {
+                continue;
+            }
+            const SensorSampling *candidate = plan.schedules[i];
+            if (best < 0 || candidate->priority + candidate->deferred > plan.schedules[best]->priority + plan.schedules[best]->deferred)
+            {
+                best = i;
+            }
+        }
+        taken[best] = true;
+        uint32_t cost = plan.schedules[best]->costUs;
+        if (selected == 0 || plannedUs + cost <= budgetUs)
+        {
+            selected |= (SensorMask)1 << plan.due[best];
+            plannedUs += cost;
+        }
+    }
+
     std::map<std::string, double> data;
-    for (auto sensor : sensors)
+    ReadSensor reader = {*this, data, now, selected, passStart, 0, false};
+    sensors.forEach(reader);
+
+    lastPassUs = micros() - passStart;
+    if (lastPassUs > maxPassUs)
     {
-        auto sensorData = sensor->readData();
-        for (const auto &entry : sensorData)
+        maxPassUs = lastPassUs;
+    }
+    if (lastPassUs > budgetUs)
+    {
+        overruns++;
+    }
+    if (data.empty())
+    {
+        return false;
+    }
+
+    // Stats and rollups only see fresh samples, each channel at its own rate
+    for (const auto &entry : data)
+    {
+        auto it = stats.find(entry.first);
+        if (it == stats.end())
         {
-            data[entry.first] = entry.second;
+            it = stats.insert(std::make_pair(entry.first, ChannelStats())).first;
+            it->second.setWindow(statsWindow);
         }
+        it->second.add(entry.second, now);
     }
-    // app context module manager
+
+    // Pump states are 0/1, rolling statistics would only cost SRAM
     AppContext &appContext = AppContext::getInstance();
     data["ap"] = (std::string(appContext.moduleManager->airPump->getStatus()) == "On" ? 1.0 : 0.0);
     data["wp"] = (std::string(appContext.moduleManager->waterPump->getStatus()) == "On" ? 1.0 : 0.0);
+    shortRollup.add(data, now);
+    longRollup.add(data, now);
 
-    previousData = currentData;
-    currentData = data;
-    return data;
+    snapshot.publish(data, now);
+    return true;
 }
 
-void DataCollector::printData(const std::map<std::string, double> data)
+// A step larger than the usual spread, or any step on a channel without spread
+bool DataCollector::isChanging(const std::string &channel, double value) const
 {
-    for (const auto &entry : data)
+    auto last = snapshot.getValues().find(channel);
+    if (last == snapshot.getValues().end())
     {
-        Serial.print(entry.first.c_str());
-        Serial.print(": ");
-        Serial.println(entry.second);
+        return false;
     }
+    const ChannelStats *channelStats = getStats(channel);
+    double threshold = channelStats ? 2.0 * sqrt(channelStats->getVariance()) : 0;
+    return fabs(value - last->second) > threshold;
+}
+
+void DataCollector::setBudget(uint32_t microseconds)
+{
+    budgetUs = microseconds;
+}
+
+uint32_t DataCollector::getBudget() const
+{
+    return budgetUs;
+}
+
+uint32_t DataCollector::getOverruns() const
+{
+    return overruns;
+}
+
+uint32_t DataCollector::getDeferrals() const
+{
+    return deferrals;
+}
+
+unsigned long DataCollector::getLastPassUs() const
+{
+    return lastPassUs;
+}
+
+unsigned long DataCollector::getMaxPassUs() const
+{
+    return maxPassUs;
+}
+
+const std::map<std::string, SensorReport> &DataCollector::getHealthReports() const
+{
+    return reports;
+}
+
+bool DataCollector::takeHealthChanged()
+{
+    bool changed = healthChanged;
+    healthChanged = false;
+    return changed;
+}
+
+const std::string *DataCollector::findSensor(const std::string &name) const
+{
+    auto it = sampling.find(name);
+    if (it != sampling.end())
+    {
+        return &it->first;
+    }
+    auto channel = channelSensors.find(name);
+    return channel != channelSensors.end() ? &channel->second : nullptr;
+}
+
+bool DataCollector::setSampling(const std::string &sensor, unsigned long intervalMs, bool adaptive)
+{
+    auto it = sampling.find(sensor);
+    if (it == sampling.end() || intervalMs == 0)
+    {
+        return false;
+    }
+    it->second->configure(intervalMs, adaptive);
+    return true;
+}
+
+bool DataCollector::isAcquiring() const
+{
+    for (const auto &entry : sampling)
+    {
+        if (entry.second->pending)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DataCollector::setAllIntervals(unsigned long intervalMs)
+{
+    for (auto &entry : sampling)
+    {
+        entry.second->configure(intervalMs, entry.second->adaptive);
+    }
+}
+
+const std::map<std::string, SensorSampling *> &DataCollector::getSampling() const
+{
+    return sampling;
+}
+
+const std::map<std::string, std::string> &DataCollector::getChannelSensors() const
+{
+    return channelSensors;
+}
+
+void DataCollector::loadSampling(DiskManagerService &disk)
+{
+    // Settings saved per channel by older firmware move to their sensor
+    for (const auto &entry : channelSensors)
+    {
+        String legacy = disk.read(String("rate-") + entry.first.c_str());
+        if (legacy.length() > 0)
+        {
+            String key = String("rate-") + entry.second.c_str();
+            if (disk.read(key).length() == 0)
+            {
+                disk.save(key, legacy);
+            }
+            disk.remove(String("rate-") + entry.first.c_str());
+        }
+    }
+
+    for (auto &entry : sampling)
+    {
+        // "<interval ms>,<adaptive 0|1>"
+        String saved = disk.read(String("rate-") + entry.first.c_str());
+        int comma = saved.indexOf(',');
+        if (comma > 0)
+        {
+            entry.second->configure(saved.substring(0, comma).toInt(), saved.substring(comma + 1) == "1");
+        }
+    }
+}
+
+const ChannelStats *DataCollector::getStats(const std::string &channel) const
+{
+    auto it = stats.find(channel);
+    return it != stats.end() ? &it->second : nullptr;
+}
+
+const std::map<std::string, ChannelStats> &DataCollector::getAllStats() const
+{
+    return stats;
+}
+
+bool DataCollector::hasExcursion(const TelemetrySnapshot::Values &reference) const
+{
+    for (const auto &entry : snapshot.getValues())
+    {
+        auto sent = reference.find(entry.first);
+        if (sent == reference.end())
+        {
+            return true;
+        }
+
+        // Discrete channels (water level, pumps) have no spread, any change counts
+        const ChannelStats *channelStats = getStats(entry.first);
+        double threshold = channelStats ? EXCURSION_SIGMA * sqrt(channelStats->getVariance()) : 0;
+        if (fabs(entry.second - sent->second) > threshold)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DataCollector::setStatsWindow(uint8_t samples, const std::string &channel)
+{
+    if (!channel.empty())
+    {
+        auto it = stats.find(channel);
+        if (it == stats.end())
+        {
+            return false;
+        }
+        it->second.setWindow(samples);
+        return true;
+    }
+    statsWindow = samples;
+    for (auto &entry : stats)
+    {
+        entry.second.setWindow(samples);
+    }
+    return true;
+}
+
+void DataCollector::printData(const TelemetrySnapshot &data) const
+{
+    for (const auto &entry : data.getValues())
+    {
+        char value[16];
+        dtostrf(entry.second, 1, 2, value);
+        LOG_INFO("data", "%s: %s", entry.first.c_str(), value);
+    }
+}
+
+const TelemetrySnapshot &DataCollector::getSnapshot() const
+{
+    return snapshot;
+}
+
+SensorSet &DataCollector::getSensors()
+{
+    return sensors;
 }
 
 String DataCollector::getStatus()
@@ -3,19 +3,28 @@
 #ifndef DATA_COLLECTOR_SERVICE_H
 #define DATA_COLLECTOR_SERVICE_H
 
-#include "sensor.abstract.class.h"
-#include "sensors/humidity/humidity.sensor.h"
-#include "sensors/water-level/waterLevel.sensor.h"
-#include "sensors/water-temperature/waterTemperature.sensor.h"
-#include "sensors/tds/tds.sensor.h"
-#include "sensors/ph/ph.sensor.h"
-#include "sensors/water-flow/waterFlow.sensor.h"
+#include "sensors/sensors.config.h"
+#include "services/disk-manager/diskManager.service.h"
+#include "utility/rollingStats.util.h"
+#include "utility/rollup.util.h"
+#include "utility/telemetrySnapshot.util.h"
+#include "config.h"
 #include <ArduinoSTL.h>
 #include <map>
 #include <memory>
 #include <vector>
 #include <string>
 
+typedef RollingStats<ROLLING_STATS_CAPACITY> ChannelStats;
+
+// Health of one sensor plus its own status message, keyed by the sensor's
+// unique id (its name, with a "-2", "-3", ... suffix for further instances)
+struct SensorReport
+{
+    const SensorHealth *health;
+    const std::string *status;
+};
+
 class DataCollector
 {
 public:
@@ -23,19 +32,76 @@ public:
     ~DataCollector();
 
     void initializeSensors();
-    std::map<std::string, double> collectData();
+    // Reads the sensors whose interval elapsed, within the time budget.
+    // False when nothing was read.
+    bool collectData();
+    // True while a sensor is part way through a read split across passes
+    bool isAcquiring() const;
+
+    // Per-pass acquisition budget and what it cost
+    void setBudget(uint32_t microseconds);
+    uint32_t getBudget() const;
+    uint32_t getOverruns() const;  // Passes that ran past the budget
+    uint32_t getDeferrals() const; // Due reads pushed to a later pass
+    unsigned long getLastPassUs() const;
+    unsigned long getMaxPassUs() const;
     static DataCollector *getInstance();
-    void printData(const std::map<std::string, double> data);
+    void printData(const TelemetrySnapshot &data) const;
     String getStatus();
-    std::map<std::string, double> currentData;
 
-    std::map<std::string, double> previousData;
-    PHSensor *phSensor;
+    // Latest value of every channel, versioned per acquisition
+    const TelemetrySnapshot &getSnapshot() const;
+
+    SensorSet &getSensors();
+
+    // Rolling window statistics, updated on every collectData()
+    const ChannelStats *getStats(const std::string &channel) const;
+    const std::map<std::string, ChannelStats> &getAllStats() const;
+    // One window per channel, an empty channel sets every window and the
+    // length later channels start with
+    bool setStatsWindow(uint8_t samples, const std::string &channel = std::string());
+
+    // Edge-side 1/5 minute rollups, fed by collectData()
+    TimeRollup shortRollup;
+    TimeRollup longRollup;
+
+    // True when a channel moved beyond EXCURSION_SIGMA since the reference frame
+    bool hasExcursion(const TelemetrySnapshot::Values &reference) const;
+
+    // Per-sensor sampling, keyed by unique id. findSensor() also takes any
+    // channel the sensor reports, those are known after the first collectData().
+    const std::string *findSensor(const std::string &name) const;
+    bool setSampling(const std::string &sensor, unsigned long intervalMs, bool adaptive);
+    void setAllIntervals(unsigned long intervalMs);
+    const std::map<std::string, SensorSampling *> &getSampling() const;
+    const std::map<std::string, std::string> &getChannelSensors() const;
+    // Per-sensor health, filled by initializeSensors()
+    const std::map<std::string, SensorReport> &getHealthReports() const;
+    // True once after any sensor changed health state
+    bool takeHealthChanged();
+
+    // Applies the "rate-<unique id>" settings saved by the set-sensor-interval command
+    void loadSampling(DiskManagerService &disk);
 
 private:
+    friend struct ReadSensor;
     static DataCollector *instance;
-    std::vector<AbstractSensor *> sensors;
+    SensorSet sensors;
+    TelemetrySnapshot snapshot;
     String status;
+    std::map<std::string, ChannelStats> stats;
+    uint8_t statsWindow = ROLLING_STATS_CAPACITY;
+    std::map<std::string, SensorSampling *> sampling;   // By sensor name
+    std::map<std::string, std::string> channelSensors; // Channel to sensor name
+    std::map<std::string, SensorReport> reports;
+    bool healthChanged = false;
+    uint32_t budgetUs = SENSOR_BUDGET_US;
+    uint32_t overruns = 0;
+    uint32_t deferrals = 0;
+    unsigned long lastPassUs = 0;
+    unsigned long maxPassUs = 0;
+
+    bool isChanging(const std::string &channel, double value) const;
 };
 
 #endif // DATA_COLLECTOR_SERVICE_H
\ No newline at end of file
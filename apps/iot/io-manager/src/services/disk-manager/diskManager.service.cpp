@@ -1,4 +1,5 @@
 #include "diskManager.service.h"
+#include "utility/logger.util.h"
 #include <algorithm>
 
 DiskManagerService *DiskManagerService::instance = nullptr;
@@ -33,14 +34,14 @@ void DiskManagerService::save(const String &key, const String &value)
         keyAddress = findEmptyAddress();
         if (keyAddress == -1)
         { // No empty space
-            Serial.println("Error: No space left in EEPROM.");
+            LOG_ERROR("disk", "No space left in EEPROM");
             return;
         }
 
-        writeString(keyAddress, key); // Save the key
+        writeString(keyAddress, key, MAX_KEY_LENGTH); // Save the key
     }
 
-    writeString(keyAddress + MAX_KEY_LENGTH, value); // Save the value
+    writeString(keyAddress + MAX_KEY_LENGTH, value, MAX_VALUE_LENGTH); // Save the value
     EEPROM.end();
 }
 
@@ -83,7 +84,7 @@ void DiskManagerService::reserveBlock(int startAddress, int size)
     {
         if (i < EEPROM_SIZE)
         {
-            EEPROM.write(i, 0xFF);
+            EEPROM.update(i, 0xFF);
         }
     }
     EEPROM.end();
@@ -127,25 +128,25 @@ int DiskManagerService::findEmptyAddress()
     return -1; // No empty address found
 }
 
-void DiskManagerService::writeString(int address, const String &data)
+void DiskManagerService::writeString(int address, const String &data, unsigned int maxLength)
 {
     if (address < RESERVED_END + 1 || address >= EEPROM_SIZE)
     {
-        Serial.println("Error: Invalid EEPROM address: " + String(address));
+        LOG_ERROR("disk", "Invalid EEPROM address %d", address);
         return;
     }
 
-    unsigned int maxLength = MAX_KEY_LENGTH; // Adjust for value if needed
-    int length = std::min(data.length(), maxLength);
+    // Keep room for the null terminator inside the slot
+    int length = std::min(data.length(), maxLength - 1);
 
-    // Write each character
+    // Write each character, update() skips unchanged cells to spare EEPROM wear
     for (int i = 0; i < length; i++)
     {
-        EEPROM.write(address + i, data[i]);
+        EEPROM.update(address + i, data[i]);
     }
 
     // Null-terminate the string
-    EEPROM.write(address + length, 0);
+    EEPROM.update(address + length, 0);
 }
 
 String DiskManagerService::readString(int address)
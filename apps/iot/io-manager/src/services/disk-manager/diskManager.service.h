@@ -20,12 +20,12 @@ public:
 
     // Reserve blocks for specific modules/sensors
     void reserveBlock(int startAddress, int size);
-    DiskManagerService *getInstance();
+    static DiskManagerService *getInstance();
 private:
     static DiskManagerService *instance;
     int findKeyAddress(const String &key);
     int findEmptyAddress();
-    void writeString(int address, const String &data);
+    void writeString(int address, const String &data, unsigned int maxLength);
     String readString(int address);
 
     const int EEPROM_SIZE = 4096; // Adjust based on your EEPROM size
@@ -0,0 +1,261 @@
+#include "espLink.service.h"
+#include "utility/logger.util.h"
+
+EspUart EspSerial;
+
+#if defined(USART1_RX_vect)
+ISR(USART1_RX_vect)
+{
+    EspSerial.onReceive();
+}
+#endif
+
+EspUart::EspUart() : baud(0), hardwareOverruns(0), rtsPort(nullptr), rtsMask(0), passthrough(false) {}
+
+void EspUart::begin(uint32_t rate)
+{
+#if ESP_RTS_PIN >= 0
+    pinMode(ESP_RTS_PIN, OUTPUT);
+    digitalWrite(ESP_RTS_PIN, LOW);
+    rtsPort = portOutputRegister(digitalPinToPort(ESP_RTS_PIN));
+    rtsMask = digitalPinToBitMask(ESP_RTS_PIN);
+#endif
+    setBaud(rate);
+}
+
+void EspUart::setBaud(uint32_t rate)
+{
+    flush();
+    baud = rate;
+#if defined(USART1_RX_vect)
+    // Double speed mode, same rounding as the core's HardwareSerial
+    UCSR1B = 0;
+    UCSR1A = _BV(U2X1);
+    UBRR1 = (uint16_t)((F_CPU / 4 / rate - 1) / 2);
+    UCSR1C = _BV(UCSZ11) | _BV(UCSZ10); // 8N1
+    UCSR1B = _BV(RXEN1) | _BV(TXEN1) | _BV(RXCIE1);
+#else
+    Serial1.begin(rate);
+#endif
+    rx.clear();
+}
+
+uint32_t EspUart::getBaud() const
+{
+    return baud;
+}
+
+void EspUart::onReceive()
+{
+#if defined(USART1_RX_vect)
+    if (UCSR1A & _BV(DOR1))
+    {
+        hardwareOverruns++;
+    }
+    rx.push(UDR1);
+#endif
+    updateRts();
+}
+
+int EspUart::available()
+{
+#if !defined(USART1_RX_vect)
+    while (Serial1.available() > 0)
+    {
+        rx.push(Serial1.read());
+    }
+#endif
+    return rx.size();
+}
+
+int EspUart::read()
+{
+    available();
+    int c = rx.pop();
+    if (rtsPort != nullptr)
+    {
+        // The ISR writes the same port register
+        noInterrupts();
+        updateRts();
+        interrupts();
+    }
+    return c;
+}
+
+int EspUart::peek()
+{
+    available();
+    return rx.peek();
+}
+
+size_t EspUart::write(uint8_t c)
+{
+#if defined(USART1_RX_vect)
+    while (!(UCSR1A & _BV(UDRE1)))
+    {
+    }
+    UCSR1A = (UCSR1A & _BV(U2X1)) | _BV(TXC1); // Clear TXC for flush()
+    UDR1 = c;
+    return 1;
+#else
+    return Serial1.write(c);
+#endif
+}
+
+size_t EspUart::write(const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        write(data[i]);
+    }
+    return size;
+}
+
+void EspUart::flush()
+{
+#if defined(USART1_RX_vect)
+    if (UCSR1B & _BV(TXEN1))
+    {
+        while (!(UCSR1A & _BV(UDRE1)) || !(UCSR1A & _BV(TXC1)))
+        {
+        }
+    }
+#else
+    Serial1.flush();
+#endif
+}
+
+unsigned long EspUart::now() const
+{
+    return millis();
+}
+
+void EspUart::wait(unsigned long ms)
+{
+    delay(ms);
+}
+
+uint16_t EspUart::getOverruns()
+{
+    noInterrupts();
+    uint16_t total = hardwareOverruns + rx.getDropped();
+    interrupts();
+    return total;
+}
+
+bool EspUart::isPassthrough() const
+{
+    return passthrough;
+}
+
+void EspUart::setPassthrough(bool enabled)
+{
+    passthrough = enabled;
+}
+
+void EspUart::endPassthrough()
+{
+    if (!passthrough)
+    {
+        return;
+    }
+    AtLink<EspUart> link(*this);
+    link.leavePassthrough();
+    passthrough = false;
+    LOG_INFO("esp", "Passthrough closed");
+}
+
+// High (module holds its output) above three quarters, low again below one
+// quarter; called from the ISR and, interrupts masked, after every read
+void EspUart::updateRts()
+{
+    if (rtsPort == nullptr)
+    {
+        return;
+    }
+    uint16_t queued = rx.size();
+    if (queued >= rx.capacity() * 3 / 4)
+    {
+        *rtsPort |= rtsMask;
+    }
+    else if (queued <= rx.capacity() / 4)
+    {
+        *rtsPort &= ~rtsMask;
+    }
+}
+
+int EspPassthroughClient::connect(IPAddress ip, uint16_t port)
+{
+    char host[16];
+    snprintf_P(host, sizeof(host), PSTR("%u.%u.%u.%u"), ip[0], ip[1], ip[2], ip[3]);
+    return connect(host, port);
+}
+
+int EspPassthroughClient::connect(const char *host, uint16_t port)
+{
+    EspSerial.endPassthrough();
+    AtLink<EspUart> link(EspSerial);
+    if (!link.enterPassthrough(host, port))
+    {
+        LOG_WARN("esp", "Passthrough to %s:%u failed", host, port);
+        return 0;
+    }
+    EspSerial.setPassthrough(true);
+    LOG_INFO("esp", "Passthrough to %s:%u", host, port);
+    return 1;
+}
+
+size_t EspPassthroughClient::write(uint8_t c)
+{
+    return EspSerial.isPassthrough() ? EspSerial.write(c) : 0;
+}
+
+size_t EspPassthroughClient::write(const uint8_t *data, size_t size)
+{
+    return EspSerial.isPassthrough() ? EspSerial.write(data, size) : 0;
+}
+
+int EspPassthroughClient::available()
+{
+    return EspSerial.isPassthrough() ? EspSerial.available() : 0;
+}
+
+int EspPassthroughClient::read()
+{
+    return EspSerial.isPassthrough() ? EspSerial.read() : -1;
+}
+
+int EspPassthroughClient::read(uint8_t *data, size_t size)
+{
+    size_t count = 0;
+    while (count < size && available() > 0)
+    {
+        data[count++] = (uint8_t)read();
+    }
+    return count > 0 ? (int)count : -1;
+}
+
+int EspPassthroughClient::peek()
+{
+    return EspSerial.isPassthrough() ? EspSerial.peek() : -1;
+}
+
+void EspPassthroughClient::flush()
+{
+    EspSerial.flush();
+}
+
+void EspPassthroughClient::stop()
+{
+    EspSerial.endPassthrough();
+}
+
+uint8_t EspPassthroughClient::connected()
+{
+    return EspSerial.isPassthrough();
+}
+
+EspPassthroughClient::operator bool()
+{
+    return EspSerial.isPassthrough();
+}
@@ -0,0 +1,82 @@
+#ifndef ESP_LINK_SERVICE_H
+#define ESP_LINK_SERVICE_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include "config.h"
+#include "abstract/byteRing.h"
+#include "abstract/atLink.h"
+
+// USART1 to the ESP8266 AT firmware, replacing Serial1 (never reference
+// Serial1 together with this, both own the USART1 receive vector). The
+// receive ISR fills a ESP_RX_RING_SIZE ring instead of the core's 64 bytes,
+// and with ESP_RTS_PIN wired to the module's CTS the ISR holds the module
+// back before the ring overflows. Transmit is polled, at the negotiated
+// rate a byte takes a few microseconds.
+class EspUart : public Stream
+{
+public:
+    EspUart();
+
+    void begin(uint32_t baud);
+    void setBaud(uint32_t baud);
+    uint32_t getBaud() const;
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *data, size_t size) override;
+    void flush() override;
+    using Print::write;
+
+    // AtLink port interface
+    unsigned long now() const;
+    void wait(unsigned long ms);
+
+    // Bytes lost to a full ring or a hardware overrun since boot
+    uint16_t getOverruns();
+
+    // Set while the broker socket runs in transparent mode, WiFiEspAT must
+    // not send AT commands then (they would go to the broker)
+    bool isPassthrough() const;
+    void setPassthrough(bool passthrough);
+    // Closes the transparent socket, blocks for the two "+++" guard seconds
+    void endPassthrough();
+
+    void onReceive(); // USART1 receive ISR
+
+private:
+    ByteRing<ESP_RX_RING_SIZE> rx;
+    uint32_t baud;
+    volatile uint16_t hardwareOverruns;
+    volatile uint8_t *rtsPort;
+    uint8_t rtsMask;
+    bool passthrough;
+
+    void updateRts();
+};
+
+extern EspUart EspSerial;
+
+// Client for PubSubClient over the transparent mode of the AT firmware:
+// one TCP socket, bytes go to the broker as they are, no AT+CIPSEND framing
+// and no AT+CIPRECVDATA polling per packet (ESP_PASSTHROUGH).
+class EspPassthroughClient : public Client
+{
+public:
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char *host, uint16_t port) override;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *data, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t *data, size_t size) override;
+    int peek() override;
+    void flush() override;
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override;
+};
+
+#endif // ESP_LINK_SERVICE_H
@@ -28,10 +28,28 @@ void ModuleManager::initializeModules(DataCollector *dataCollector, WiFiService
     lcd->initialize();
     waterPump->initialize();
     airPump->initialize();
+    // The pumps set up relays 0 and 1, the spare relays have no module
+    for (size_t i = 2; i < relays.size(); i++)
+    {
+        relays.at(i)->initialize();
+    }
 }
 
 void ModuleManager::setMqttService(ActiveMQClientService *mqttService)
 {
     // This can be called later to update the MQTT service reference if needed
     // Currently not used since we pass it during initialization
-}
\ No newline at end of file
+}
+
+AbstractModule *ModuleManager::getActuator(uint8_t index)
+{
+    switch (index)
+    {
+    case 0:
+        return waterPump;
+    case 1:
+        return airPump;
+    default:
+        return index < relays.size() ? relays.at(index) : nullptr;
+    }
+}
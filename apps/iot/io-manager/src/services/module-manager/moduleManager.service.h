@@ -22,6 +22,10 @@ public:
     void initializeModules(DataCollector *dataCollector, WiFiService *wifiService, ActiveMQClientService *mqttService = nullptr);
     void setMqttService(ActiveMQClientService *mqttService);
 
+    // Switchable outputs by index: 0 water pump, 1 air pump, 2-3 spare relays
+    AbstractModule *getActuator(uint8_t index);
+    static const uint8_t actuatorCount = 4;
+
     // Public references to all modules
     PumpModule *waterPump;
     std::vector<SingleRelay *> relays;
@@ -0,0 +1,224 @@
+#include "scheduler.service.h"
+#include "utility/logger.util.h"
+
+SchedulerService::SchedulerService(DiskManagerService &diskManager, ModuleManager &moduleManager, const WallClock &wallClock)
+    : diskManager(diskManager), moduleManager(moduleManager), wallClock(wallClock)
+{
+    memset(schedules, 0, sizeof(schedules));
+    memset(states, 0, sizeof(states));
+}
+
+void SchedulerService::initialize()
+{
+    unsigned long now = millis();
+    for (uint8_t actuator = 0; actuator < ModuleManager::actuatorCount; actuator++)
+    {
+        String encoded = diskManager.read(slotKey(actuator));
+        if (encoded.length() > 0 && !decodeSchedule(encoded, schedules[actuator]))
+        {
+            LOG_WARN("schedule", "Invalid schedule in %s", slotKey(actuator).c_str());
+        }
+        states[actuator].cycleStart = now;
+    }
+}
+
+void SchedulerService::update(unsigned long now)
+{
+    for (uint8_t actuator = 0; actuator < ModuleManager::actuatorCount; actuator++)
+    {
+        const ActuatorSchedule &schedule = schedules[actuator];
+        ScheduleState &state = states[actuator];
+        if (!schedule.enabled)
+        {
+            continue;
+        }
+
+        bool scheduled = wantsOn(actuator, now);
+
+        // Max-runtime guard holds the output off until the on phase ends
+        if (state.on && schedule.maxRuntimeSec != 0 && now - state.lastSwitch >= schedule.maxRuntimeSec * 1000UL)
+        {
+            state.tripped = true;
+        }
+        if (state.tripped && !scheduled)
+        {
+            state.tripped = false;
+        }
+
+        bool want = scheduled && !state.tripped && !state.inhibited;
+        if (want == state.on)
+        {
+            continue;
+        }
+
+        // Inhibit (alert) switches off immediately, everything else honours the minimum times
+        unsigned long held = now - state.lastSwitch;
+        if (!state.inhibited && state.on && held < schedule.minOnSec * 1000UL)
+        {
+            continue;
+        }
+        if (!state.on && state.lastSwitch != 0 && held < schedule.minOffSec * 1000UL)
+        {
+            continue;
+        }
+
+        switchActuator(actuator, want, now);
+    }
+}
+
+bool SchedulerService::wantsOn(uint8_t actuator, unsigned long now) const
+{
+    const ActuatorSchedule &schedule = schedules[actuator];
+    if (!inWindow(schedule, now))
+    {
+        return false;
+    }
+    if (schedule.offSec == 0)
+    {
+        return true;
+    }
+
+    unsigned long period = (schedule.onSec + (unsigned long)schedule.offSec) * 1000UL;
+    return (now - states[actuator].cycleStart) % period < schedule.onSec * 1000UL;
+}
+
+bool SchedulerService::inWindow(const ActuatorSchedule &schedule, unsigned long now) const
+{
+    // Without a clock, keep cycling all day rather than leaving crops dry
+    if (!wallClock.isSynced() || schedule.windowStartMin == schedule.windowEndMin)
+    {
+        return true;
+    }
+
+    // time-sync sends local time, the epoch carries it as is
+    uint16_t minuteOfDay = (wallClock.at(now) % 86400UL) / 60;
+
+    if (schedule.windowStartMin < schedule.windowEndMin)
+    {
+        return minuteOfDay >= schedule.windowStartMin && minuteOfDay < schedule.windowEndMin;
+    }
+    // Window wraps past midnight
+    return minuteOfDay >= schedule.windowStartMin || minuteOfDay < schedule.windowEndMin;
+}
+
+void SchedulerService::switchActuator(uint8_t actuator, bool on, unsigned long now)
+{
+    AbstractModule *module = moduleManager.getActuator(actuator);
+    if (module == nullptr)
+    {
+        return;
+    }
+    module->setPower(on);
+    states[actuator].on = on;
+    states[actuator].lastSwitch = now;
+}
+
+bool SchedulerService::setSchedule(uint8_t actuator, const ActuatorSchedule &schedule)
+{
+    if (actuator >= ModuleManager::actuatorCount)
+    {
+        return false;
+    }
+    schedules[actuator] = schedule;
+    states[actuator].tripped = false;
+    states[actuator].cycleStart = millis();
+    diskManager.save(slotKey(actuator), encodeSchedule(schedule));
+    return true;
+}
+
+void SchedulerService::clearSchedule(uint8_t actuator)
+{
+    if (actuator >= ModuleManager::actuatorCount)
+    {
+        return;
+    }
+    if (states[actuator].on)
+    {
+        switchActuator(actuator, false, millis());
+    }
+    memset(&schedules[actuator], 0, sizeof(ActuatorSchedule));
+    diskManager.remove(slotKey(actuator));
+}
+
+const ActuatorSchedule &SchedulerService::getSchedule(uint8_t actuator) const
+{
+    return schedules[actuator < ModuleManager::actuatorCount ? actuator : 0];
+}
+
+void SchedulerService::setInhibited(uint8_t actuator, bool inhibited)
+{
+    if (actuator < ModuleManager::actuatorCount)
+    {
+        states[actuator].inhibited = inhibited;
+    }
+}
+
+bool SchedulerService::isClockSynced() const
+{
+    return wallClock.isSynced();
+}
+
+String SchedulerService::slotKey(uint8_t actuator) const
+{
+    return "schedule-" + String(actuator);
+}
+
+// "on,off,start,end,minOn,minOff,maxRuntime"
+String SchedulerService::encodeSchedule(const ActuatorSchedule &schedule)
+{
+    return String(schedule.onSec) + "," + String(schedule.offSec) + "," + String(schedule.windowStartMin) + "," +
+           String(schedule.windowEndMin) + "," + String(schedule.minOnSec) + "," + String(schedule.minOffSec) + "," +
+           String(schedule.maxRuntimeSec);
+}
+
+// Every field is required and must be a plain decimal number, toInt()
+// would read an empty or garbled field as 0
+bool SchedulerService::decodeSchedule(const String &encoded, ActuatorSchedule &schedule)
+{
+    long fields[7];
+    int start = 0;
+    for (int i = 0; i < 7; i++)
+    {
+        int end = encoded.indexOf(',', start);
+        if ((end == -1) != (i == 6))
+        {
+            return false; // Too few or too many fields
+        }
+        if (end == -1)
+        {
+            end = encoded.length();
+        }
+        if (end == start || end - start > 5)
+        {
+            return false;
+        }
+        for (int c = start; c < end; c++)
+        {
+            if (!isDigit(encoded[c]))
+            {
+                return false;
+            }
+        }
+        fields[i] = encoded.substring(start, end).toInt();
+        if (fields[i] > 65535)
+        {
+            return false;
+        }
+        start = end + 1;
+    }
+
+    if (fields[0] == 0 || fields[2] >= 1440 || fields[3] >= 1440)
+    {
+        return false;
+    }
+
+    schedule.enabled = true;
+    schedule.onSec = fields[0];
+    schedule.offSec = fields[1];
+    schedule.windowStartMin = fields[2];
+    schedule.windowEndMin = fields[3];
+    schedule.minOnSec = fields[4];
+    schedule.minOffSec = fields[5];
+    schedule.maxRuntimeSec = fields[6];
+    return true;
+}
@@ -0,0 +1,67 @@
+#ifndef SCHEDULER_SERVICE_H
+#define SCHEDULER_SERVICE_H
+
+#include <Arduino.h>
+#include "services/disk-manager/diskManager.service.h"
+#include "services/module-manager/moduleManager.service.h"
+#include "utility/wallClock.util.h"
+
+// One schedule per actuator (see ModuleManager::getActuator)
+struct ActuatorSchedule
+{
+    bool enabled;
+    uint16_t onSec;          // Duty cycle on time
+    uint16_t offSec;         // Duty cycle off time, 0 keeps it on for the whole window
+    uint16_t windowStartMin; // Minutes since midnight, start == end means all day
+    uint16_t windowEndMin;
+    uint16_t minOnSec;
+    uint16_t minOffSec;
+    uint16_t maxRuntimeSec; // Forced off after this much continuous runtime, 0 disables
+};
+
+class SchedulerService
+{
+public:
+    // Windows follow `wallClock`, the clock time-sync sets for the whole app
+    SchedulerService(DiskManagerService &diskManager, ModuleManager &moduleManager, const WallClock &wallClock);
+
+    void initialize();
+    void update(unsigned long now);
+
+    bool setSchedule(uint8_t actuator, const ActuatorSchedule &schedule);
+    void clearSchedule(uint8_t actuator);
+    const ActuatorSchedule &getSchedule(uint8_t actuator) const;
+
+    // Alerts can hold an actuator off regardless of its schedule
+    void setInhibited(uint8_t actuator, bool inhibited);
+
+    // Windows are ignored until the wall clock is synced
+    bool isClockSynced() const;
+
+    static String encodeSchedule(const ActuatorSchedule &schedule);
+    static bool decodeSchedule(const String &encoded, ActuatorSchedule &schedule);
+
+private:
+    struct ScheduleState
+    {
+        bool on;
+        bool tripped;
+        bool inhibited;
+        unsigned long lastSwitch;
+        unsigned long cycleStart;
+    };
+
+    DiskManagerService &diskManager;
+    ModuleManager &moduleManager;
+    ActuatorSchedule schedules[ModuleManager::actuatorCount];
+    ScheduleState states[ModuleManager::actuatorCount];
+
+    const WallClock &wallClock;
+
+    bool wantsOn(uint8_t actuator, unsigned long now) const;
+    bool inWindow(const ActuatorSchedule &schedule, unsigned long now) const;
+    void switchActuator(uint8_t actuator, bool on, unsigned long now);
+    String slotKey(uint8_t actuator) const;
+};
+
+#endif // SCHEDULER_SERVICE_H
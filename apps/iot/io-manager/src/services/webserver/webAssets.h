@@ -0,0 +1,70 @@
+// Generated by scripts/embed_assets.py from src/services/webserver/assets, do not edit
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <Arduino.h>
+
+struct WebAsset
+{
+    PGM_P path;
+    PGM_P contentType;
+    const uint8_t *plain;
+    uint16_t plainLength;
+    const uint8_t *gzip;
+    uint16_t gzipLength;
+};
+
+static const char ASSET_INDEX_HTML_PATH[] PROGMEM = "/";
+static const char ASSET_INDEX_HTML_TYPE[] PROGMEM = "text/html";
+static const uint8_t ASSET_INDEX_HTML[] PROGMEM = {
+    0x3c, 0x68, 0x74, 0x6d, 0x6c, 0x3e, 0x3c, 0x62, 0x6f, 0x64, 0x79, 0x3e, 0x3c, 0x66, 0x6f, 0x72,
+    0x6d, 0x20, 0x61, 0x63, 0x74, 0x69, 0x6f, 0x6e, 0x3d, 0x27, 0x2f, 0x73, 0x61, 0x76, 0x65, 0x27,
+    0x20, 0x6d, 0x65, 0x74, 0x68, 0x6f, 0x64, 0x3d, 0x27, 0x50, 0x4f, 0x53, 0x54, 0x27, 0x3e, 0x53,
+    0x53, 0x49, 0x44, 0x3a, 0x20, 0x3c, 0x69, 0x6e, 0x70, 0x75, 0x74, 0x20, 0x74, 0x79, 0x70, 0x65,
+    0x3d, 0x27, 0x74, 0x65, 0x78, 0x74, 0x27, 0x20, 0x6e, 0x61, 0x6d, 0x65, 0x3d, 0x27, 0x73, 0x73,
+    0x69, 0x64, 0x27, 0x3e, 0x3c, 0x62, 0x72, 0x3e, 0x50, 0x61, 0x73, 0x73, 0x77, 0x6f, 0x72, 0x64,
+    0x3a, 0x20, 0x3c, 0x69, 0x6e, 0x70, 0x75, 0x74, 0x20, 0x74, 0x79, 0x70, 0x65, 0x3d, 0x27, 0x74,
+    0x65, 0x78, 0x74, 0x27, 0x20, 0x6e, 0x61, 0x6d, 0x65, 0x3d, 0x27, 0x70, 0x61, 0x73, 0x73, 0x77,
+    0x6f, 0x72, 0x64, 0x27, 0x3e, 0x3c, 0x62, 0x72, 0x3e, 0x3c, 0x69, 0x6e, 0x70, 0x75, 0x74, 0x20,
+    0x74, 0x79, 0x70, 0x65, 0x3d, 0x27, 0x73, 0x75, 0x62, 0x6d, 0x69, 0x74, 0x27, 0x20, 0x76, 0x61,
+    0x6c, 0x75, 0x65, 0x3d, 0x27, 0x53, 0x61, 0x76, 0x65, 0x27, 0x3e, 0x3c, 0x2f, 0x66, 0x6f, 0x72,
+    0x6d, 0x3e, 0x3c, 0x2f, 0x62, 0x6f, 0x64, 0x79, 0x3e, 0x3c, 0x2f, 0x68, 0x74, 0x6d, 0x6c, 0x3e,
+};
+static const uint8_t ASSET_INDEX_HTML_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x7d, 0x8e, 0x3b, 0x0e, 0xc3, 0x20,
+    0x10, 0x44, 0xaf, 0xb2, 0xdd, 0x96, 0xf4, 0x11, 0x50, 0xb9, 0x49, 0x15, 0x4b, 0xe4, 0x02, 0x38,
+    0x10, 0x19, 0xc9, 0x7c, 0xc4, 0x2e, 0x4e, 0x7c, 0xfb, 0x60, 0x3b, 0x4d, 0x9a, 0x54, 0x3b, 0x2b,
+    0xbd, 0x19, 0x3d, 0x39, 0x73, 0x5c, 0xb4, 0x9c, 0xb2, 0xdb, 0xb4, 0x7c, 0xe6, 0x1a, 0xc1, 0x3e,
+    0x38, 0xe4, 0xa4, 0x50, 0x90, 0x5d, 0x3d, 0x42, 0xf4, 0x3c, 0x67, 0xa7, 0x70, 0xbc, 0x99, 0x3b,
+    0x6a, 0x63, 0xae, 0xc3, 0x05, 0x64, 0x48, 0xa5, 0x31, 0xf0, 0x56, 0xbc, 0x42, 0xf6, 0x6f, 0x46,
+    0x48, 0x36, 0xf6, 0x4c, 0x14, 0x1c, 0xf6, 0xb5, 0xaa, 0x47, 0x4b, 0xf4, 0xca, 0xd5, 0xfd, 0x81,
+    0xcb, 0x17, 0x39, 0x0b, 0x3f, 0x18, 0xb5, 0x29, 0x86, 0x0e, 0xae, 0x76, 0x69, 0xfd, 0x35, 0xbb,
+    0x89, 0x96, 0x62, 0xf7, 0xeb, 0xe7, 0x94, 0x15, 0x87, 0xf9, 0x07, 0x4d, 0xbe, 0x86, 0xdb, 0xc0,
+    0x00, 0x00, 0x00,
+};
+
+static const char ASSET_SAVED_HTML_PATH[] PROGMEM = "/saved.html";
+static const char ASSET_SAVED_HTML_TYPE[] PROGMEM = "text/html";
+static const uint8_t ASSET_SAVED_HTML[] PROGMEM = {
+    0x3c, 0x68, 0x74, 0x6d, 0x6c, 0x3e, 0x3c, 0x62, 0x6f, 0x64, 0x79, 0x3e, 0x3c, 0x68, 0x31, 0x3e,
+    0x43, 0x72, 0x65, 0x64, 0x65, 0x6e, 0x74, 0x69, 0x61, 0x6c, 0x73, 0x20, 0x73, 0x61, 0x76, 0x65,
+    0x64, 0x2e, 0x20, 0x50, 0x6c, 0x65, 0x61, 0x73, 0x65, 0x20, 0x72, 0x65, 0x73, 0x74, 0x61, 0x72,
+    0x74, 0x20, 0x74, 0x68, 0x65, 0x20, 0x64, 0x65, 0x76, 0x69, 0x63, 0x65, 0x2e, 0x3c, 0x2f, 0x68,
+    0x31, 0x3e, 0x3c, 0x2f, 0x62, 0x6f, 0x64, 0x79, 0x3e, 0x3c, 0x2f, 0x68, 0x74, 0x6d, 0x6c, 0x3e,
+};
+static const uint8_t ASSET_SAVED_HTML_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x25, 0xcc, 0xd1, 0x09, 0x80, 0x30,
+    0x0c, 0x05, 0xc0, 0x55, 0x32, 0x41, 0x8b, 0xff, 0xa1, 0x3f, 0x2e, 0xe0, 0x0a, 0xd1, 0x3c, 0x68,
+    0x21, 0x55, 0x68, 0x42, 0xc1, 0xed, 0x15, 0x1d, 0xe0, 0x8e, 0x6b, 0x74, 0x2b, 0xbc, 0x5f, 0x7a,
+    0x17, 0xae, 0x4b, 0x59, 0x07, 0x14, 0x67, 0x34, 0x31, 0x27, 0x97, 0x09, 0x4d, 0xb4, 0x19, 0xc4,
+    0x41, 0x03, 0x1e, 0x32, 0x82, 0xa2, 0x82, 0x14, 0xb3, 0x1d, 0x48, 0x9c, 0x5f, 0xc1, 0xf9, 0xc7,
+    0xf9, 0x9b, 0x1e, 0x6e, 0x06, 0xd3, 0x5d, 0x50, 0x00, 0x00, 0x00,
+};
+
+static const WebAsset WEB_ASSETS[] PROGMEM = {
+    {ASSET_INDEX_HTML_PATH, ASSET_INDEX_HTML_TYPE, ASSET_INDEX_HTML, 192, ASSET_INDEX_HTML_GZ, 147},
+    {ASSET_SAVED_HTML_PATH, ASSET_SAVED_HTML_TYPE, ASSET_SAVED_HTML, 80, ASSET_SAVED_HTML_GZ, 91},
+};
+static const uint8_t WEB_ASSET_COUNT = 2;
+
+#endif // WEB_ASSETS_H
@@ -1,6 +1,28 @@
 #include "webserver.service.h"
-#include "utility/parseRequest.util.h"
+#include "utility/logger.util.h"
+#include "utility/httpTokenizer.util.h"
+#include "utility/flashString.util.h"
+#include "utility/textBuffer.util.h"
 #include "context/app.context.h"
+#include "webAssets.h"
+
+// Status lines, content types and error pages stay in flash, the portal
+// pages come from webAssets.h (scripts/embed_assets.py)
+static const char STATUS_OK[] PROGMEM = "200 OK";
+static const char STATUS_BAD_REQUEST[] PROGMEM = "400 Bad Request";
+static const char STATUS_NOT_FOUND[] PROGMEM = "404 Not Found";
+static const char STATUS_TOO_LARGE[] PROGMEM = "413 Payload Too Large";
+static const char STATUS_URI_TOO_LONG[] PROGMEM = "414 URI Too Long";
+static const char STATUS_UNAVAILABLE[] PROGMEM = "503 Service Unavailable";
+static const char TYPE_HTML[] PROGMEM = "text/html";
+static const char TYPE_JSON[] PROGMEM = "application/json";
+static const char TYPE_METRICS[] PROGMEM = "text/plain; version=0.0.4";
+static const char BAD_REQUEST_PAGE[] PROGMEM = "<html><body><h1>400 Bad Request</h1></body></html>";
+static const char TOO_LARGE_PAGE[] PROGMEM = "<html><body><h1>413 Payload Too Large</h1></body></html>";
+static const char NOT_FOUND_PAGE[] PROGMEM = "<html><body><h1>404 Not Found</h1></body></html>";
+static const char NOT_READY_PAGE[] PROGMEM = "<html><body><h1>503 No snapshot yet</h1></body></html>";
+static const char SAVED_PATH[] PROGMEM = "/saved.html";
+
 WebServerService::WebServerService(DiskManagerService &diskManager, WiFiService &wifiService) : server(80), diskManager(diskManager), wifiService(wifiService) {}
 
 void WebServerService::begin()
@@ -8,7 +30,7 @@ void WebServerService::begin()
 
     // Start the server
     server.begin();
-    Serial.println("Server started");
+    LOG_INFO("http", "Server started");
     server.status();
 }
 
@@ -17,189 +39,471 @@ String WebServerService::getState()
     return server.status() == 1 ? "running" : "stopped";
 }
 
+char *WebServerService::beginSnapshot(uint16_t &capacity)
+{
+    if (snapshotReaders > 0)
+    {
+        capacity = 0;
+        return nullptr;
+    }
+    capacity = HTTP_SNAPSHOT_SIZE;
+    snapshotJsonLength = 0;
+    snapshotMetricsLength = 0;
+    return snapshot;
+}
+
+void WebServerService::commitSnapshot(uint16_t jsonLength, uint16_t metricsOffset, uint16_t metricsLength)
+{
+    snapshotJsonLength = jsonLength;
+    snapshotMetricsOffset = metricsOffset;
+    snapshotMetricsLength = metricsLength;
+}
+
+uint8_t WebServerService::getOpenConnections() const
+{
+    uint8_t open = 0;
+    for (const HttpConnection &connection : connections)
+    {
+        open += connection.state != HttpConnection::Free;
+    }
+    return open;
+}
+
 void WebServerService::handleClient()
 {
-    WiFiClient client = server.available();
-    if (!client)
+    accept();
+
+    unsigned long now = millis();
+    bool busy = false;
+    for (HttpConnection &connection : connections)
     {
+        if (connection.state == HttpConnection::Free)
+        {
+            continue;
+        }
+        if (now - connection.lastActivity > HTTP_IDLE_TIMEOUT_MS ||
+            (!connection.client.connected() && connection.carryLength == 0))
+        {
+            LOG_DEBUG("http", "Client timed out or disconnected");
+            close(connection);
+            continue;
+        }
+
+        if (connection.state == HttpConnection::ReadingHeaders || connection.state == HttpConnection::ReadingBody)
+        {
+            receive(connection);
+        }
+        if (connection.state == HttpConnection::Writing)
+        {
+            transmit(connection);
+        }
+        if (connection.state == HttpConnection::Closing)
+        {
+            close(connection);
+        }
+        busy = busy || connection.state != HttpConnection::Free;
+    }
+
+    // Joining the network takes the ESP away from its clients, do it once idle
+    if (pendingConnect && !busy)
+    {
+        pendingConnect = false;
+        wifiService.connectToWiFi(pendingSsid.c_str(), pendingPassword.c_str());
+    }
+}
+
+// Takes a new client only when a slot is free, others wait in the ESP backlog
+void WebServerService::accept()
+{
+    for (HttpConnection &connection : connections)
+    {
+        if (connection.state != HttpConnection::Free)
+        {
+            continue;
+        }
+        WiFiClient client = server.accept();
+        if (!client)
+        {
+            return;
+        }
+        LOG_DEBUG("http", "New client connected");
+        connection.client = client;
+        connection.served = 0;
+        connection.carryLength = 0;
+        connection.lastActivity = millis();
+        startRequest(connection);
         return;
     }
-    client.setTimeout(5000); // 5-second timeout for reading the request
-    Serial.println("New client connected");
+}
 
-    String requestLine = "";
-    int contentLength = 0;
+void WebServerService::startRequest(HttpConnection &connection)
+{
+    connection.state = HttpConnection::ReadingHeaders;
+    connection.length = 0;
+    connection.lineStart = 0;
+    connection.bodyStart = 0;
+    connection.contentLength = 0;
+    connection.overflow = false;
+    connection.connectionHint = 0;
+    connection.acceptsGzip = false;
+    connection.keepAlive = false;
+}
 
-    // Read headers with timeout
-    unsigned long startTime = millis();
-    while (client.connected() && millis() - startTime < 5000)
-    { // 5-second timeout for headers
-        if (client.available())
+void WebServerService::receive(HttpConnection &connection)
+{
+    uint8_t chunk[HTTP_IO_CHUNK];
+    int count = connection.carryLength;
+    if (count > 0)
+    {
+        memcpy(chunk, connection.carry, count);
+        connection.carryLength = 0;
+    }
+    else
+    {
+        int available = connection.client.available();
+        if (available <= 0)
+        {
+            return;
+        }
+        count = connection.client.read(chunk, available < HTTP_IO_CHUNK ? available : HTTP_IO_CHUNK);
+        if (count <= 0)
         {
-            String line = client.readStringUntil('\r');
-            client.read(); // Consume '\n'
-            line.trim();   // Remove whitespace
+            return;
+        }
+        connection.lastActivity = millis();
+    }
 
-            if (line.length() > 0)
+    // Stops at the end of the request, whatever follows belongs to the next
+    int used = 0;
+    while (used < count)
+    {
+        char c = chunk[used++];
+        if (connection.state == HttpConnection::ReadingHeaders)
+        {
+            if (!receiveHeaderByte(connection, c))
             {
-                Serial.println("Header: " + line);
-
-                // Capture Content-Length
-                if (line.startsWith("Content-Length:"))
-                {
-                    contentLength = line.substring(15).toInt();
-                    Serial.println("Parsed Content-Length: " + String(contentLength));
-                }
-
-                // Save the request line (only if it is the first line)
-                if (requestLine == "")
-                {
-                    requestLine = line;
-                }
+                break;
             }
-            else
+        }
+        else
+        {
+            connection.buffer[connection.length++] = c;
+            if (connection.length - connection.bodyStart >= connection.contentLength)
             {
-                // Break on empty line indicating end of headers
-                Serial.println("End of headers");
+                connection.buffer[connection.length] = '\0';
+                route(connection);
                 break;
             }
         }
-        else
+    }
+
+    // Kept only when the connection stays open for another request
+    if (used < count && connection.keepAlive)
+    {
+        connection.carryLength = count - used;
+        memcpy(connection.carry, chunk + used, connection.carryLength);
+    }
+}
+
+// Returns false once the connection left the header phase
+bool WebServerService::receiveHeaderByte(HttpConnection &connection, char c)
+{
+    if (connection.length < HTTP_BUFFER_SIZE - 1)
+    {
+        connection.buffer[connection.length++] = c;
+    }
+    else
+    {
+        connection.overflow = true;
+    }
+    if (c != '\n')
+    {
+        return true;
+    }
+
+    // A complete line sits in buffer[lineStart, length)
+    char *line = connection.buffer + connection.lineStart;
+    uint16_t lineLength = connection.length - connection.lineStart;
+    while (lineLength > 0 && (line[lineLength - 1] == '\n' || line[lineLength - 1] == '\r'))
+    {
+        lineLength--;
+    }
+
+    if (connection.lineStart == 0)
+    {
+        if (connection.overflow)
+        {
+            respondError(connection, STATUS_URI_TOO_LONG, NOT_FOUND_PAGE);
+            return false;
+        }
+        // Request line, kept as a C string
+        line[lineLength] = '\0';
+        connection.lineStart = lineLength + 1;
+        connection.length = connection.lineStart;
+        return true;
+    }
+
+    if (lineLength > 0)
+    {
+        HttpHeader header;
+        if (HttpTokenizer::parseHeader(line, lineLength, header))
+        {
+            if (HttpTokenizer::equalsIgnoreCase(line, header.name, "Content-Length"))
+            {
+                connection.contentLength = HttpTokenizer::parseLength(line, header.value, 100000L);
+            }
+            else if (HttpTokenizer::equalsIgnoreCase(line, header.name, "Connection"))
+            {
+                connection.connectionHint = HttpTokenizer::equalsIgnoreCase(line, header.value, "close")        ? -1
+                                            : HttpTokenizer::equalsIgnoreCase(line, header.value, "keep-alive") ? 1
+                                                                                                                 : 0;
+            }
+            else if (HttpTokenizer::equalsIgnoreCase(line, header.name, "Accept-Encoding"))
+            {
+                connection.acceptsGzip = HttpTokenizer::contains(line, header.value, "gzip");
+            }
+        }
+        connection.length = connection.lineStart;
+        connection.overflow = false;
+        return true;
+    }
+
+    // Blank line: headers done, the body goes right after the request line
+    connection.length = connection.lineStart;
+    connection.bodyStart = connection.lineStart;
+    if (connection.contentLength < 0)
+    {
+        respondError(connection, STATUS_BAD_REQUEST, BAD_REQUEST_PAGE);
+        return false;
+    }
+    if (strncmp(connection.buffer, "POST ", 5) == 0 && connection.contentLength > 0)
+    {
+        if (connection.contentLength > HTTP_BUFFER_SIZE - 1 - connection.bodyStart)
         {
-            Serial.println("No data available");
-            // Delay to allow more data to arrive
-            delay(10);
+            respondError(connection, STATUS_TOO_LARGE, TOO_LARGE_PAGE);
+            return false;
         }
+        connection.state = HttpConnection::ReadingBody;
+        return true;
     }
+    connection.buffer[connection.length] = '\0';
+    route(connection);
+    return false;
+}
 
-    // Check for timeout or incomplete headers
-    if (requestLine == "")
+void WebServerService::route(HttpConnection &connection)
+{
+    HttpRequestLine request;
+    if (!HttpTokenizer::parseRequestLine(connection.buffer, connection.bodyStart - 1, request))
     {
-        Serial.println("Error: No request line received");
-        client.stop();
+        respondError(connection, STATUS_BAD_REQUEST, BAD_REQUEST_PAGE);
         return;
     }
+    // avr-libc printf has no "%.*s", log bounded copies (long paths are cut)
+    char method[8], path[32];
+    HttpTokenizer::copy(connection.buffer, request.method, method, sizeof(method));
+    HttpTokenizer::copy(connection.buffer, request.path, path, sizeof(path));
+    LOG_DEBUG("http", "%s %s", method, path);
 
-    Serial.println("Request Line: " + requestLine);
+    // HTTP/1.1 keeps the connection unless asked not to, 1.0 only when asked
+    connection.served++;
+    bool http11 = HttpTokenizer::equals(connection.buffer, request.version, "HTTP/1.1");
+    connection.keepAlive = connection.served < HTTP_KEEP_ALIVE_REQUESTS &&
+                           (connection.connectionHint > 0 || (connection.connectionHint == 0 && http11));
 
-    // Process GET or POST requests
-    if (requestLine.startsWith("GET / "))
+    bool get = HttpTokenizer::equals(connection.buffer, request.method, "GET");
+    bool portal = flashEquals(wifiService.mode, F("ap"));
+    if (get && HttpTokenizer::equals(connection.buffer, request.path, "/metrics"))
     {
-        handleRoot(client);
+        handleSnapshot(connection, true);
     }
-    else if (requestLine.startsWith("POST /save"))
+    else if (get && HttpTokenizer::equals(connection.buffer, request.path, "/api/snapshot"))
     {
-        if (contentLength > 0)
+        handleSnapshot(connection, false);
+    }
+    // The credentials form is only offered while the device is its own AP
+    else if (portal && get)
+    {
+        if (!serveAsset(connection, connection.buffer + request.path.offset, request.path.length))
+        {
+            respondError(connection, STATUS_NOT_FOUND, NOT_FOUND_PAGE);
+        }
+    }
+    else if (portal && HttpTokenizer::equals(connection.buffer, request.method, "POST") &&
+             HttpTokenizer::equals(connection.buffer, request.path, "/save"))
+    {
+        if (connection.contentLength > 0)
         {
-            String postBody = readRequestBody(client, contentLength);
-            Serial.println("Post Body: " + postBody);
-            handleSaveCredentials(client, postBody);
+            HttpView body = {connection.bodyStart, (uint16_t)connection.contentLength};
+            handleSaveCredentials(connection, body);
         }
         else
         {
-            Serial.println("Error: Content-Length is 0 or missing");
-            client.println("HTTP/1.1 400 Bad Request");
-            client.println("Content-Type: text/html");
-            client.println();
-            client.println("<html><body><h1>400 Bad Request: No Content-Length</h1></body></html>");
-            client.stop();
+            LOG_WARN("http", "Content-Length is 0 or missing");
+            respondError(connection, STATUS_BAD_REQUEST, BAD_REQUEST_PAGE);
         }
     }
     else
     {
-        // Send 404 response
-        client.println("HTTP/1.1 404 Not Found");
-        client.println("Content-Type: text/html");
-        client.println();
-        client.println("<html><body><h1>404 Not Found</h1></body></html>");
-        client.stop();
-    }
-}
-
-void WebServerService::handleRoot(WiFiClient &client)
-{
-    String html = "<html><body><form action='/save' method='POST'>"
-                  "SSID: <input type='text' name='ssid'><br>"
-                  "Password: <input type='text' name='password'><br>"
-                  "<input type='submit' value='Save'>"
-                  "</form></body></html>";
-
-    // Send HTTP response
-    client.println("HTTP/1.1 200 OK");
-    client.println("Content-Type: text/html");
-    client.println("Connection: close");
-    client.println();
-    client.println(html);
-    client.stop();
-}
-
-void WebServerService::handleSaveCredentials(WiFiClient &client, String &body)
-{
-    Serial.print("Received body: ");
-    Serial.println(body);
-    String request = client.readStringUntil('\r');
-    auto queryParams = parsePostBody(body);
-    Serial.println("Request params:");
-    Serial.println(queryParams.size());
-    Serial.println(queryParams["ssid"]);
-    Serial.println(queryParams["password"]);
-
-    // Extract ssid and password from the request body
-    // int ssidIndex = queryParams["ssid"];
-    // int passwordIndex = queryParams["password"];
-    // if ()
-    // {
-    //     client.println("HTTP/1.1 400 Bad Request");
-    //     client.println("Content-Type: text/html");
-    //     client.println("Connection: close");
-    //     client.println();
-    //     client.println("<html><body><h1>Invalid request</h1></body></html>");
-    //     client.stop();
-    //     return;
-    // }
-
-    String ssid = queryParams["ssid"];
-    String password = queryParams["password"];
+        respondError(connection, STATUS_NOT_FOUND, NOT_FOUND_PAGE);
+    }
+}
 
-    // Save credentials
-    diskManager.save("ssid", ssid);
-    diskManager.save("password", password);
-    // Send response
-    client.println("HTTP/1.1 200 OK");
-    client.println("Content-Type: text/html");
-    client.println("Connection: close");
-    client.println();
-    client.println("<html><body><h1>Credentials saved. Please restart the device.</h1></body></html>");
-    client.stop();
-    wifiService.connectToWiFi(ssid.c_str(), password.c_str());
+void WebServerService::respondError(HttpConnection &connection, PGM_P status, PGM_P page)
+{
+    connection.keepAlive = false;
+    respond(connection, status, TYPE_HTML, reinterpret_cast<const uint8_t *>(page), strlen_P(page), true, false);
 }
 
-String WebServerService::readRequestBody(WiFiClient &client, int contentLength)
+// The head is written over the request in the connection buffer, callers
+// must be done with the request by now
+void WebServerService::respond(HttpConnection &connection, PGM_P status, PGM_P contentType, const uint8_t *body, uint16_t length, bool inFlash, bool gzip)
 {
-    String postBody = "";
-    unsigned long startTime = millis();
+    TextBuffer head(connection.buffer, HTTP_BUFFER_SIZE);
+    head.append(F("HTTP/1.1 "));
+    head.append(FPSTR(status));
+    head.append(F("\r\nContent-Type: "));
+    head.append(FPSTR(contentType));
+    if (gzip)
+    {
+        head.append(F("\r\nContent-Encoding: gzip"));
+    }
+    head.append(connection.keepAlive ? F("\r\nConnection: keep-alive") : F("\r\nConnection: close"));
+    head.append(F("\r\nContent-Length: "));
+    head.append((unsigned long)length);
+    head.append(F("\r\n\r\n"));
+
+    connection.headLength = head.size();
+    connection.body = body;
+    connection.bodyInFlash = inFlash;
+    connection.bodyLength = length;
+    connection.sent = 0;
+    connection.pinned = !inFlash;
+    snapshotReaders += connection.pinned;
+    connection.state = HttpConnection::Writing;
+}
 
-    while (postBody.length() < contentLength)
+// Sends at most one chunk of the head and one of the body per tick
+void WebServerService::transmit(HttpConnection &connection)
+{
+    uint16_t headLength = connection.headLength;
+    uint16_t total = headLength + connection.bodyLength;
+    if (connection.sent < headLength)
+    {
+        uint16_t count = headLength - connection.sent;
+        count = count < HTTP_IO_CHUNK ? count : HTTP_IO_CHUNK;
+        connection.sent += connection.client.write((const uint8_t *)connection.buffer + connection.sent, count);
+    }
+    else if (connection.sent < total)
     {
-        // Timeout check
-        if (millis() - startTime > 2000)
-        { // 2-second timeout
-            Serial.println("Error: Body read timeout");
-            break;
+        uint16_t offset = connection.sent - headLength;
+        uint16_t count = connection.bodyLength - offset;
+        count = count < HTTP_IO_CHUNK ? count : HTTP_IO_CHUNK;
+        if (connection.bodyInFlash)
+        {
+            connection.sent += flashWrite(connection.client, reinterpret_cast<PGM_P>(connection.body), offset, count);
         }
+        else
+        {
+            connection.sent += connection.client.write(connection.body + offset, count);
+        }
+    }
+    connection.lastActivity = millis();
+    if (connection.sent >= total)
+    {
+        finishResponse(connection);
+    }
+}
+
+void WebServerService::finishResponse(HttpConnection &connection)
+{
+    if (connection.pinned)
+    {
+        connection.pinned = false;
+        snapshotReaders--;
+    }
+    connection.body = nullptr;
+    if (connection.keepAlive)
+    {
+        startRequest(connection);
+    }
+    else
+    {
+        connection.state = HttpConnection::Closing;
+    }
+}
 
-        // Read available data
-        if (client.available())
+void WebServerService::close(HttpConnection &connection)
+{
+    connection.client.stop();
+    connection.body = nullptr;
+    if (connection.pinned)
+    {
+        connection.pinned = false;
+        snapshotReaders--;
+    }
+    connection.state = HttpConnection::Free;
+}
+
+void WebServerService::handleSnapshot(HttpConnection &connection, bool metrics)
+{
+    uint16_t length = metrics ? snapshotMetricsLength : snapshotJsonLength;
+    if (length == 0)
+    {
+        respondError(connection, STATUS_UNAVAILABLE, NOT_READY_PAGE);
+        return;
+    }
+    const char *body = metrics ? snapshot + snapshotMetricsOffset : snapshot;
+    respond(connection, STATUS_OK, metrics ? TYPE_METRICS : TYPE_JSON, reinterpret_cast<const uint8_t *>(body), length, false, false);
+}
+
+// Portal pages from flash, gzip when the client takes it and it is smaller
+bool WebServerService::serveAsset(HttpConnection &connection, const char *path, uint16_t pathLength)
+{
+    for (uint8_t i = 0; i < WEB_ASSET_COUNT; i++)
+    {
+        WebAsset asset;
+        memcpy_P(&asset, &WEB_ASSETS[i], sizeof(asset));
+        if (strlen_P(asset.path) != pathLength || strncmp_P(path, asset.path, pathLength) != 0)
         {
-            char c = client.read();
-            postBody += c;
+            continue;
         }
+        bool gzip = connection.acceptsGzip && asset.gzipLength < asset.plainLength;
+        respond(connection, STATUS_OK, asset.contentType, gzip ? asset.gzip : asset.plain,
+                gzip ? asset.gzipLength : asset.plainLength, true, gzip);
+        return true;
     }
+    return false;
+}
+
+void WebServerService::handleSaveCredentials(HttpConnection &connection, HttpView body)
+{
+    // Fields are decoded in place in the connection buffer
+    HttpForm form;
+    HttpTokenizer::parseForm(connection.buffer, body, form);
+    LOG_DEBUG("http", "%d form fields", form.count);
 
-    if (postBody.length() < contentLength)
+    HttpView ssidView, passwordView;
+    if (!HttpTokenizer::findField(connection.buffer, form, "ssid", ssidView) ||
+        !HttpTokenizer::findField(connection.buffer, form, "password", passwordView))
     {
-        Serial.println("Warning: Incomplete body received");
+        respondError(connection, STATUS_BAD_REQUEST, BAD_REQUEST_PAGE);
+        return;
     }
+    char ssid[33], password[64];
+    HttpTokenizer::copy(connection.buffer, ssidView, ssid, sizeof(ssid));
+    HttpTokenizer::copy(connection.buffer, passwordView, password, sizeof(password));
 
-    return postBody;
-}
\ No newline at end of file
+    // Save credentials
+    diskManager.save("ssid", ssid);
+    diskManager.save("password", password);
+    // Closed after the page so the pending connect is not held up
+    connection.keepAlive = false;
+    char savedPath[sizeof(SAVED_PATH)];
+    strcpy_P(savedPath, SAVED_PATH);
+    serveAsset(connection, savedPath, strlen(savedPath));
+
+    pendingSsid = ssid;
+    pendingPassword = password;
+    pendingConnect = true;
+}
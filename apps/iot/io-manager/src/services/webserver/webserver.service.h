@@ -4,21 +4,107 @@
 #include <WiFiEspAT.h>
 #include "services/disk-manager/diskManager.service.h"
 #include "services/wifi-manager/wifiManager.service.h"
+#include "utility/httpTokenizer.util.h"
+#include "utility/flashString.util.h"
+
+#define HTTP_MAX_CONNECTIONS 2     // ~300 B of SRAM each, mostly the buffer below
+#define HTTP_BUFFER_SIZE 256       // Request line + form body per connection
+#define HTTP_IO_CHUNK 64           // Bytes read or written per connection per tick
+#define HTTP_IDLE_TIMEOUT_MS 5000
+#define HTTP_SNAPSHOT_SIZE 1024    // /api/snapshot JSON and /metrics text, rendered once per poll
+#define HTTP_KEEP_ALIVE_REQUESTS 8 // Requests served on one connection before it is closed
+
+// One client connection, advanced a bounded step per handleClient() call
+struct HttpConnection
+{
+    enum State : uint8_t
+    {
+        Free,
+        ReadingHeaders,
+        ReadingBody,
+        Writing,
+        Closing
+    };
+
+    WiFiClient client;
+    State state = Free;
+    unsigned long lastActivity = 0;
+
+    // Only the request line and the body are kept, other headers are
+    // inspected as they complete and dropped
+    char buffer[HTTP_BUFFER_SIZE];
+    uint16_t length = 0;
+    uint16_t lineStart = 0;
+    uint16_t bodyStart = 0;
+    int32_t contentLength = 0;
+    bool overflow = false;
+    int8_t connectionHint = 0; // Connection header: -1 close, 1 keep-alive
+    bool acceptsGzip = false;
+    bool keepAlive = false;    // Decided per request, see route()
+    uint8_t served = 0;
+
+    // Bytes read past the end of a request (the start of a pipelined one),
+    // parsed before the socket is read again
+    uint8_t carry[HTTP_IO_CHUNK];
+    uint8_t carryLength = 0;
+
+    // Response: the head is built into `buffer` once the request is
+    // consumed, the body is either flash (assets, error pages) or the
+    // snapshot cache, which stays pinned until the body is sent
+    uint16_t headLength = 0;
+    const uint8_t *body = nullptr;
+    bool bodyInFlash = false;
+    uint16_t bodyLength = 0;
+    uint16_t sent = 0;
+    bool pinned = false;
+};
+
 class WebServerService
 {
 public:
     WebServerService(DiskManagerService &diskManager, WiFiService &wifiService);
     void begin();
+    // Accepts new clients and advances every open connection, never waits
     void handleClient();
     WiFiServer server;
     String getState();
+    uint8_t getOpenConnections() const;
+
+    // Snapshot cache: the owner renders into the buffer once per poll and
+    // every scrape streams the same bytes. The buffer is null while a
+    // response is still streaming from it, the owner retries next loop.
+    char *beginSnapshot(uint16_t &capacity);
+    void commitSnapshot(uint16_t jsonLength, uint16_t metricsOffset, uint16_t metricsLength);
 
 private:
     DiskManagerService &diskManager;
     WiFiService &wifiService;
-    void handleRoot(WiFiClient &client);
-    void handleSaveCredentials(WiFiClient &client, String &body);
-    String readRequestBody(WiFiClient &client, int contentLength);
+    HttpConnection connections[HTTP_MAX_CONNECTIONS];
+
+    char snapshot[HTTP_SNAPSHOT_SIZE];
+    uint16_t snapshotJsonLength = 0;
+    uint16_t snapshotMetricsOffset = 0;
+    uint16_t snapshotMetricsLength = 0;
+    uint8_t snapshotReaders = 0;
+
+    // Credentials from the portal, applied once the response went out
+    bool pendingConnect = false;
+    String pendingSsid, pendingPassword;
+
+    void accept();
+    void receive(HttpConnection &connection);
+    bool receiveHeaderByte(HttpConnection &connection, char c);
+    void transmit(HttpConnection &connection);
+    void close(HttpConnection &connection);
+    void route(HttpConnection &connection);
+    void startRequest(HttpConnection &connection);
+    void finishResponse(HttpConnection &connection);
+    // Error pages, the connection closes after them
+    void respondError(HttpConnection &connection, PGM_P status, PGM_P page);
+    void respond(HttpConnection &connection, PGM_P status, PGM_P contentType, const uint8_t *body, uint16_t length, bool inFlash, bool gzip);
+    void handleSnapshot(HttpConnection &connection, bool metrics);
+    bool serveAsset(HttpConnection &connection, const char *path, uint16_t pathLength);
+    void handleSaveCredentials(HttpConnection &connection, HttpView body);
 };
 
 #endif
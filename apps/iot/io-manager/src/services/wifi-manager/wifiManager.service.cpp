@@ -1,22 +1,38 @@
 #include "wifiManager.service.h"
+#include "utility/logger.util.h"
+#include "config.h"
 
-WiFiService::WiFiService() : status("Initializing") {}
+WiFiService::WiFiService()
+    : status("Initializing"), connecting(false), connectStartedAt(0), lastPollAt(0), retryPending(false), retryAt(0),
+      retryDelayMs(WIFI_RETRY_MIN_MS) {}
 
 String WiFiService::begin()
 {
-    Serial1.begin(115200);
+    EspSerial.begin(ESP_BAUD_DEFAULT);
     status = "Initializing";
     do
     {
-        WiFi.init(&Serial1); // Initialize the WiFi module with the Serial1 interface
+        WiFi.init(&EspSerial); // Initialize the WiFi module over USART1
         if (WiFi.status() == WL_NO_SHIELD)
         {
-            Serial.println("WiFi shield not present");
+            LOG_ERROR("wifi", "WiFi shield not present");
             status = "No Shield";
             delay(1000);
         }
     } while (WiFi.status() == WL_NO_SHIELD);
 
+    // After init, which restarts the module and with it its default rate
+    AtLink<EspUart> link(EspSerial);
+    uint32_t baud = link.negotiateBaud(ESP_BAUD_FAST, ESP_BAUD_DEFAULT, ESP_RTS_PIN >= 0 ? 2 : 0);
+    if (baud == 0)
+    {
+        LOG_ERROR("wifi", "Module stopped answering during rate negotiation");
+    }
+    else
+    {
+        LOG_INFO("wifi", "Module link at %lu baud", (unsigned long)baud);
+    }
+
     WiFi.disconnect();
     status = "Ready";
     return getMacAddress();
@@ -24,55 +40,36 @@ String WiFiService::begin()
 
 void WiFiService::scanNetworks()
 {
+    EspSerial.endPassthrough();
     int n = WiFi.scanNetworks();
-    Serial.println("Scan completed");
-    if (n == 0)
+    LOG_INFO("wifi", "Scan completed, %d networks found", n);
+    for (int i = 0; i < n; ++i)
     {
-        Serial.println("No networks found");
-    }
-    else
-    {
-        Serial.print(n);
-        Serial.println(" networks found");
-        for (int i = 0; i < n; ++i)
-        {
-            Serial.print(i + 1);
-            Serial.print(": ");
-            Serial.print(WiFi.SSID(i));
-            Serial.print(" (");
-            Serial.print(WiFi.RSSI(i));
-            Serial.print(")");
-            Serial.println((WiFi.encryptionType(i) == ENC_TYPE_NONE) ? " " : "*");
-            delay(10);
-        }
+        LOG_INFO("wifi", "%d: %s (%ld)%c", i + 1, WiFi.SSID(i), (long)WiFi.RSSI(i),
+                 WiFi.encryptionType(i) == ENC_TYPE_NONE ? ' ' : '*');
     }
 }
 
 void WiFiService::turnToAccessPointMode(const char *ssid, const char *password)
 {
     // WiFi.disconnect();
+    EspSerial.endPassthrough();
 
+    retryPending = false; // Asked for, or set again by the fallback
     WiFi.softAP(ssid, password, 10);
     WiFi.softAPConfig(IPAddress(5, 5, 5, 5), IPAddress(5, 5, 5, 5), IPAddress(255, 255, 255, 0));
-    Serial.println("Access Point started");
-    Serial.print("IP Address: ");
-    Serial.println(WiFi.localIP());
     this->mode = "ap";
     this->status = "AP Mode";
-    Serial.print("SSID: ");
-    Serial.println(WiFi.SSID());
-
-    Serial.print("Channel: ");
-    Serial.println(WiFi.channel());
-
-    Serial.print("DHCP Enabled: ");
-    Serial.println(WiFi.dhcpIsEnabled());
+    IPAddress ip = WiFi.localIP();
+    LOG_INFO("wifi", "Access point %s on channel %d, %u.%u.%u.%u, DHCP %d", WiFi.SSID(), WiFi.channel(),
+             ip[0], ip[1], ip[2], ip[3], WiFi.dhcpIsEnabled());
 }
 
 void WiFiService::turnToNormalMode()
 {
+    EspSerial.endPassthrough();
     WiFi.disconnect();
-    Serial.println("Normal Mode");
+    LOG_INFO("wifi", "Normal mode");
     this->mode = "client";
     this->status = "Disconnected";
     // close access point
@@ -81,26 +78,65 @@ void WiFiService::turnToNormalMode()
 
 void WiFiService::connectToWiFi(const char *ssid, const char *password)
 {
+    EspSerial.endPassthrough();
+    joinSsid = ssid;
+    joinPassword = password;
     WiFi.begin(ssid, password);
 
-    Serial.print("Connecting to ");
-    Serial.println(ssid);
+    LOG_INFO("wifi", "Connecting to %s", ssid);
     this->status = "Connecting";
+    connecting = true;
+    connectStartedAt = millis();
+    lastPollAt = connectStartedAt;
+}
 
-    while (WiFi.status() != WL_CONNECTED)
+// Polls the join started by connectToWiFi(), one status query per WIFI_POLL_MS
+void WiFiService::loop(bool mayRetry)
+{
+    unsigned long now = millis();
+    if (!connecting)
     {
-        delay(500);
-        Serial.print(".");
+        if (retryPending && mayRetry && (long)(now - retryAt) >= 0)
+        {
+            LOG_INFO("wifi", "Retrying %s", joinSsid.c_str());
+            connectToWiFi(joinSsid.c_str(), joinPassword.c_str());
+        }
+        return;
     }
+    if (now - lastPollAt < WIFI_POLL_MS)
+    {
+        return;
+    }
+    lastPollAt = now;
 
-    Serial.println("");
-    this->mode = "client";
-    this->status = "Connected";
-    Serial.println("WiFi connected");
-    Serial.println("IP address: ");
-    Serial.println(WiFi.localIP());
-    WiFi.softAPdisconnect();
+    if (WiFi.status() == WL_CONNECTED)
+    {
+        connecting = false;
+        retryDelayMs = WIFI_RETRY_MIN_MS;
+        this->mode = "client";
+        this->status = "Connected";
+        IPAddress ip = WiFi.localIP();
+        LOG_INFO("wifi", "Connected, IP address %u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+        WiFi.softAPdisconnect();
+    }
+    else if (now - connectStartedAt >= WIFI_CONNECT_TIMEOUT_MS)
+    {
+        connecting = false;
+        LOG_WARN("wifi", "No connection after %lu s, access point until a retry in %lu s", WIFI_CONNECT_TIMEOUT_MS / 1000,
+                 retryDelayMs / 1000);
+        WiFi.disconnect();
+        turnToAccessPointMode(AP_SSID, AP_PASSWORD);
+        retryPending = true;
+        retryAt = now + retryDelayMs;
+        retryDelayMs = retryDelayMs * 2 > WIFI_RETRY_MAX_MS ? WIFI_RETRY_MAX_MS : retryDelayMs * 2;
+    }
+}
+
+bool WiFiService::isConnecting() const
+{
+    return connecting;
 }
+
 String WiFiService::getMacAddress()
 {
     byte mac[6];
@@ -114,8 +150,7 @@ String WiFiService::getMacAddress()
         sprintf(octet, "%02X", mac[i]);
         strcat(macStr, octet);
     }
-    Serial.print("MAC Address: ");
-    Serial.println(macStr);
+    LOG_INFO("wifi", "MAC address %s", macStr);
     return macStr;
 }
 
@@ -123,34 +158,3 @@ String WiFiService::getStatus()
 {
     return status;
 }
-bool WiFiService::connectToHost(const char *hostname, uint16_t port, IPAddress fallbackIP, WiFiClient &client)
-{
-    IPAddress serverIP;
-    Serial.print("Resolving hostname: ");
-    Serial.println(hostname);
-
-    if (WiFi.hostByName(hostname, serverIP))
-    {
-        Serial.print("DNS resolved: ");
-        Serial.println(serverIP);
-    }
-    else
-    {
-        Serial.println("DNS failed. Using fallback IP.");
-        serverIP = fallbackIP; // <- optional fallback
-    }
-
-    Serial.print("Connecting to server: ");
-    Serial.println(serverIP);
-
-    if (client.connect(serverIP, port))
-    {
-        Serial.println("Connected to server!");
-        return true;
-    }
-    else
-    {
-        Serial.println("Connection failed!");
-        return false;
-    }
-}
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include <WiFiEspAT.h>
+#include "services/esp-link/espLink.service.h"
 
 class WiFiService
 {
@@ -10,16 +11,31 @@ public:
     WiFiService();
     String begin();
 
+    // AT commands cannot pass while the broker socket is in passthrough,
+    // these close it first
     void scanNetworks();
     void turnToAccessPointMode(const char *ssid, const char *password);
     void turnToNormalMode();
+    // Starts joining, loop() finishes it or falls back to the access point
     void connectToWiFi(const char *ssid, const char *password);
+    // Polls a join; from the fallback access point it retries the last
+    // network with backoff, only while `mayRetry` (a join disturbs the portal)
+    void loop(bool mayRetry = true);
+    bool isConnecting() const;
     String getMacAddress();
     String getStatus();
     String mode;
-    bool connectToHost(const char *hostname, uint16_t port, IPAddress fallbackIP, WiFiClient &client);
 
     private : String status;
+    bool connecting;
+    unsigned long connectStartedAt;
+    unsigned long lastPollAt;
+
+    // Network of the last join, retried after a fallback to the access point
+    String joinSsid, joinPassword;
+    bool retryPending;
+    unsigned long retryAt;
+    unsigned long retryDelayMs;
 };
 
 #endif // WIFI_SERVICE_H
\ No newline at end of file
@@ -0,0 +1,168 @@
+#ifndef ALERT_RULE_H
+#define ALERT_RULE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALERT_RULE_FIELDS 7
+
+// channel <op> threshold, held for durationSec, optionally only while the
+// guard channel is non-zero (e.g. zero flow while the water pump is on)
+struct AlertRule
+{
+    char channel[8];
+    char op; // '<', '>', '=' or '!', 0 marks an empty slot
+    float threshold;
+    float hysteresis;
+    uint16_t durationSec;
+    char guard[8];
+    char action[8]; // "wp-off", "ap-off", "wp-on", "ap-on" or empty
+};
+
+// Copies one field into `out`, false when it does not fit
+inline bool alertRuleField(const char *start, size_t length, char *out, size_t size)
+{
+    if (length >= size)
+    {
+        return false;
+    }
+    memcpy(out, start, length);
+    out[length] = 0;
+    return true;
+}
+
+// A number that fills its whole field
+inline bool alertRuleNumber(const char *field, float &value)
+{
+    char *end;
+    value = (float)strtod(field, &end);
+    return end != field && *end == 0;
+}
+
+// "channel,op,threshold,hysteresis,duration,guard,action", the last two
+// may be empty. `rule` is left untouched unless every field is valid.
+inline bool alertRuleDecode(const char *encoded, AlertRule &rule)
+{
+    char fields[ALERT_RULE_FIELDS][16];
+    const char *start = encoded;
+    for (uint8_t i = 0; i < ALERT_RULE_FIELDS; i++)
+    {
+        const char *end = strchr(start, ',');
+        if ((end == nullptr) != (i == ALERT_RULE_FIELDS - 1))
+        {
+            return false; // Too few or too many fields
+        }
+        size_t length = end ? (size_t)(end - start) : strlen(start);
+        if (!alertRuleField(start, length, fields[i], sizeof(fields[i])))
+        {
+            return false;
+        }
+        start = end + 1;
+    }
+
+    AlertRule decoded;
+    memset(&decoded, 0, sizeof(decoded));
+    const char *op = fields[1];
+    if (op[0] == 0 || op[1] != 0 || strchr("<>=!", op[0]) == nullptr)
+    {
+        return false;
+    }
+    decoded.op = op[0];
+
+    float duration;
+    if (fields[0][0] == 0 || !alertRuleField(fields[0], strlen(fields[0]), decoded.channel, sizeof(decoded.channel)) ||
+        !alertRuleNumber(fields[2], decoded.threshold) || !alertRuleNumber(fields[3], decoded.hysteresis) ||
+        decoded.hysteresis < 0 || !alertRuleNumber(fields[4], duration) || duration < 0 || duration > 65535 ||
+        duration != (float)(uint16_t)duration ||
+        !alertRuleField(fields[5], strlen(fields[5]), decoded.guard, sizeof(decoded.guard)))
+    {
+        return false;
+    }
+    decoded.durationSec = (uint16_t)duration;
+
+    const char *action = fields[6];
+    if (action[0] != 0 && strcmp(action, "wp-off") != 0 && strcmp(action, "ap-off") != 0 &&
+        strcmp(action, "wp-on") != 0 && strcmp(action, "ap-on") != 0)
+    {
+        return false;
+    }
+    strcpy(decoded.action, action);
+    rule = decoded;
+    return true;
+}
+
+// An active alert only clears once the value is back past the hysteresis band
+inline bool alertConditionHolds(const AlertRule &rule, float value, bool active)
+{
+    float band = active ? rule.hysteresis : 0;
+    switch (rule.op)
+    {
+    case '<':
+        return value < rule.threshold + band;
+    case '>':
+        return value > rule.threshold - band;
+    case '=':
+        return value == rule.threshold;
+    case '!':
+        return value != rule.threshold;
+    }
+    return false;
+}
+
+// Evaluation state of one rule
+struct AlertState
+{
+    bool active;
+    bool holding; // Condition true since `since`
+    bool frozen;  // Active while the guard was down
+    unsigned long since;
+};
+
+enum AlertTransition : int8_t
+{
+    AlertNone = 0,
+    AlertRaised = 1,
+    AlertCleared = -1
+};
+
+// One evaluation of `rule` against the channel's value. A guard that drops
+// freezes an active alert instead of clearing it: a wp-off action stops the
+// very pump its guard watches, clearing then would hand the pump back to
+// the schedule and trip again. Once the guard is back the condition has to
+// hold for the duration again, the alert is then raised anew so its
+// action runs again.
+inline AlertTransition alertStep(const AlertRule &rule, AlertState &state, float value, bool guarded, unsigned long now)
+{
+    if (guarded)
+    {
+        state.holding = false;
+        state.frozen = state.active;
+        return AlertNone;
+    }
+    if (!alertConditionHolds(rule, value, state.active))
+    {
+        state.holding = false;
+        state.frozen = false;
+        if (state.active)
+        {
+            state.active = false;
+            return AlertCleared;
+        }
+        return AlertNone;
+    }
+    if (!state.holding)
+    {
+        state.holding = true;
+        state.since = now;
+    }
+    if ((!state.active || state.frozen) && now - state.since >= rule.durationSec * 1000UL)
+    {
+        state.active = true;
+        state.frozen = false;
+        return AlertRaised;
+    }
+    return AlertNone;
+}
+
+#endif // ALERT_RULE_H
@@ -0,0 +1,134 @@
+#ifndef DNS_MESSAGE_H
+#define DNS_MESSAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Just enough of the DNS wire format (RFC 1035) to ask for one A record and
+// read the answer, for unicast DNS and for one-shot mDNS queries (RFC 6762
+// section 5.1: sent from a port other than 5353, answered by unicast with
+// the same id).
+
+#define DNS_PORT 53
+#define MDNS_PORT 5353
+#define DNS_TYPE_A 1
+#define DNS_CLASS_IN 1
+
+// A standard query for the A record of `name`; recursion is asked for from
+// unicast servers only. Returns the packet length, 0 when the name does not
+// fit or has an empty or over-long label.
+inline uint16_t dnsWriteQuery(uint8_t *out, uint16_t size, const char *name, uint16_t id, bool recursive)
+{
+    size_t nameLength = strlen(name);
+    // Header, length prefixes plus labels, root label, type and class
+    if (nameLength == 0 || 12 + nameLength + 2 + 4 > size)
+    {
+        return 0;
+    }
+    memset(out, 0, 12);
+    out[0] = (uint8_t)(id >> 8);
+    out[1] = (uint8_t)(id & 0xFF);
+    out[2] = recursive ? 0x01 : 0x00; // RD
+    out[5] = 1;                       // QDCOUNT
+    uint16_t n = 12;
+    const char *label = name;
+    while (true)
+    {
+        const char *dot = strchr(label, '.');
+        size_t labelLength = dot ? (size_t)(dot - label) : strlen(label);
+        if (labelLength == 0 || labelLength > 63)
+        {
+            return 0;
+        }
+        out[n++] = (uint8_t)labelLength;
+        memcpy(out + n, label, labelLength);
+        n += labelLength;
+        if (!dot)
+        {
+            break;
+        }
+        label = dot + 1;
+    }
+    out[n++] = 0;
+    out[n++] = 0;
+    out[n++] = DNS_TYPE_A;
+    out[n++] = 0;
+    out[n++] = DNS_CLASS_IN;
+    return n;
+}
+
+// Skips a possibly compressed name, returns the offset after it or 0 when
+// it runs past the packet
+inline uint16_t dnsSkipName(const uint8_t *packet, uint16_t length, uint16_t offset)
+{
+    while (offset < length)
+    {
+        uint8_t labelLength = packet[offset];
+        if (labelLength == 0)
+        {
+            return offset + 1;
+        }
+        if ((labelLength & 0xC0) == 0xC0)
+        {
+            return offset + 2 <= length ? offset + 2 : 0; // Pointer ends the name
+        }
+        offset += 1 + labelLength;
+    }
+    return 0;
+}
+
+// First A record in the answer section of the response to query `id`.
+// CNAME records before it are stepped over, the address is taken as the
+// answer for the queried name.
+inline bool dnsReadAnswer(const uint8_t *packet, uint16_t length, uint16_t id, uint8_t address[4], uint32_t &ttl)
+{
+    if (length < 12 || packet[0] != (uint8_t)(id >> 8) || packet[1] != (uint8_t)(id & 0xFF))
+    {
+        return false;
+    }
+    // A response, RCODE 0
+    if (!(packet[2] & 0x80) || (packet[3] & 0x0F) != 0)
+    {
+        return false;
+    }
+    uint16_t questions = (uint16_t)(packet[4] << 8 | packet[5]);
+    uint16_t answers = (uint16_t)(packet[6] << 8 | packet[7]);
+    uint16_t offset = 12;
+    for (uint16_t i = 0; i < questions; i++)
+    {
+        offset = dnsSkipName(packet, length, offset);
+        if (offset == 0 || offset + 4 > length)
+        {
+            return false;
+        }
+        offset += 4;
+    }
+    for (uint16_t i = 0; i < answers; i++)
+    {
+        offset = dnsSkipName(packet, length, offset);
+        if (offset == 0 || offset + 10 > length)
+        {
+            return false;
+        }
+        const uint8_t *record = packet + offset;
+        uint16_t type = (uint16_t)(record[0] << 8 | record[1]);
+        uint16_t recordClass = (uint16_t)((record[2] & 0x7F) << 8 | record[3]); // mDNS cache-flush bit
+        uint16_t dataLength = (uint16_t)(record[8] << 8 | record[9]);
+        offset += 10;
+        if (offset + dataLength > length)
+        {
+            return false;
+        }
+        if (type == DNS_TYPE_A && recordClass == DNS_CLASS_IN && dataLength == 4)
+        {
+            ttl = (uint32_t)record[4] << 24 | (uint32_t)record[5] << 16 | (uint32_t)record[6] << 8 | record[7];
+            memcpy(address, packet + offset, 4);
+            return true;
+        }
+        offset += dataLength;
+    }
+    return false;
+}
+
+#endif // DNS_MESSAGE_H
@@ -0,0 +1,107 @@
+#ifndef FLASH_STRING_H
+#define FLASH_STRING_H
+
+#include <Arduino.h>
+
+// Helpers for strings kept in program memory (F(), PROGMEM). On AVR a
+// plain literal is copied into SRAM at startup; these let topics, log
+// messages and HTTP assets stay in flash and be compared, hashed and
+// streamed from there without a RAM copy of the whole text.
+
+typedef const __FlashStringHelper *FlashString;
+
+// A PROGMEM array as a flash string (the ESP cores define this, AVR does not)
+#ifndef FPSTR
+#define FPSTR(p) (reinterpret_cast<FlashString>(p))
+#endif
+
+#define FLASH_CHUNK 32 // Stack buffer used when streaming from flash
+
+inline PGM_P flashChars(FlashString text)
+{
+    return reinterpret_cast<PGM_P>(text);
+}
+
+inline size_t flashLength(FlashString text)
+{
+    return strlen_P(flashChars(text));
+}
+
+inline bool flashEquals(const char *ram, FlashString text)
+{
+    return strcmp_P(ram, flashChars(text)) == 0;
+}
+
+inline bool flashEquals(const String &ram, FlashString text)
+{
+    return flashEquals(ram.c_str(), text);
+}
+
+// Copies into a NUL terminated RAM buffer, truncating to size - 1
+inline size_t flashCopy(char *out, size_t size, FlashString text)
+{
+    if (size == 0)
+    {
+        return 0;
+    }
+    strncpy_P(out, flashChars(text), size - 1);
+    out[size - 1] = '\0';
+    return strlen(out);
+}
+
+// FNV-1a, identical for the RAM and the flash copy of a string
+inline uint16_t flashHashStep(uint32_t &hash, uint8_t c)
+{
+    hash = (hash ^ c) * 16777619UL;
+    return (uint16_t)(hash ^ (hash >> 16));
+}
+
+inline uint16_t stringHash(const char *ram)
+{
+    uint32_t hash = 2166136261UL;
+    uint16_t folded = (uint16_t)(hash ^ (hash >> 16));
+    while (*ram)
+    {
+        folded = flashHashStep(hash, *ram++);
+    }
+    return folded;
+}
+
+inline uint16_t flashHash(FlashString text)
+{
+    PGM_P p = flashChars(text);
+    uint32_t hash = 2166136261UL;
+    uint16_t folded = (uint16_t)(hash ^ (hash >> 16));
+    for (uint8_t c = pgm_read_byte(p); c != 0; c = pgm_read_byte(++p))
+    {
+        folded = flashHashStep(hash, c);
+    }
+    return folded;
+}
+
+// Writes `count` bytes from flash starting at `offset`, one stack chunk at
+// a time. Returns what the sink accepted, so a socket writer can resume.
+inline size_t flashWrite(Print &out, PGM_P data, size_t offset, size_t count)
+{
+    uint8_t chunk[FLASH_CHUNK];
+    size_t written = 0;
+    while (written < count)
+    {
+        size_t n = count - written < FLASH_CHUNK ? count - written : FLASH_CHUNK;
+        memcpy_P(chunk, data + offset + written, n);
+        size_t accepted = out.write(chunk, n);
+        written += accepted;
+        if (accepted < n)
+        {
+            break;
+        }
+    }
+    return written;
+}
+
+inline size_t flashWrite(Print &out, FlashString text)
+{
+    return flashWrite(out, flashChars(text), 0, flashLength(text));
+}
+
+#endif // FLASH_STRING_H
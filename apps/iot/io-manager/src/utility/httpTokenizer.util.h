@@ -0,0 +1,297 @@
+#ifndef HTTP_TOKENIZER_H
+#define HTTP_TOKENIZER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Zero-allocation HTTP tokenizer over a caller owned receive buffer. Every
+// token is an offset/length view into that buffer; form fields are
+// percent-decoded in place, which only ever shrinks them. Nothing here
+// touches the heap, and no input can make it read or write outside
+// [0, length) of the buffer it was given (test/test_native_http_tokenizer).
+
+#define HTTP_MAX_FIELDS 8
+
+struct HttpView
+{
+    uint16_t offset;
+    uint16_t length;
+};
+
+struct HttpRequestLine
+{
+    HttpView method;
+    HttpView path;  // Without the query string
+    HttpView query; // After '?', empty if there is none
+    HttpView version;
+};
+
+struct HttpHeader
+{
+    HttpView name;
+    HttpView value; // Surrounding whitespace trimmed
+};
+
+struct HttpField
+{
+    HttpView key;
+    HttpView value;
+};
+
+// Decoded key/value pairs of an urlencoded form or query string
+struct HttpForm
+{
+    HttpField fields[HTTP_MAX_FIELDS];
+    uint8_t count;
+    bool truncated; // More than HTTP_MAX_FIELDS pairs, the rest were ignored
+};
+
+class HttpTokenizer
+{
+public:
+    static bool equals(const char *buffer, HttpView view, const char *text)
+    {
+        size_t length = strlen(text);
+        return view.length == length && memcmp(buffer + view.offset, text, length) == 0;
+    }
+
+    static bool equalsIgnoreCase(const char *buffer, HttpView view, const char *text)
+    {
+        size_t length = strlen(text);
+        if (view.length != length)
+        {
+            return false;
+        }
+        for (uint16_t i = 0; i < view.length; i++)
+        {
+            if (lower(buffer[view.offset + i]) != lower(text[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Case-insensitive substring search, e.g. "gzip" in an Accept-Encoding value
+    static bool contains(const char *buffer, HttpView view, const char *text)
+    {
+        size_t length = strlen(text);
+        for (uint16_t start = 0; start + length <= view.length; start++)
+        {
+            HttpView candidate = {(uint16_t)(view.offset + start), (uint16_t)length};
+            if (equalsIgnoreCase(buffer, candidate, text))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Copies a view into a NUL terminated string, truncating to size - 1
+    static uint16_t copy(const char *buffer, HttpView view, char *out, uint16_t size)
+    {
+        if (size == 0)
+        {
+            return 0;
+        }
+        uint16_t length = view.length < size - 1 ? view.length : size - 1;
+        memcpy(out, buffer + view.offset, length);
+        out[length] = '\0';
+        return length;
+    }
+
+    // "METHOD SP target SP version", a trailing CR/LF is ignored
+    static bool parseRequestLine(const char *buffer, uint16_t length, HttpRequestLine &out)
+    {
+        length = trimLineEnd(buffer, length);
+        uint16_t firstSpace = find(buffer, 0, length, ' ');
+        if (firstSpace == 0 || firstSpace >= length)
+        {
+            return false;
+        }
+        uint16_t secondSpace = find(buffer, firstSpace + 1, length, ' ');
+        if (secondSpace >= length || secondSpace == firstSpace + 1 || secondSpace + 1 >= length)
+        {
+            return false;
+        }
+        if (find(buffer, secondSpace + 1, length, ' ') < length)
+        {
+            return false;
+        }
+
+        out.method = {0, firstSpace};
+        uint16_t targetStart = firstSpace + 1;
+        uint16_t question = find(buffer, targetStart, secondSpace, '?');
+        out.path = {targetStart, (uint16_t)(question - targetStart)};
+        if (question < secondSpace)
+        {
+            out.query = {(uint16_t)(question + 1), (uint16_t)(secondSpace - question - 1)};
+        }
+        else
+        {
+            out.query = {secondSpace, 0};
+        }
+        out.version = {(uint16_t)(secondSpace + 1), (uint16_t)(length - secondSpace - 1)};
+        return buffer[targetStart] == '/';
+    }
+
+    // "Name: value", the view offsets are relative to `buffer`
+    static bool parseHeader(const char *buffer, uint16_t length, HttpHeader &out)
+    {
+        length = trimLineEnd(buffer, length);
+        uint16_t colon = find(buffer, 0, length, ':');
+        if (colon == 0 || colon >= length)
+        {
+            return false;
+        }
+        for (uint16_t i = 0; i < colon; i++)
+        {
+            if (buffer[i] == ' ' || buffer[i] == '\t')
+            {
+                return false;
+            }
+        }
+        uint16_t start = colon + 1;
+        uint16_t end = length;
+        while (start < end && (buffer[start] == ' ' || buffer[start] == '\t'))
+        {
+            start++;
+        }
+        while (end > start && (buffer[end - 1] == ' ' || buffer[end - 1] == '\t'))
+        {
+            end--;
+        }
+        out.name = {0, colon};
+        out.value = {start, (uint16_t)(end - start)};
+        return true;
+    }
+
+    // Decimal value of a Content-Length header, -1 if malformed or above
+    // limit (keep limit below INT32_MAX / 10)
+    static int32_t parseLength(const char *buffer, HttpView view, int32_t limit)
+    {
+        if (view.length == 0)
+        {
+            return -1;
+        }
+        int32_t value = 0;
+        for (uint16_t i = 0; i < view.length; i++)
+        {
+            char c = buffer[view.offset + i];
+            if (c < '0' || c > '9')
+            {
+                return -1;
+            }
+            value = value * 10 + (c - '0');
+            if (value > limit)
+            {
+                return -1;
+            }
+        }
+        return value;
+    }
+
+    // Splits "k=v&k2=v2" on the raw bytes, then decodes every key and value
+    // in place ('+' and %XX), so an encoded '&' or '=' cannot split a pair.
+    // Pairs without '=' are dropped.
+    static void parseForm(char *buffer, HttpView view, HttpForm &out)
+    {
+        out.count = 0;
+        out.truncated = false;
+        uint16_t end = view.offset + view.length;
+        uint16_t start = view.offset;
+        while (start < end)
+        {
+            uint16_t pairEnd = find(buffer, start, end, '&');
+            uint16_t equalSign = find(buffer, start, pairEnd, '=');
+            if (equalSign < pairEnd)
+            {
+                if (out.count == HTTP_MAX_FIELDS)
+                {
+                    out.truncated = true;
+                    return;
+                }
+                HttpField &field = out.fields[out.count++];
+                field.key = {start, decode(buffer + start, equalSign - start)};
+                field.value = {(uint16_t)(equalSign + 1), decode(buffer + equalSign + 1, pairEnd - equalSign - 1)};
+            }
+            start = pairEnd + 1;
+        }
+    }
+
+    // First field named `key`, false if absent
+    static bool findField(const char *buffer, const HttpForm &form, const char *key, HttpView &value)
+    {
+        for (uint8_t i = 0; i < form.count; i++)
+        {
+            if (equals(buffer, form.fields[i].key, key))
+            {
+                value = form.fields[i].value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Percent-decodes in place, returns the new length. Malformed escapes
+    // are kept verbatim.
+    static uint16_t decode(char *text, uint16_t length)
+    {
+        uint16_t out = 0;
+        for (uint16_t i = 0; i < length; i++)
+        {
+            char c = text[i];
+            int8_t high, low;
+            if (c == '+')
+            {
+                c = ' ';
+            }
+            else if (c == '%' && i + 2 < length && (high = hex(text[i + 1])) >= 0 && (low = hex(text[i + 2])) >= 0)
+            {
+                c = (char)((high << 4) | low);
+                i += 2;
+            }
+            text[out++] = c;
+        }
+        return out;
+    }
+
+private:
+    static char lower(char c)
+    {
+        return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+    }
+
+    static int8_t hex(char c)
+    {
+        if (c >= '0' && c <= '9')
+        {
+            return c - '0';
+        }
+        c = lower(c);
+        if (c >= 'a' && c <= 'f')
+        {
+            return c - 'a' + 10;
+        }
+        return -1;
+    }
+
+    // Index of the first `c` in [start, end), or `end`
+    static uint16_t find(const char *buffer, uint16_t start, uint16_t end, char c)
+    {
+        const void *hit = start < end ? memchr(buffer + start, c, end - start) : nullptr;
+        return hit ? (uint16_t)((const char *)hit - buffer) : end;
+    }
+
+    static uint16_t trimLineEnd(const char *buffer, uint16_t length)
+    {
+        while (length > 0 && (buffer[length - 1] == '\n' || buffer[length - 1] == '\r'))
+        {
+            length--;
+        }
+        return length;
+    }
+};
+
+#endif // HTTP_TOKENIZER_H
@@ -0,0 +1,86 @@
+#ifndef LATENCY_WINDOW_H
+#define LATENCY_WINDOW_H
+
+#include <stdint.h>
+
+// The last N latency samples (milliseconds) of one measurement. Percentiles
+// sort a copy on request, which is cheap for the few samples kept here and
+// leaves add() at O(1) on the hot path.
+template <uint8_t N, typename T = uint16_t>
+class LatencyWindow
+{
+public:
+    LatencyWindow() : head(0), count(0), total(0) {}
+
+    // Values above the range of T are stored saturated
+    void add(uint32_t value)
+    {
+        T limit = (T)~(T)0;
+        values[head] = value > limit ? limit : (T)value;
+        head = (head + 1) % N;
+        if (count < N)
+        {
+            count++;
+        }
+        total++;
+    }
+
+    void clear()
+    {
+        head = 0;
+        count = 0;
+    }
+
+    uint8_t size() const
+    {
+        return count;
+    }
+
+    // Samples since boot, including those that left the window
+    uint32_t getTotal() const
+    {
+        return total;
+    }
+
+    T getLast() const
+    {
+        return count ? values[(head + N - 1) % N] : 0;
+    }
+
+    // Nearest rank percentile of the window, 0 while it is empty
+    T percentile(uint8_t percent) const
+    {
+        if (count == 0)
+        {
+            return 0;
+        }
+        T sorted[N];
+        for (uint8_t i = 0; i < count; i++)
+        {
+            // Insertion sort, the window is small
+            T value = values[i];
+            uint8_t j = i;
+            while (j > 0 && sorted[j - 1] > value)
+            {
+                sorted[j] = sorted[j - 1];
+                j--;
+            }
+            sorted[j] = value;
+        }
+        uint16_t rank = ((uint16_t)percent * count + 99) / 100;
+        return sorted[rank > 0 ? rank - 1 : 0];
+    }
+
+    T getMax() const
+    {
+        return percentile(100);
+    }
+
+private:
+    T values[N];
+    uint8_t head; // Slot of the next sample
+    uint8_t count;
+    uint32_t total;
+};
+
+#endif // LATENCY_WINDOW_H
@@ -0,0 +1,170 @@
+#include "logger.util.h"
+#include <stdarg.h>
+
+namespace
+{
+    char ring[LOG_RING_SIZE];
+    uint16_t head = 0; // next byte to send
+    uint16_t used = 0;
+    Print *sink = nullptr;
+    bool blockingMode = true;
+    uint32_t droppedLines = 0;
+    uint32_t throttledLines = 0;
+
+    const char LEVEL_LETTERS[] PROGMEM = "-EWID";
+}
+
+#define LOG_TAG_MAX 12 // Longer tags are cut
+
+void Logger::begin(Print &out)
+{
+    sink = &out;
+}
+
+void Logger::setBlocking(bool blocking)
+{
+    blockingMode = blocking;
+}
+
+void Logger::write(uint8_t level, LogSite &site, PGM_P tag, PGM_P format, ...)
+{
+    if (!blockingMode && !allow(site))
+    {
+        throttledLines++;
+        return;
+    }
+
+    // "<ms> W tag: message\r\n", cut at LOG_LINE_MAX
+    char line[LOG_LINE_MAX];
+    ultoa(millis(), line, 10);
+    int length = strlen(line);
+    line[length++] = ' ';
+    line[length++] = pgm_read_byte(LEVEL_LETTERS + (level <= LOG_LEVEL_DEBUG ? level : 0));
+    line[length++] = ' ';
+    strncpy_P(line + length, tag, LOG_TAG_MAX);
+    line[length + LOG_TAG_MAX] = '\0';
+    length += strlen(line + length);
+    line[length++] = ':';
+    line[length++] = ' ';
+    line[length] = '\0';
+    if (length < (int)sizeof(line) - 2)
+    {
+        va_list args;
+        va_start(args, format);
+        int message = vsnprintf_P(line + length, sizeof(line) - 2 - length, format, args);
+        va_end(args);
+        if (message > 0)
+        {
+            length += message;
+        }
+    }
+    if (length > (int)sizeof(line) - 3)
+    {
+        length = sizeof(line) - 3;
+    }
+    line[length++] = '\r';
+    line[length++] = '\n';
+
+    if (blockingMode && sink != nullptr)
+    {
+        // Setup: wait for the UART instead of dropping
+        while (freeSpace() < length)
+        {
+            uint16_t queued = used;
+            drain();
+            if (used == queued)
+            {
+                sink->write((const uint8_t *)ring + head, 1);
+                head = (head + 1) % LOG_RING_SIZE;
+                used--;
+            }
+        }
+    }
+    if (!enqueue(line, length))
+    {
+        droppedLines++;
+    }
+    drain();
+}
+
+void Logger::drain()
+{
+    if (sink == nullptr)
+    {
+        return;
+    }
+    while (used > 0)
+    {
+        int room = sink->availableForWrite();
+        if (room <= 0)
+        {
+            return;
+        }
+        // Contiguous part up to the end of the ring
+        uint16_t count = head + used > LOG_RING_SIZE ? LOG_RING_SIZE - head : used;
+        if (count > (uint16_t)room)
+        {
+            count = room;
+        }
+        size_t accepted = sink->write((const uint8_t *)ring + head, count);
+        if (accepted == 0)
+        {
+            return;
+        }
+        head = (head + accepted) % LOG_RING_SIZE;
+        used -= accepted;
+    }
+}
+
+uint32_t Logger::getDroppedLines()
+{
+    return droppedLines;
+}
+
+uint32_t Logger::getThrottledLines()
+{
+    return throttledLines;
+}
+
+uint16_t Logger::getQueuedBytes()
+{
+    return used;
+}
+
+bool Logger::allow(LogSite &site)
+{
+    uint16_t window = (uint16_t)(millis() >> 10);
+    if (site.window != window)
+    {
+        site.window = window;
+        site.lines = 0;
+    }
+    if (site.lines >= LOG_SITE_BURST)
+    {
+        return false;
+    }
+    site.lines++;
+    return true;
+}
+
+// Whole lines only, a line that does not fit is dropped rather than cut
+bool Logger::enqueue(const char *line, uint16_t length)
+{
+    if (length > freeSpace())
+    {
+        return false;
+    }
+    uint16_t tail = (head + used) % LOG_RING_SIZE;
+    for (uint16_t i = 0; i < length; i++)
+    {
+        ring[tail] = line[i];
+        tail = tail + 1 == LOG_RING_SIZE ? 0 : tail + 1;
+    }
+    used += length;
+    return true;
+}
+
+uint16_t Logger::freeSpace()
+{
+    return LOG_RING_SIZE - used;
+}
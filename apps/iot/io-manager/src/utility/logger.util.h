@@ -0,0 +1,91 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Leveled serial logging. Call sites use the macros below:
+//
+//   LOG_WARN("mqtt", "Reconnect failed, state %d", state);
+//
+// Tag and format stay in flash, the line is formatted with vsnprintf_P
+// (no float conversions on AVR, format them with dtostrf and pass %s) and
+// queued in a RAM ring that is only handed to the UART as fast as it has
+// room, so logging never blocks the loop. Levels above LOG_LEVEL compile to
+// nothing, arguments included. Every call site prints at most
+// LOG_SITE_BURST lines per second; lines over that limit or that do not fit
+// in the ring are counted, not printed.
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// Rate limit state of one call site, 3 bytes of SRAM
+struct LogSite
+{
+    uint16_t window; // millis() / 1024 when the current window started
+    uint8_t lines;
+};
+
+class Logger
+{
+public:
+    // Until setBlocking(false) (end of setup) a line waits for the UART
+    // instead of being dropped or rate limited
+    static void begin(Print &out);
+    static void setBlocking(bool blocking);
+
+    static void write(uint8_t level, LogSite &site, PGM_P tag, PGM_P format, ...);
+
+    // Hands queued bytes to the UART without waiting, called every loop
+    static void drain();
+
+    static uint32_t getDroppedLines();
+    static uint32_t getThrottledLines();
+    static uint16_t getQueuedBytes();
+
+private:
+    static bool allow(LogSite &site);
+    static bool enqueue(const char *line, uint16_t length);
+    static uint16_t freeSpace();
+};
+
+#define LOG_AT(level, tag, format, ...)                                       \
+    do                                                                         \
+    {                                                                          \
+        static LogSite logSite_;                                               \
+        Logger::write(level, logSite_, PSTR(tag), PSTR(format), ##__VA_ARGS__); \
+    } while (0)
+
+#define LOG_DISABLED() \
+    do                 \
+    {                  \
+    } while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(tag, format, ...) LOG_AT(LOG_LEVEL_ERROR, tag, format, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(tag, format, ...) LOG_DISABLED()
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(tag, format, ...) LOG_AT(LOG_LEVEL_WARN, tag, format, ##__VA_ARGS__)
+#else
+#define LOG_WARN(tag, format, ...) LOG_DISABLED()
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(tag, format, ...) LOG_AT(LOG_LEVEL_INFO, tag, format, ##__VA_ARGS__)
+#else
+#define LOG_INFO(tag, format, ...) LOG_DISABLED()
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(tag, format, ...) LOG_AT(LOG_LEVEL_DEBUG, tag, format, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(tag, format, ...) LOG_DISABLED()
+#endif
+
+#endif // LOGGER_H
@@ -0,0 +1,213 @@
+#ifndef ROLLING_STATS_H
+#define ROLLING_STATS_H
+
+#include <math.h>
+#include <stdint.h>
+
+// Sliding-window statistics over the last `window` samples of one channel.
+// Every add() is O(1): mean/variance use Welford updates with removal,
+// min/max come from monotonic queues and the slope from running
+// least-squares sums over the sample timestamps.
+template <uint8_t N>
+class RollingStats
+{
+public:
+    RollingStats() : window(N)
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        head = 0;
+        count = 0;
+        evictions = 0;
+        mean = 0;
+        m2 = 0;
+        sumX = sumXX = sumXY = sumY = 0;
+        minHead = minCount = 0;
+        maxHead = maxCount = 0;
+    }
+
+    // Change the window length (clamped to 2..N samples), drops history
+    void setWindow(uint8_t samples)
+    {
+        window = samples < 2 ? 2 : (samples > N ? N : samples);
+        clear();
+    }
+
+    uint8_t getWindow() const
+    {
+        return window;
+    }
+
+    void add(float value, unsigned long timestamp)
+    {
+        if (count == window)
+        {
+            evictOldest();
+        }
+
+        uint8_t slot = (head + count) % window;
+        values[slot] = value;
+        times[slot] = timestamp;
+        count++;
+
+        // Welford update
+        float delta = value - mean;
+        mean += delta / count;
+        m2 += delta * (value - mean);
+
+        // Least-squares sums, x in seconds relative to the oldest sample
+        float x = (timestamp - times[head]) / 1000.0f;
+        sumX += x;
+        sumXX += x * x;
+        sumXY += x * value;
+        sumY += value;
+
+        pushQueue(minQueue, minHead, minCount, slot, false);
+        pushQueue(maxQueue, maxHead, maxCount, slot, true);
+    }
+
+    uint8_t size() const
+    {
+        return count;
+    }
+
+    float getMin() const
+    {
+        return minCount ? values[minQueue[minHead]] : NAN;
+    }
+
+    float getMax() const
+    {
+        return maxCount ? values[maxQueue[maxHead]] : NAN;
+    }
+
+    float getMean() const
+    {
+        return count ? mean : NAN;
+    }
+
+    // Sample variance of the window
+    float getVariance() const
+    {
+        return count > 1 ? m2 / (count - 1) : 0;
+    }
+
+    // Least-squares trend in units per second
+    float getSlope() const
+    {
+        float denominator = count * sumXX - sumX * sumX;
+        if (count < 2 || denominator <= 0)
+        {
+            return 0;
+        }
+        return (count * sumXY - sumX * sumY) / denominator;
+    }
+
+private:
+    float values[N];
+    unsigned long times[N];
+    uint8_t head;  // Slot of the oldest sample
+    uint8_t count; // Samples currently in the window
+    uint8_t window;
+    uint8_t evictions;
+
+    float mean, m2;
+    float sumX, sumXX, sumXY, sumY;
+
+    // Monotonic queues of slots, front holds the current min/max
+    uint8_t minQueue[N], maxQueue[N];
+    uint8_t minHead, minCount, maxHead, maxCount;
+
+    void evictOldest()
+    {
+        float value = values[head];
+        unsigned long base = times[head];
+
+        if (count == 1)
+        {
+            clear();
+            return;
+        }
+
+        // Welford removal
+        float delta = value - mean;
+        mean -= delta / (count - 1);
+        m2 -= delta * (value - mean);
+        if (m2 < 0)
+        {
+            m2 = 0;
+        }
+
+        // Oldest sample sits at x = 0, so only sumY changes
+        sumY -= value;
+
+        if (minCount && minQueue[minHead] == head)
+        {
+            minHead = (minHead + 1) % N;
+            minCount--;
+        }
+        if (maxCount && maxQueue[maxHead] == head)
+        {
+            maxHead = (maxHead + 1) % N;
+            maxCount--;
+        }
+
+        head = (head + 1) % window;
+        count--;
+
+        // Rebase x on the new oldest sample
+        float shift = (times[head] - base) / 1000.0f;
+        sumXY -= shift * sumY;
+        sumXX += -2.0f * shift * sumX + count * shift * shift;
+        sumX -= count * shift;
+
+        // Float error accumulates with removals, rebuild once per lap
+        if (++evictions >= window)
+        {
+            evictions = 0;
+            rebuild();
+        }
+    }
+
+    void rebuild()
+    {
+        mean = 0;
+        m2 = 0;
+        sumX = sumXX = sumXY = sumY = 0;
+        for (uint8_t i = 0; i < count; i++)
+        {
+            uint8_t slot = (head + i) % window;
+            float value = values[slot];
+            float delta = value - mean;
+            mean += delta / (i + 1);
+            m2 += delta * (value - mean);
+
+            float x = (times[slot] - times[head]) / 1000.0f;
+            sumX += x;
+            sumXX += x * x;
+            sumXY += x * value;
+            sumY += value;
+        }
+    }
+
+    void pushQueue(uint8_t *queue, uint8_t &queueHead, uint8_t &queueCount, uint8_t slot, bool keepMax)
+    {
+        float value = values[slot];
+        while (queueCount)
+        {
+            float back = values[queue[(queueHead + queueCount - 1) % N]];
+            if (keepMax ? back > value : back < value)
+            {
+                break;
+            }
+            queueCount--;
+        }
+        queue[(queueHead + queueCount) % N] = slot;
+        queueCount++;
+    }
+};
+
+#endif // ROLLING_STATS_H
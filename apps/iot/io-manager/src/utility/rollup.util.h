@@ -0,0 +1,114 @@
+#ifndef ROLLUP_H
+#define ROLLUP_H
+
+#include <math.h>
+#include <stdint.h>
+#include <map>
+#include <string>
+
+// count/min/max/sum of one channel over one rollup period
+struct RollupBucket
+{
+    uint16_t count = 0;
+    float min = 0;
+    float max = 0;
+    float sum = 0;
+
+    void add(float value)
+    {
+        if (count == 0 || value < min)
+        {
+            min = value;
+        }
+        if (count == 0 || value > max)
+        {
+            max = value;
+        }
+        sum += value;
+        count++;
+    }
+
+    float getMean() const
+    {
+        return count ? sum / count : NAN;
+    }
+};
+
+// Fixed-period downsampler: accumulates every sample into per-channel
+// buckets and hands them over once the period has elapsed, mirroring the
+// API's squashed sensor log (datapoints/min/max/average per interval).
+class TimeRollup
+{
+public:
+    TimeRollup(const char *interval, unsigned long periodMs)
+        : interval(interval), periodMs(periodMs), periodStart(0), completedStart(0), sequence(0), pending(false) {}
+
+    void add(const std::map<std::string, double> &data, unsigned long now)
+    {
+        if (current.empty())
+        {
+            periodStart = now;
+        }
+        else if (now - periodStart >= periodMs)
+        {
+            completed.swap(current);
+            current.clear();
+            completedStart = periodStart;
+            periodStart += periodMs * ((now - periodStart) / periodMs);
+            sequence++;
+            pending = true;
+        }
+
+        for (const auto &entry : data)
+        {
+            current[entry.first].add(entry.second);
+        }
+    }
+
+    // A finished period not handed over yet, stays set until takePending()
+    bool isPending() const
+    {
+        return pending;
+    }
+
+    // True once per finished period
+    bool takePending()
+    {
+        bool wasPending = pending;
+        pending = false;
+        return wasPending;
+    }
+
+    const std::map<std::string, RollupBucket> &getCompleted() const
+    {
+        return completed;
+    }
+
+    const char *getInterval() const
+    {
+        return interval;
+    }
+
+    uint32_t getSequence() const
+    {
+        return sequence;
+    }
+
+    // millis() at the start of the completed period
+    unsigned long getCompletedStart() const
+    {
+        return completedStart;
+    }
+
+private:
+    const char *interval;
+    unsigned long periodMs;
+    unsigned long periodStart;
+    unsigned long completedStart;
+    uint32_t sequence;
+    bool pending;
+    std::map<std::string, RollupBucket> current;
+    std::map<std::string, RollupBucket> completed;
+};
+
+#endif // ROLLUP_H
@@ -0,0 +1,123 @@
+#ifndef SENSOR_KERNELS_H
+#define SENSOR_KERNELS_H
+
+#include <math.h>
+#include <stdint.h>
+
+// Integer conversion kernels for the analog water sensors. configure() does
+// the float work once, when calibration or temperature changes; convert()
+// runs per sample in fixed point, the AVR has no FPU.
+
+// pH = 7 + (V - Vn) / S with the electrode slope S = (Vn - Va) / 3 from the
+// two point calibration. This is the formula PHSensor always used: its
+// Nernst temperature terms cancel out, so pH does not depend on the water
+// temperature. V is taken from the sum of `samples` 10-bit readings, so the
+// whole chain folds into pH = gain * rawSum + offset:
+//   gain in Q24 (pH per count), offset and the result in Q16.
+// Error against the legacy float formula stays below 0.002 pH at any
+// water temperature (test/test_native_sensor_kernels).
+class PhKernel
+{
+public:
+    PhKernel() : gain(0), offset(0), gainFloat(0), offsetFloat(0), valid(false), fixedPoint(false) {}
+
+    // False for a degenerate calibration (Vn == Va)
+    bool configure(float neutralMv, float acidMv, uint8_t samples)
+    {
+        float slope = (neutralMv - acidMv) / 3.0f;
+        if (slope == 0 || samples == 0)
+        {
+            valid = false;
+            fixedPoint = false;
+            return false;
+        }
+        gainFloat = 5000.0f / (1023.0f * samples) / slope;
+        offsetFloat = 7.0f - neutralMv / slope;
+
+        // gain * rawSum must fit in 31 bits, weak electrodes fall back to float
+        float maxProduct = fabsf(gainFloat) * 16777216.0f * 1023.0f * samples;
+        fixedPoint = maxProduct < 2147483000.0f && fabsf(offsetFloat) < 30000.0f;
+        gain = (int32_t)lroundf(gainFloat * 16777216.0f);
+        offset = (int32_t)lroundf(offsetFloat * 65536.0f);
+        valid = true;
+        return true;
+    }
+
+    int32_t convertQ16(uint16_t rawSum) const
+    {
+        return ((gain * (int32_t)rawSum + 128) >> 8) + offset;
+    }
+
+    float convert(uint16_t rawSum) const
+    {
+        if (!valid)
+        {
+            return NAN;
+        }
+        return fixedPoint ? convertQ16(rawSum) / 65536.0f : gainFloat * rawSum + offsetFloat;
+    }
+
+    bool isValid() const
+    {
+        return valid;
+    }
+
+    bool isFixedPoint() const
+    {
+        return fixedPoint;
+    }
+
+private:
+    int32_t gain;   // Q24
+    int32_t offset; // Q16
+    float gainFloat;
+    float offsetFloat;
+    bool valid;
+    bool fixedPoint;
+};
+
+// DFRobot Gravity TDS: c = V / (1 + 0.02 (T - 25)),
+// tds = 0.5 (133.42 c^3 - 255.86 c^2 + 857.39 c), V = adc * 5 / 1024.
+// With u = adc / 1024 the cubic becomes ((c3 u + c2) u + c1) u, evaluated by
+// Horner with u in Q10 and the coefficients in Q4. Temperature is clamped
+// to 0..50 °C so the intermediates fit in 31 bits. Error against the float
+// reference stays below 0.25 ppm.
+class TdsKernel
+{
+public:
+    TdsKernel() : c3(0), c2(0), c1(0) {}
+
+    void configure(float temperature)
+    {
+        if (temperature < 0)
+        {
+            temperature = 0;
+        }
+        else if (temperature > 50)
+        {
+            temperature = 50;
+        }
+        float fullScale = 5.0f / (1.0f + 0.02f * (temperature - 25.0f)); // c at u = 1
+        c3 = (int32_t)lroundf(0.5f * 133.42f * fullScale * fullScale * fullScale * 16.0f);
+        c2 = (int32_t)lroundf(-0.5f * 255.86f * fullScale * fullScale * 16.0f);
+        c1 = (int32_t)lroundf(0.5f * 857.39f * fullScale * 16.0f);
+    }
+
+    // adc is a 10-bit reading (0..1023)
+    int32_t convertQ4(uint16_t adc) const
+    {
+        int32_t acc = ((c3 * adc + 512) >> 10) + c2;
+        acc = ((acc * adc + 512) >> 10) + c1;
+        return (acc * adc + 512) >> 10;
+    }
+
+    float convert(uint16_t adc) const
+    {
+        return convertQ4(adc) / 16.0f;
+    }
+
+private:
+    int32_t c3, c2, c1; // Q4
+};
+
+#endif // SENSOR_KERNELS_H
@@ -0,0 +1,56 @@
+#ifndef SRAM_HEADROOM_H
+#define SRAM_HEADROOM_H
+
+#include <stdint.h>
+
+// Least free SRAM between the heap and the stack since boot. The gap is
+// painted once in setup(); the paint still intact above the current heap
+// top is what neither the deepest stack nor the heap has reached. A heap
+// block freed at the top ends the scan early, so this is a lower bound.
+// Hosts have no such gap and report 0.
+
+#define SRAM_PAINT 0xA5
+#define SRAM_PAINT_MARGIN 64 // Left unpainted below the caller's frame
+
+#if defined(__AVR__)
+#include <avr/io.h>
+
+extern char __heap_start;
+extern char *__brkval;
+
+inline char *sramHeapTop()
+{
+    return __brkval != nullptr ? __brkval : &__heap_start;
+}
+
+inline void sramPaint()
+{
+    char here;
+    for (char *p = sramHeapTop(); p < &here - SRAM_PAINT_MARGIN; p++)
+    {
+        *p = (char)SRAM_PAINT;
+    }
+}
+
+inline uint16_t sramHeadroom()
+{
+    const char *p = sramHeapTop();
+    const char *stack = reinterpret_cast<const char *>(SP);
+    uint16_t untouched = 0;
+    while (p < stack && *p == (char)SRAM_PAINT)
+    {
+        p++;
+        untouched++;
+    }
+    return untouched;
+}
+#else
+inline void sramPaint() {}
+
+inline uint16_t sramHeadroom()
+{
+    return 0;
+}
+#endif
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef TELEMETRY_SNAPSHOT_H
+#define TELEMETRY_SNAPSHOT_H
+
+#include <ArduinoSTL.h>
+#include <map>
+#include <string>
+
+// Latest value of every channel, published once per acquisition by the
+// DataCollector and read in place by every consumer (MQTT, LCD, HTTP,
+// alerts, serial). Consumers only get a const reference; the version
+// changes with every publication so they can tell whether anything is new
+// without comparing values. Everything runs on the main loop, so a reader
+// never sees a publication half applied.
+class TelemetrySnapshot
+{
+public:
+    typedef std::map<std::string, double> Values;
+
+    TelemetrySnapshot() : version(0), takenAt(0) {}
+
+    // 0 until the first acquisition
+    uint32_t getVersion() const
+    {
+        return version;
+    }
+
+    unsigned long getTakenAt() const
+    {
+        return takenAt;
+    }
+
+    const Values &getValues() const
+    {
+        return values;
+    }
+
+    bool empty() const
+    {
+        return values.empty();
+    }
+
+    bool has(const std::string &channel) const
+    {
+        return values.find(channel) != values.end();
+    }
+
+    double get(const std::string &channel, double fallback = 0) const
+    {
+        auto it = values.find(channel);
+        return it != values.end() ? it->second : fallback;
+    }
+
+    // True when published after the version a consumer last handled
+    bool isNewerThan(uint32_t seenVersion) const
+    {
+        return version != seenVersion;
+    }
+
+private:
+    friend class DataCollector;
+
+    // Merges the fresh samples of one pass; existing channels are updated
+    // in place, so the map only allocates when a channel first appears
+    void publish(const Values &fresh, unsigned long now)
+    {
+        for (const auto &entry : fresh)
+        {
+            values[entry.first] = entry.second;
+        }
+        takenAt = now;
+        version++;
+    }
+
+    Values values;
+    uint32_t version;
+    unsigned long takenAt;
+};
+
+#endif // TELEMETRY_SNAPSHOT_H
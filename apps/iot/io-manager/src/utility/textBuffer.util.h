@@ -0,0 +1,132 @@
+#ifndef TEXT_BUFFER_H
+#define TEXT_BUFFER_H
+
+#include <Arduino.h>
+#include "utility/flashString.util.h"
+
+// Appends text into a caller owned fixed buffer, no heap. A write that does
+// not fit is dropped whole and sets overflow; mark()/rollback() let callers
+// drop a partially written record (one metric line) instead of cutting it.
+class TextBuffer
+{
+public:
+    TextBuffer(char *data, uint16_t capacity) : data(data), capacity(capacity), length(0), overflow(false)
+    {
+        if (capacity > 0)
+        {
+            data[0] = '\0';
+        }
+    }
+
+    bool append(const char *text)
+    {
+        return append(text, strlen(text));
+    }
+
+    bool append(const char *text, uint16_t count)
+    {
+        if (length + count >= capacity)
+        {
+            overflow = true;
+            return false;
+        }
+        memcpy(data + length, text, count);
+        length += count;
+        data[length] = '\0';
+        return true;
+    }
+
+    // Copied straight from program memory, no RAM copy of the literal
+    bool append(FlashString text)
+    {
+        uint16_t count = flashLength(text);
+        if (length + count >= capacity)
+        {
+            overflow = true;
+            return false;
+        }
+        memcpy_P(data + length, flashChars(text), count);
+        length += count;
+        data[length] = '\0';
+        return true;
+    }
+
+    bool append(char c)
+    {
+        return append(&c, 1);
+    }
+
+    bool append(unsigned long value)
+    {
+        char digits[11];
+        return append(ultoa(value, digits, 10));
+    }
+
+    bool append(long value)
+    {
+        char digits[12];
+        return append(ltoa(value, digits, 10));
+    }
+
+    // NaN and infinities are written the way Prometheus spells them. Fixed
+    // notation is bounded to |value| < 1e15 and 6 decimals (23 characters),
+    // larger magnitudes go out in exponent form
+    bool append(double value, uint8_t decimals)
+    {
+        if (isnan(value))
+        {
+            return append("NaN");
+        }
+        if (isinf(value))
+        {
+            return append(value > 0 ? "+Inf" : "-Inf");
+        }
+        char digits[24];
+        if (fabs(value) >= 1e15)
+        {
+            dtostre(value, digits, 6, 0);
+        }
+        else
+        {
+            dtostrf(value, 1, decimals < 6 ? decimals : 6, digits);
+        }
+        return append(digits);
+    }
+
+    uint16_t mark() const
+    {
+        return length;
+    }
+
+    void rollback(uint16_t position)
+    {
+        if (position < length)
+        {
+            length = position;
+            data[length] = '\0';
+        }
+    }
+
+    const char *c_str() const
+    {
+        return data;
+    }
+
+    uint16_t size() const
+    {
+        return length;
+    }
+
+    bool overflowed() const
+    {
+        return overflow;
+    }
+
+private:
+    char *data;
+    uint16_t capacity;
+    uint16_t length;
+    bool overflow;
+};
+
+#endif // TEXT_BUFFER_H
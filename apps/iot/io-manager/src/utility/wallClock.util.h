@@ -0,0 +1,52 @@
+#ifndef WALL_CLOCK_H
+#define WALL_CLOCK_H
+
+#include <stdint.h>
+
+// Unix time (UTC, no leap seconds) of a calendar date plus seconds of the
+// day, valid from 1970 to 2105
+inline uint32_t epochFromCivil(uint16_t year, uint8_t month, uint8_t day, uint32_t secondsOfDay)
+{
+    // Days from civil, with the year starting in March
+    int32_t y = (int32_t)year - (month <= 2 ? 1 : 0);
+    int32_t era = y / 400;
+    int32_t yearOfEra = y - era * 400;
+    int32_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    int32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    int32_t days = era * 146097 + dayOfEra - 719468;
+    return (uint32_t)days * 86400UL + secondsOfDay;
+}
+
+// Maps millis() readings to Unix time once a time-sync arrived. Readings
+// within about 24 days of the sync, before or after it, map correctly.
+class WallClock
+{
+public:
+    WallClock() : epoch(0), syncedAt(0), synced(false) {}
+
+    void sync(uint32_t epochNow, unsigned long now)
+    {
+        epoch = epochNow;
+        syncedAt = now;
+        synced = true;
+    }
+
+    bool isSynced() const
+    {
+        return synced;
+    }
+
+    uint32_t at(unsigned long ms) const
+    {
+        int32_t offset = (int32_t)(uint32_t)(ms - syncedAt);
+        // Round towards minus infinity so earlier readings never map later
+        return epoch + (offset >= 0 ? offset / 1000 : -((999 - offset) / 1000));
+    }
+
+private:
+    uint32_t epoch;
+    unsigned long syncedAt;
+    bool synced;
+};
+
+#endif // WALL_CLOCK_H
@@ -0,0 +1,69 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "services/module-manager/moduleManager.service.h"
+#include "services/disk-manager/diskManager.service.h"
+#include "services/scheduler/scheduler.service.h"
+
+// On the Mega: the spare relays must be outputs and follow their schedule.
+// Relays are active low, LOW means on.
+
+ModuleManager *moduleManager;
+DiskManagerService *diskManager;
+SchedulerService *scheduler;
+WallClock wallClock; // Never synced: windows are ignored
+
+void setUp() {}
+void tearDown() {}
+
+static bool isOutput(uint8_t pin)
+{
+    return (*portModeRegister(digitalPinToPort(pin)) & digitalPinToBitMask(pin)) != 0;
+}
+
+void test_every_relay_pin_is_an_output_and_off()
+{
+    const uint8_t pins[] = {24, 25, 26, 27};
+    for (uint8_t pin : pins)
+    {
+        TEST_ASSERT_TRUE(isOutput(pin));
+        TEST_ASSERT_EQUAL(HIGH, digitalRead(pin));
+    }
+}
+
+void test_schedule_on_actuator_2_drives_pin_26()
+{
+    ActuatorSchedule schedule = {};
+    schedule.enabled = true;
+    schedule.onSec = 60; // offSec 0 and an all-day window: on right away
+    TEST_ASSERT_TRUE(scheduler->setSchedule(2, schedule));
+
+    scheduler->update(millis());
+    TEST_ASSERT_EQUAL(LOW, digitalRead(26));
+    TEST_ASSERT_EQUAL(HIGH, digitalRead(27));
+    TEST_ASSERT_EQUAL(HIGH, digitalRead(24));
+
+    scheduler->clearSchedule(2);
+    TEST_ASSERT_EQUAL(HIGH, digitalRead(26));
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs if board doesn't support software reset via Serial.DTR/RTS
+    delay(2000);
+
+    moduleManager = new ModuleManager();
+    moduleManager->initializeModules(new DataCollector(), new WiFiService());
+    diskManager = new DiskManagerService();
+    diskManager->initialize();
+    scheduler = new SchedulerService(*diskManager, *moduleManager, wallClock);
+    scheduler->initialize();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_every_relay_pin_is_an_output_and_off);
+    RUN_TEST(test_schedule_on_actuator_2_drives_pin_26);
+    UNITY_END();
+}
+
+void loop()
+{
+}
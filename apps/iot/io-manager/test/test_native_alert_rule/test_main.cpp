@@ -0,0 +1,113 @@
+#include <unity.h>
+#include "utility/alertRule.util.h"
+
+void setUp() {}
+void tearDown() {}
+
+void test_decodes_the_default_rules()
+{
+    AlertRule rule;
+    TEST_ASSERT_TRUE(alertRuleDecode("ph,<,5.0,0.2,60,,", rule));
+    TEST_ASSERT_EQUAL_STRING("ph", rule.channel);
+    TEST_ASSERT_EQUAL_INT('<', rule.op);
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, rule.threshold);
+    TEST_ASSERT_EQUAL_FLOAT(0.2f, rule.hysteresis);
+    TEST_ASSERT_EQUAL_UINT16(60, rule.durationSec);
+    TEST_ASSERT_EQUAL_STRING("", rule.guard);
+    TEST_ASSERT_EQUAL_STRING("", rule.action);
+
+    TEST_ASSERT_TRUE(alertRuleDecode("wl,=,-1,0,0,,wp-off", rule));
+    TEST_ASSERT_EQUAL_FLOAT(-1.0f, rule.threshold);
+    TEST_ASSERT_EQUAL_STRING("wp-off", rule.action);
+
+    TEST_ASSERT_TRUE(alertRuleDecode("lpm,<,0.100,0.000,10,wp,wp-off", rule));
+    TEST_ASSERT_EQUAL_STRING("lpm", rule.channel);
+    TEST_ASSERT_EQUAL_STRING("wp", rule.guard);
+}
+
+void test_rejects_malformed_rules()
+{
+    AlertRule rule;
+    TEST_ASSERT_TRUE(alertRuleDecode("ph,>,7.5,0.2,60,,", rule));
+    const char *invalid[] = {
+        "",
+        "ph,<,5.0,0.2,60,",           // Six fields
+        "ph,<,5.0,0.2,60,,,",         // Eight fields
+        ",<,5.0,0.2,60,,",            // No channel
+        "toolongch,<,5.0,0.2,60,,",   // Channel does not fit
+        "ph,<=,5.0,0.2,60,,",         // Operator
+        "ph,~,5.0,0.2,60,,",
+        "ph,<,abc,0.2,60,,",          // Threshold
+        "ph,<,,0.2,60,,",
+        "ph,<,5.0,-0.2,60,,",         // Negative hysteresis
+        "ph,<,5.0,0.2,70000,,",       // Duration out of range
+        "ph,<,5.0,0.2,1.5,,",
+        "ph,<,5.0,0.2,60,toolongg,",  // Guard does not fit
+        "ph,<,5.0,0.2,60,,pump-off",  // Unknown action
+        "ph,<,5.0,0.2,60,,012345678901234567", // Field longer than any valid one
+    };
+    for (const char *encoded : invalid)
+    {
+        TEST_ASSERT_FALSE_MESSAGE(alertRuleDecode(encoded, rule), encoded);
+    }
+    // A rejected rule leaves the previous one in place
+    TEST_ASSERT_EQUAL_INT('>', rule.op);
+    TEST_ASSERT_EQUAL_FLOAT(7.5f, rule.threshold);
+}
+
+void test_hysteresis_applies_only_while_active()
+{
+    AlertRule rule;
+    TEST_ASSERT_TRUE(alertRuleDecode("ph,<,5.0,0.2,60,,", rule));
+    TEST_ASSERT_TRUE(alertConditionHolds(rule, 4.9f, false));
+    TEST_ASSERT_FALSE(alertConditionHolds(rule, 5.1f, false));
+    TEST_ASSERT_TRUE(alertConditionHolds(rule, 5.1f, true));
+    TEST_ASSERT_FALSE(alertConditionHolds(rule, 5.3f, true));
+
+    TEST_ASSERT_TRUE(alertRuleDecode("ph,>,7.5,0.2,60,,", rule));
+    TEST_ASSERT_FALSE(alertConditionHolds(rule, 7.4f, false));
+    TEST_ASSERT_TRUE(alertConditionHolds(rule, 7.4f, true));
+
+    TEST_ASSERT_TRUE(alertRuleDecode("wl,!,1,0,0,,", rule));
+    TEST_ASSERT_TRUE(alertConditionHolds(rule, 0, false));
+    TEST_ASSERT_FALSE(alertConditionHolds(rule, 1, true));
+}
+
+// The dry-run rule: its own wp-off drops the wp guard
+void test_guard_drop_freezes_an_active_alert()
+{
+    AlertRule rule;
+    TEST_ASSERT_TRUE(alertRuleDecode("lpm,<,0.1,0,10,wp,wp-off", rule));
+    AlertState state = {false, false, false, 0};
+    TEST_ASSERT_EQUAL_INT(AlertNone, alertStep(rule, state, 0.0f, false, 0));
+    TEST_ASSERT_EQUAL_INT(AlertNone, alertStep(rule, state, 0.0f, false, 9999));
+    TEST_ASSERT_EQUAL_INT(AlertRaised, alertStep(rule, state, 0.0f, false, 10000));
+
+    // Pump off: no flow, guard down, the alert must hold
+    for (unsigned long now = 12000; now < 120000; now += 2000)
+    {
+        TEST_ASSERT_EQUAL_INT(AlertNone, alertStep(rule, state, 0.0f, true, now));
+        TEST_ASSERT_TRUE(state.active);
+    }
+
+    // Pump back on and still dry: raised again after the duration
+    TEST_ASSERT_EQUAL_INT(AlertNone, alertStep(rule, state, 0.0f, false, 120000));
+    TEST_ASSERT_EQUAL_INT(AlertNone, alertStep(rule, state, 0.0f, false, 125000));
+    TEST_ASSERT_EQUAL_INT(AlertRaised, alertStep(rule, state, 0.0f, false, 130000));
+    TEST_ASSERT_EQUAL_INT(AlertNone, alertStep(rule, state, 0.0f, false, 150000));
+
+    // Flow restored with the guard up clears it
+    alertStep(rule, state, 0.0f, true, 160000);
+    TEST_ASSERT_EQUAL_INT(AlertCleared, alertStep(rule, state, 2.0f, false, 162000));
+    TEST_ASSERT_FALSE(state.active);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_decodes_the_default_rules);
+    RUN_TEST(test_rejects_malformed_rules);
+    RUN_TEST(test_hysteresis_applies_only_while_active);
+    RUN_TEST(test_guard_drop_freezes_an_active_alert);
+    return UNITY_END();
+}
@@ -0,0 +1,366 @@
+#include <unity.h>
+#include <deque>
+#include <string>
+#include <stdlib.h>
+#include "abstract/atLink.h"
+
+// Simulated ESP-AT module on the other end of the UART. A byte only crosses
+// the wire intact when both sides run the same rate; otherwise it arrives as
+// noise, like a real framing mismatch. brokenBaud models a rate the module
+// accepts but whose timing error our receiver cannot follow.
+class SimulatedModule
+{
+public:
+    uint32_t hostBaud = 115200;
+    uint32_t moduleBaud = 115200;
+    uint32_t brokenBaud = 0; // Replies at this rate arrive garbled
+    bool supportsUartCur = true;
+    bool silent = false;
+    bool echo = false;
+    bool reachable = true;
+
+    bool mux = true;
+    bool transparent = false;
+    bool socketOpen = false;
+    bool passthrough = false;
+    uint8_t flowControl = 0;
+    std::string peerReceived;
+    int commands = 0;
+
+    // Port interface used by AtLink
+    int available()
+    {
+        return (int)toHost.size();
+    }
+
+    int read()
+    {
+        if (toHost.empty())
+        {
+            return -1;
+        }
+        uint8_t c = toHost.front();
+        toHost.pop_front();
+        return c;
+    }
+
+    size_t write(uint8_t c)
+    {
+        if (hostBaud != moduleBaud)
+        {
+            c = 0xFF;
+        }
+        if (passthrough)
+        {
+            receivePassthrough(c);
+        }
+        else
+        {
+            receiveCommand(c);
+        }
+        lastHostByte = clock;
+        return 1;
+    }
+
+    void setBaud(uint32_t baud)
+    {
+        hostBaud = baud;
+    }
+
+    unsigned long now()
+    {
+        return clock++;
+    }
+
+    void wait(unsigned long ms)
+    {
+        clock += ms;
+        // "+++" only counts when followed by a second of silence
+        if (plusCount == 3 && ms >= AT_GUARD_MS)
+        {
+            passthrough = false;
+            plusCount = 0;
+        }
+    }
+
+    // Data the TCP peer sends while in passthrough
+    void peerSends(const std::string &data)
+    {
+        reply(data);
+    }
+
+private:
+    std::deque<uint8_t> toHost;
+    std::string line;
+    unsigned long clock = 0;
+    unsigned long lastHostByte = 0;
+    uint8_t plusCount = 0;
+
+    bool repliesCarry() const
+    {
+        return hostBaud == moduleBaud && moduleBaud != brokenBaud;
+    }
+
+    void reply(const std::string &text)
+    {
+        for (char c : text)
+        {
+            toHost.push_back(repliesCarry() ? (uint8_t)c : 0xFE);
+        }
+    }
+
+    void receivePassthrough(uint8_t c)
+    {
+        if (c == '+' && (plusCount > 0 || clock - lastHostByte >= AT_GUARD_MS) && plusCount < 3)
+        {
+            plusCount++;
+            return;
+        }
+        plusCount = 0;
+        peerReceived += (char)c;
+    }
+
+    void receiveCommand(uint8_t c)
+    {
+        if (echo && !silent)
+        {
+            reply(std::string(1, (char)c));
+        }
+        if (c == '\n')
+        {
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.pop_back();
+            }
+            std::string command = line;
+            line.clear();
+            if (!silent)
+            {
+                handle(command);
+            }
+            return;
+        }
+        line += (char)c;
+    }
+
+    static bool startsWith(const std::string &text, const char *prefix)
+    {
+        return text.compare(0, strlen(prefix), prefix) == 0;
+    }
+
+    void handle(const std::string &command)
+    {
+        commands++;
+        if (command == "AT" || command == "AT+CIPRECVMODE=1")
+        {
+            reply("\r\nOK\r\n");
+        }
+        else if (startsWith(command, "AT+UART_CUR="))
+        {
+            if (!supportsUartCur)
+            {
+                reply("\r\nERROR\r\n");
+                return;
+            }
+            // Answered at the old rate, the new one applies afterwards
+            reply("\r\nOK\r\n");
+            moduleBaud = strtoul(command.c_str() + 12, nullptr, 10);
+            flowControl = (uint8_t)atoi(command.c_str() + command.rfind(',') + 1);
+        }
+        else if (command == "AT+CIPMUX=0" || command == "AT+CIPMUX=1")
+        {
+            bool next = command.back() == '1';
+            if (next && transparent)
+            {
+                reply("\r\nERROR\r\n");
+                return;
+            }
+            mux = next;
+            reply("\r\nOK\r\n");
+        }
+        else if (command == "AT+CIPMODE=1" || command == "AT+CIPMODE=0")
+        {
+            bool next = command.back() == '1';
+            if (next && mux)
+            {
+                reply("\r\nERROR\r\n");
+                return;
+            }
+            transparent = next;
+            reply("\r\nOK\r\n");
+        }
+        else if (startsWith(command, "AT+CIPSTART=\"TCP\",\""))
+        {
+            if (mux || !reachable)
+            {
+                reply("\r\nERROR\r\nCLOSED\r\n");
+                return;
+            }
+            socketOpen = true;
+            reply("CONNECT\r\n\r\nOK\r\n");
+        }
+        else if (command == "AT+CIPSEND")
+        {
+            if (!transparent || !socketOpen)
+            {
+                reply("\r\nERROR\r\n");
+                return;
+            }
+            reply("\r\nOK\r\n\r\n>");
+            passthrough = true;
+        }
+        else if (command == "AT+CIPCLOSE")
+        {
+            reply(socketOpen ? "CLOSED\r\n\r\nOK\r\n" : "\r\nERROR\r\n");
+            socketOpen = false;
+        }
+        else
+        {
+            reply("\r\nERROR\r\n");
+        }
+    }
+};
+
+typedef AtLink<SimulatedModule> Link;
+
+void setUp() {}
+void tearDown() {}
+
+void test_negotiates_the_fast_rate()
+{
+    SimulatedModule module;
+    Link link(module);
+
+    TEST_ASSERT_EQUAL_UINT32(250000, link.negotiateBaud(250000, 115200, 0));
+    TEST_ASSERT_EQUAL_UINT32(250000, module.hostBaud);
+    TEST_ASSERT_EQUAL_UINT32(250000, module.moduleBaud);
+    TEST_ASSERT_TRUE(link.command(PSTR("AT")) == Link::Ok);
+}
+
+void test_passes_flow_control_to_the_module()
+{
+    SimulatedModule module;
+    Link link(module);
+
+    TEST_ASSERT_EQUAL_UINT32(250000, link.negotiateBaud(250000, 115200, 2));
+    TEST_ASSERT_EQUAL_UINT8(2, module.flowControl);
+}
+
+void test_keeps_the_default_when_the_firmware_refuses()
+{
+    SimulatedModule module;
+    module.supportsUartCur = false;
+    Link link(module);
+
+    TEST_ASSERT_EQUAL_UINT32(115200, link.negotiateBaud(250000, 115200, 0));
+    TEST_ASSERT_EQUAL_UINT32(115200, module.hostBaud);
+    TEST_ASSERT_EQUAL_UINT32(115200, module.moduleBaud);
+}
+
+void test_reverts_when_the_fast_rate_does_not_carry()
+{
+    SimulatedModule module;
+    module.brokenBaud = 500000;
+    Link link(module);
+
+    // The module switches, nothing readable comes back, the blind revert
+    // brings both sides back to the default
+    TEST_ASSERT_EQUAL_UINT32(115200, link.negotiateBaud(500000, 115200, 0));
+    TEST_ASSERT_EQUAL_UINT32(115200, module.hostBaud);
+    TEST_ASSERT_EQUAL_UINT32(115200, module.moduleBaud);
+    TEST_ASSERT_TRUE(link.probe());
+}
+
+void test_reports_a_silent_module()
+{
+    SimulatedModule module;
+    module.silent = true;
+    Link link(module);
+
+    TEST_ASSERT_EQUAL_UINT32(0, link.negotiateBaud(250000, 115200, 0));
+}
+
+void test_ignores_command_echo()
+{
+    SimulatedModule module;
+    module.echo = true;
+    Link link(module);
+
+    TEST_ASSERT_EQUAL_UINT32(250000, link.negotiateBaud(250000, 115200, 0));
+    TEST_ASSERT_TRUE(link.command(PSTR("AT+NOPE")) == Link::Error);
+}
+
+void test_passthrough_carries_raw_bytes_and_restores_the_mux()
+{
+    SimulatedModule module;
+    Link link(module);
+
+    TEST_ASSERT_TRUE(link.enterPassthrough("broker.local", 3011));
+    TEST_ASSERT_TRUE(module.passthrough);
+    TEST_ASSERT_FALSE(module.mux);
+
+    // Bytes go straight to the peer, no CIPSEND framing per packet
+    int before = module.commands;
+    const char connectPacket[] = "\x10\x0c\x00\x04MQTT\x04\x02\x00\x3c";
+    for (size_t i = 0; i < sizeof(connectPacket) - 1; i++)
+    {
+        module.write((uint8_t)connectPacket[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(before, module.commands);
+    TEST_ASSERT_TRUE(module.peerReceived == std::string(connectPacket, sizeof(connectPacket) - 1));
+    module.peerSends(std::string("\x20\x02\x00\x00", 4));
+    TEST_ASSERT_EQUAL_INT(4, module.available());
+    TEST_ASSERT_EQUAL_INT(0x20, module.read());
+    while (module.read() >= 0)
+    {
+    }
+
+    TEST_ASSERT_TRUE(link.leavePassthrough());
+    TEST_ASSERT_FALSE(module.passthrough);
+    TEST_ASSERT_FALSE(module.socketOpen);
+    TEST_ASSERT_TRUE(module.mux);
+    TEST_ASSERT_FALSE(module.transparent);
+    TEST_ASSERT_TRUE(link.probe());
+}
+
+void test_plus_inside_data_does_not_leave_passthrough()
+{
+    SimulatedModule module;
+    Link link(module);
+
+    TEST_ASSERT_TRUE(link.enterPassthrough("broker.local", 3011));
+    module.write('a');
+    module.write('+');
+    module.write('+');
+    module.write('+');
+    module.wait(AT_GUARD_MS);
+    TEST_ASSERT_TRUE(module.passthrough);
+    TEST_ASSERT_TRUE(module.peerReceived == "a+++");
+}
+
+void test_unreachable_broker_restores_the_mux()
+{
+    SimulatedModule module;
+    module.reachable = false;
+    Link link(module);
+
+    TEST_ASSERT_FALSE(link.enterPassthrough("broker.local", 3011));
+    TEST_ASSERT_FALSE(module.passthrough);
+    TEST_ASSERT_TRUE(module.mux);
+    TEST_ASSERT_FALSE(module.transparent);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_negotiates_the_fast_rate);
+    RUN_TEST(test_passes_flow_control_to_the_module);
+    RUN_TEST(test_keeps_the_default_when_the_firmware_refuses);
+    RUN_TEST(test_reverts_when_the_fast_rate_does_not_carry);
+    RUN_TEST(test_reports_a_silent_module);
+    RUN_TEST(test_ignores_command_echo);
+    RUN_TEST(test_passthrough_carries_raw_bytes_and_restores_the_mux);
+    RUN_TEST(test_plus_inside_data_does_not_leave_passthrough);
+    RUN_TEST(test_unreachable_broker_restores_the_mux);
+    return UNITY_END();
+}
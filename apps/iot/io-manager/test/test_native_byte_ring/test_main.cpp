@@ -0,0 +1,62 @@
+#include <unity.h>
+#include "abstract/byteRing.h"
+
+void setUp() {}
+void tearDown() {}
+
+void test_bytes_come_out_in_order_across_the_wrap()
+{
+    ByteRing<8> ring;
+    int next = 0;
+    for (int round = 0; round < 10; round++)
+    {
+        for (int i = 0; i < 5; i++)
+        {
+            TEST_ASSERT_TRUE(ring.push((uint8_t)(round * 5 + i)));
+        }
+        TEST_ASSERT_EQUAL_UINT16(5, ring.size());
+        for (int i = 0; i < 5; i++)
+        {
+            TEST_ASSERT_EQUAL_INT(next++, ring.pop());
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(-1, ring.pop());
+}
+
+void test_a_full_ring_counts_and_drops()
+{
+    ByteRing<8> ring;
+    for (int i = 0; i < 7; i++)
+    {
+        TEST_ASSERT_TRUE(ring.push((uint8_t)i));
+    }
+    TEST_ASSERT_FALSE(ring.push(99));
+    TEST_ASSERT_EQUAL_UINT16(7, ring.size());
+    TEST_ASSERT_EQUAL_UINT16(1, ring.getDropped());
+    TEST_ASSERT_EQUAL_INT(0, ring.peek());
+}
+
+void test_256_bytes_use_the_whole_index_range()
+{
+    ByteRing<256> ring;
+    for (int i = 0; i < 255; i++)
+    {
+        TEST_ASSERT_TRUE(ring.push((uint8_t)i));
+    }
+    TEST_ASSERT_EQUAL_UINT16(255, ring.size());
+    TEST_ASSERT_FALSE(ring.push(0));
+    for (int i = 0; i < 255; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(i, ring.pop());
+    }
+    TEST_ASSERT_EQUAL_UINT16(0, ring.size());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_bytes_come_out_in_order_across_the_wrap);
+    RUN_TEST(test_a_full_ring_counts_and_drops);
+    RUN_TEST(test_256_bytes_use_the_whole_index_range);
+    return UNITY_END();
+}
@@ -0,0 +1,80 @@
+#include <unity.h>
+#include "utility/dnsMessage.util.h"
+
+void setUp() {}
+void tearDown() {}
+
+void test_query_encodes_labels()
+{
+    uint8_t packet[64];
+    uint16_t length = dnsWriteQuery(packet, sizeof(packet), "mqtt.example.com", 0x1234, true);
+    const uint8_t expected[] = {0x12, 0x34, 0x01, 0x00, 0x00, 0x01, 0, 0, 0, 0, 0, 0,
+                                4, 'm', 'q', 't', 't', 7, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 3, 'c', 'o', 'm', 0,
+                                0x00, 0x01, 0x00, 0x01};
+    TEST_ASSERT_EQUAL_UINT16(sizeof(expected), length);
+    TEST_ASSERT_EQUAL_MEMORY(expected, packet, sizeof(expected));
+
+    // mDNS does not ask for recursion
+    TEST_ASSERT_TRUE(dnsWriteQuery(packet, sizeof(packet), "broker.local", 1, false) > 0);
+    TEST_ASSERT_EQUAL_HEX8(0x00, packet[2]);
+}
+
+void test_query_rejects_bad_names()
+{
+    uint8_t packet[24];
+    TEST_ASSERT_EQUAL_UINT16(0, dnsWriteQuery(packet, sizeof(packet), "", 1, true));
+    TEST_ASSERT_EQUAL_UINT16(0, dnsWriteQuery(packet, sizeof(packet), "a..b", 1, true));
+    TEST_ASSERT_EQUAL_UINT16(0, dnsWriteQuery(packet, sizeof(packet), "much-too-long.example.com", 1, true));
+}
+
+void test_answer_after_a_cname()
+{
+    // Query for a.io, CNAME to b.io (compressed), then A 10.0.0.7 TTL 300
+    const uint8_t response[] = {0x00, 0x07, 0x81, 0x80, 0x00, 0x01, 0x00, 0x02, 0, 0, 0, 0,
+                                1, 'a', 2, 'i', 'o', 0, 0x00, 0x01, 0x00, 0x01,
+                                0xC0, 0x0C, 0x00, 0x05, 0x00, 0x01, 0, 0, 0, 60, 0x00, 0x04, 1, 'b', 0xC0, 0x0E,
+                                0xC0, 0x22, 0x00, 0x01, 0x00, 0x01, 0, 0, 0x01, 0x2C, 0x00, 0x04, 10, 0, 0, 7};
+    uint8_t address[4];
+    uint32_t ttl = 0;
+    TEST_ASSERT_TRUE(dnsReadAnswer(response, sizeof(response), 7, address, ttl));
+    const uint8_t expected[] = {10, 0, 0, 7};
+    TEST_ASSERT_EQUAL_MEMORY(expected, address, 4);
+    TEST_ASSERT_EQUAL_UINT32(300, ttl);
+}
+
+void test_mdns_answer_with_cache_flush()
+{
+    // Legacy unicast mDNS answer without the question section
+    const uint8_t response[] = {0xBE, 0xEF, 0x84, 0x00, 0x00, 0x00, 0x00, 0x01, 0, 0, 0, 0,
+                                6, 'b', 'r', 'o', 'k', 'e', 'r', 5, 'l', 'o', 'c', 'a', 'l', 0,
+                                0x00, 0x01, 0x80, 0x01, 0, 0, 0, 10, 0x00, 0x04, 192, 168, 1, 20};
+    uint8_t address[4];
+    uint32_t ttl = 0;
+    TEST_ASSERT_TRUE(dnsReadAnswer(response, sizeof(response), 0xBEEF, address, ttl));
+    TEST_ASSERT_EQUAL_UINT8(20, address[3]);
+    TEST_ASSERT_EQUAL_UINT32(10, ttl);
+}
+
+void test_rejects_foreign_failed_and_truncated_responses()
+{
+    uint8_t response[] = {0x00, 0x07, 0x81, 0x80, 0x00, 0x00, 0x00, 0x01, 0, 0, 0, 0,
+                          0xC0, 0x0C, 0x00, 0x01, 0x00, 0x01, 0, 0, 0, 60, 0x00, 0x04, 10, 0, 0, 7};
+    uint8_t address[4];
+    uint32_t ttl;
+    TEST_ASSERT_TRUE(dnsReadAnswer(response, sizeof(response), 7, address, ttl));
+    TEST_ASSERT_FALSE(dnsReadAnswer(response, sizeof(response), 8, address, ttl));
+    TEST_ASSERT_FALSE(dnsReadAnswer(response, sizeof(response) - 1, 7, address, ttl));
+    response[3] = 0x83; // NXDOMAIN
+    TEST_ASSERT_FALSE(dnsReadAnswer(response, sizeof(response), 7, address, ttl));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_query_encodes_labels);
+    RUN_TEST(test_query_rejects_bad_names);
+    RUN_TEST(test_answer_after_a_cname);
+    RUN_TEST(test_mdns_answer_with_cache_flush);
+    RUN_TEST(test_rejects_foreign_failed_and_truncated_responses);
+    return UNITY_END();
+}
@@ -0,0 +1,379 @@
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <string>
+#include "utility/httpTokenizer.util.h"
+
+// Counts heap allocations so the tests can assert the tokenizer makes none
+static unsigned long allocations = 0;
+
+void *operator new(size_t size)
+{
+    allocations++;
+    void *p = malloc(size ? size : 1);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+// The parseRequest utilities the tokenizer replaced, with std::string in
+// place of Arduino String, kept as the reference for decoding and the
+// baseline for the benchmark
+static std::string legacyUrlDecode(const std::string &input)
+{
+    std::string decoded = "";
+    for (unsigned int i = 0; i < input.length(); ++i)
+    {
+        if (input[i] == '+')
+        {
+            decoded += ' ';
+        }
+        else if (input[i] == '%' && i + 2 < input.length())
+        {
+            char hex[3] = {input[i + 1], input[i + 2], '\0'};
+            char decodedChar = strtol(hex, nullptr, 16);
+            decoded += decodedChar;
+            i += 2;
+        }
+        else
+        {
+            decoded += input[i];
+        }
+    }
+    return decoded;
+}
+
+static std::map<std::string, std::string> legacyParsePostBody(const std::string &body)
+{
+    std::map<std::string, std::string> bodyMap;
+    size_t start = 0;
+    while (start < body.length())
+    {
+        size_t pairEnd = body.find('&', start);
+        if (pairEnd == std::string::npos)
+            pairEnd = body.length();
+        std::string pair = body.substr(start, pairEnd - start);
+        size_t equalSign = pair.find('=');
+        if (equalSign != std::string::npos)
+        {
+            std::string key = legacyUrlDecode(pair.substr(0, equalSign));
+            std::string value = legacyUrlDecode(pair.substr(equalSign + 1));
+            bodyMap[key] = value;
+        }
+        start = pairEnd + 1;
+    }
+    return bodyMap;
+}
+
+static std::string viewString(const char *buffer, HttpView view)
+{
+    return std::string(buffer + view.offset, view.length);
+}
+
+// xorshift, deterministic across runs
+static uint32_t rngState = 2463534242u;
+static uint32_t nextRandom()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static std::string encode(const std::string &text)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    std::string out;
+    for (unsigned char c : text)
+    {
+        if (c == ' ')
+        {
+            out += '+';
+        }
+        else if (isalnum(c) || c == '-' || c == '_' || c == '.')
+        {
+            out += (char)c;
+        }
+        else
+        {
+            out += '%';
+            out += digits[c >> 4];
+            out += digits[c & 15];
+        }
+    }
+    return out;
+}
+
+static std::string randomText(uint8_t maxLength)
+{
+    std::string text;
+    uint8_t length = nextRandom() % (maxLength + 1);
+    for (uint8_t i = 0; i < length; i++)
+    {
+        text += (char)(1 + nextRandom() % 255);
+    }
+    return text;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_request_line_is_split_into_views()
+{
+    const char line[] = "GET /api/data?x=1&y=two HTTP/1.1\r\n";
+    HttpRequestLine request = {};
+    TEST_ASSERT_TRUE(HttpTokenizer::parseRequestLine(line, sizeof(line) - 1, request));
+    TEST_ASSERT_EQUAL_STRING("GET", viewString(line, request.method).c_str());
+    TEST_ASSERT_EQUAL_STRING("/api/data", viewString(line, request.path).c_str());
+    TEST_ASSERT_EQUAL_STRING("x=1&y=two", viewString(line, request.query).c_str());
+    TEST_ASSERT_EQUAL_STRING("HTTP/1.1", viewString(line, request.version).c_str());
+
+    const char plain[] = "POST /save HTTP/1.1";
+    TEST_ASSERT_TRUE(HttpTokenizer::parseRequestLine(plain, sizeof(plain) - 1, request));
+    TEST_ASSERT_EQUAL_UINT16(0, request.query.length);
+    TEST_ASSERT_TRUE(HttpTokenizer::equals(plain, request.path, "/save"));
+}
+
+void test_malformed_request_lines_are_rejected()
+{
+    const char *bad[] = {"", "GET", "GET /", "GET  HTTP/1.1", " / HTTP/1.1", "GET / HTTP/1.1 extra", "GET index HTTP/1.1", "GET / "};
+    for (const char *line : bad)
+    {
+        HttpRequestLine request = {};
+        TEST_ASSERT_FALSE_MESSAGE(HttpTokenizer::parseRequestLine(line, strlen(line), request), line);
+    }
+}
+
+void test_headers_and_content_length()
+{
+    const char line[] = "content-LENGTH: \t 42 \r\n";
+    HttpHeader header = {};
+    TEST_ASSERT_TRUE(HttpTokenizer::parseHeader(line, sizeof(line) - 1, header));
+    TEST_ASSERT_TRUE(HttpTokenizer::equalsIgnoreCase(line, header.name, "Content-Length"));
+    TEST_ASSERT_EQUAL_INT32(42, HttpTokenizer::parseLength(line, header.value, 100000L));
+
+    const char *badLengths[] = {"", "-1", "4 2", "0x10", "999999999999"};
+    for (const char *text : badLengths)
+    {
+        HttpView view = {0, (uint16_t)strlen(text)};
+        TEST_ASSERT_EQUAL_INT32_MESSAGE(-1, HttpTokenizer::parseLength(text, view, 100000L), text);
+    }
+
+    const char encoding[] = "Accept-Encoding: deflate, GZip;q=1.0";
+    TEST_ASSERT_TRUE(HttpTokenizer::parseHeader(encoding, sizeof(encoding) - 1, header));
+    TEST_ASSERT_TRUE(HttpTokenizer::contains(encoding, header.value, "gzip"));
+    TEST_ASSERT_FALSE(HttpTokenizer::contains(encoding, header.value, "br"));
+    TEST_ASSERT_FALSE(HttpTokenizer::contains(encoding, {0, 3}, "Accept"));
+
+    const char noColon[] = "Host example";
+    const char spacedName[] = "Bad Name: x";
+    TEST_ASSERT_FALSE(HttpTokenizer::parseHeader(noColon, sizeof(noColon) - 1, header));
+    TEST_ASSERT_FALSE(HttpTokenizer::parseHeader(spacedName, sizeof(spacedName) - 1, header));
+}
+
+void test_form_fields_are_decoded_in_place()
+{
+    char body[] = "ssid=My+Home%20Net&password=p%26ss%3Dw0rd&flag&empty=";
+    HttpForm form;
+    HttpTokenizer::parseForm(body, {0, (uint16_t)(sizeof(body) - 1)}, form);
+    TEST_ASSERT_EQUAL_UINT8(3, form.count);
+
+    HttpView value = {};
+    TEST_ASSERT_TRUE(HttpTokenizer::findField(body, form, "ssid", value));
+    TEST_ASSERT_EQUAL_STRING("My Home Net", viewString(body, value).c_str());
+    TEST_ASSERT_TRUE(HttpTokenizer::findField(body, form, "password", value));
+    TEST_ASSERT_EQUAL_STRING("p&ss=w0rd", viewString(body, value).c_str());
+    TEST_ASSERT_TRUE(HttpTokenizer::findField(body, form, "empty", value));
+    TEST_ASSERT_EQUAL_UINT16(0, value.length);
+    TEST_ASSERT_FALSE(HttpTokenizer::findField(body, form, "flag", value));
+
+    char out[8];
+    TEST_ASSERT_TRUE(HttpTokenizer::findField(body, form, "ssid", value));
+    TEST_ASSERT_EQUAL_UINT16(7, HttpTokenizer::copy(body, value, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("My Home", out);
+}
+
+void test_field_limit_sets_truncated()
+{
+    char body[] = "a=1&b=2&c=3&d=4&e=5&f=6&g=7&h=8&i=9";
+    HttpForm form;
+    HttpTokenizer::parseForm(body, {0, (uint16_t)(sizeof(body) - 1)}, form);
+    TEST_ASSERT_EQUAL_UINT8(HTTP_MAX_FIELDS, form.count);
+    TEST_ASSERT_TRUE(form.truncated);
+}
+
+// Well formed random forms decode to what the legacy parser produced
+void test_matches_legacy_parser_on_encoded_forms()
+{
+    for (int round = 0; round < 2000; round++)
+    {
+        std::map<std::string, std::string> expected;
+        std::string body;
+        uint8_t pairs = 1 + nextRandom() % HTTP_MAX_FIELDS;
+        for (uint8_t i = 0; i < pairs; i++)
+        {
+            std::string key = "k" + std::to_string(i) + randomText(6);
+            std::string value = randomText(20);
+            expected[key] = value;
+            body += (i ? "&" : "") + encode(key) + "=" + encode(value);
+        }
+        TEST_ASSERT_TRUE(expected == legacyParsePostBody(body));
+
+        std::string buffer = body;
+        HttpForm form;
+        HttpTokenizer::parseForm(&buffer[0], {0, (uint16_t)buffer.size()}, form);
+        TEST_ASSERT_EQUAL_UINT8(pairs, form.count);
+        for (uint8_t i = 0; i < form.count; i++)
+        {
+            std::string key = viewString(buffer.data(), form.fields[i].key);
+            TEST_ASSERT_TRUE(expected.count(key) == 1);
+            TEST_ASSERT_TRUE(expected[key] == viewString(buffer.data(), form.fields[i].value));
+        }
+    }
+}
+
+// Random bytes (biased toward the delimiters) inside a guarded buffer: every
+// view stays within the input and nothing outside it is written
+void test_fuzz_stays_in_bounds()
+{
+    static const char alphabet[] = " /?&=%+:\r\n\tGETPOSHT1.0aF9";
+    const uint16_t guard = 32;
+    char storage[256 + 2 * guard];
+
+    for (int round = 0; round < 200000; round++)
+    {
+        uint16_t length = nextRandom() % 257;
+        memset(storage, 0x5A, sizeof(storage));
+        char *buffer = storage + guard;
+        for (uint16_t i = 0; i < length; i++)
+        {
+            uint32_t r = nextRandom();
+            buffer[i] = r & 1 ? alphabet[(r >> 1) % (sizeof(alphabet) - 1)] : (char)(r >> 8);
+        }
+
+        HttpRequestLine request = {};
+        if (HttpTokenizer::parseRequestLine(buffer, length, request))
+        {
+            HttpView views[] = {request.method, request.path, request.query, request.version};
+            for (HttpView view : views)
+            {
+                TEST_ASSERT_TRUE(view.offset + view.length <= length);
+            }
+            TEST_ASSERT_TRUE(request.method.length > 0 && request.path.length > 0 && request.version.length > 0);
+        }
+
+        HttpHeader header = {};
+        if (HttpTokenizer::parseHeader(buffer, length, header))
+        {
+            TEST_ASSERT_TRUE(header.name.length > 0);
+            TEST_ASSERT_TRUE(header.value.offset + header.value.length <= length);
+            TEST_ASSERT_TRUE(HttpTokenizer::parseLength(buffer, header.value, 100000L) <= 100000L);
+        }
+
+        HttpForm form;
+        HttpTokenizer::parseForm(buffer, {0, length}, form);
+        TEST_ASSERT_TRUE(form.count <= HTTP_MAX_FIELDS);
+        for (uint8_t i = 0; i < form.count; i++)
+        {
+            TEST_ASSERT_TRUE(form.fields[i].key.offset + form.fields[i].key.length <= length);
+            TEST_ASSERT_TRUE(form.fields[i].value.offset + form.fields[i].value.length <= length);
+        }
+
+        for (uint16_t i = 0; i < guard; i++)
+        {
+            TEST_ASSERT_EQUAL_HEX8(0x5A, storage[i]);
+            TEST_ASSERT_EQUAL_HEX8(0x5A, storage[guard + 256 + i]);
+        }
+    }
+}
+
+void test_tokenizer_does_not_allocate()
+{
+    char body[] = "ssid=My+Home%20Net&password=secret%21";
+    const char line[] = "POST /save?x=1 HTTP/1.1";
+    unsigned long before = allocations;
+
+    HttpRequestLine request = {};
+    HttpForm form;
+    HttpView value = {};
+    HttpTokenizer::parseRequestLine(line, sizeof(line) - 1, request);
+    HttpTokenizer::parseForm(body, {0, (uint16_t)(sizeof(body) - 1)}, form);
+    HttpTokenizer::findField(body, form, "password", value);
+    TEST_ASSERT_EQUAL_UINT32(before, allocations);
+
+    legacyParsePostBody("ssid=My+Home%20Net&password=secret%21");
+    TEST_ASSERT_TRUE(allocations > before);
+}
+
+// Host timing of the credentials form, printed for comparison (not asserted,
+// the ratio on the host is only indicative of the AVR)
+void test_benchmark_against_legacy_parser()
+{
+    const std::string body = "ssid=My+Home%20Network&password=c0rrect%20horse%2Bbattery&remember=on";
+    const int iterations = 50000;
+    volatile size_t sink = 0;
+
+    unsigned long legacyAllocations = allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        std::map<std::string, std::string> fields = legacyParsePostBody(body);
+        sink = sink + fields["password"].size();
+    }
+    auto legacyTime = std::chrono::steady_clock::now() - start;
+    legacyAllocations = allocations - legacyAllocations;
+
+    char buffer[128];
+    unsigned long tokenizerAllocations = allocations;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        memcpy(buffer, body.data(), body.size());
+        HttpForm form;
+        HttpView value = {};
+        HttpTokenizer::parseForm(buffer, {0, (uint16_t)body.size()}, form);
+        HttpTokenizer::findField(buffer, form, "password", value);
+        sink = sink + value.length;
+    }
+    auto tokenizerTime = std::chrono::steady_clock::now() - start;
+    tokenizerAllocations = allocations - tokenizerAllocations;
+
+    double legacyNs = std::chrono::duration<double, std::nano>(legacyTime).count() / iterations;
+    double tokenizerNs = std::chrono::duration<double, std::nano>(tokenizerTime).count() / iterations;
+    char message[160];
+    snprintf(message, sizeof(message), "legacy %.0f ns/%lu allocs, tokenizer %.0f ns/%lu allocs per form (x%.1f)",
+             legacyNs, legacyAllocations / iterations, tokenizerNs, tokenizerAllocations / iterations,
+             tokenizerNs > 0 ? legacyNs / tokenizerNs : 0.0);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_UINT32(0, tokenizerAllocations);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_request_line_is_split_into_views);
+    RUN_TEST(test_malformed_request_lines_are_rejected);
+    RUN_TEST(test_headers_and_content_length);
+    RUN_TEST(test_form_fields_are_decoded_in_place);
+    RUN_TEST(test_field_limit_sets_truncated);
+    RUN_TEST(test_matches_legacy_parser_on_encoded_forms);
+    RUN_TEST(test_fuzz_stays_in_bounds);
+    RUN_TEST(test_tokenizer_does_not_allocate);
+    RUN_TEST(test_benchmark_against_legacy_parser);
+    return UNITY_END();
+}
@@ -0,0 +1,136 @@
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include "abstract/isrSnapshot.h"
+
+// Multi-word payload with an invariant that a torn read would break
+struct Sample
+{
+    uint32_t pulses;
+    uint32_t periodUs;
+    uint32_t edgeUs;
+    uint32_t check;
+};
+
+static Sample makeSample(uint32_t n)
+{
+    Sample sample = {n, n * 3u, n * 7u, ~n};
+    return sample;
+}
+
+static bool isConsistent(const Sample &sample)
+{
+    return sample.periodUs == sample.pulses * 3u && sample.edgeUs == sample.pulses * 7u && sample.check == ~sample.pulses;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_read_returns_last_write()
+{
+    IsrSnapshot<Sample> snapshot;
+    snapshot.write(makeSample(42));
+    Sample sample = snapshot.read();
+    TEST_ASSERT_EQUAL_UINT32(42, sample.pulses);
+    TEST_ASSERT_TRUE(isConsistent(sample));
+}
+
+void test_read_fails_while_write_in_progress()
+{
+    IsrSnapshot<Sample> snapshot;
+    Sample out = makeSample(0);
+
+    Sample &live = snapshot.beginWrite();
+    live.pulses = 1; // Interrupted half way through the update
+    TEST_ASSERT_FALSE(snapshot.tryRead(out));
+
+    live = makeSample(1);
+    snapshot.endWrite();
+    TEST_ASSERT_TRUE(snapshot.tryRead(out));
+    TEST_ASSERT_TRUE(isConsistent(out));
+}
+
+void test_sequence_advances_per_write()
+{
+    IsrSnapshot<Sample> snapshot;
+    uint8_t before = snapshot.getSequence();
+    snapshot.write(makeSample(1));
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)(before + 2), snapshot.getSequence());
+}
+
+// A writer thread stands in for the ISR hammering the snapshot while the
+// reader copies it, every copy must satisfy the invariant. Like a real ISR
+// the writer cannot lap a reader by 128 writes: it waits for a completed
+// read every 64 writes, otherwise a descheduled reader could be starved or
+// see the one-byte sequence wrap. It also yields half way through some
+// writes so even a single core host interleaves a read with an update.
+void test_concurrent_updates_never_tear()
+{
+    IsrSnapshot<Sample> snapshot;
+    std::atomic<bool> done(false);
+    std::atomic<uint32_t> completedReads(0);
+
+    std::thread writer([&]() {
+        uint32_t seenReads = 0;
+        for (uint32_t n = 1; n <= 1000000; n++)
+        {
+            if (n % 64 == 0)
+            {
+                while (completedReads.load() == seenReads)
+                {
+                    std::this_thread::yield();
+                }
+                seenReads = completedReads.load();
+            }
+            Sample &live = snapshot.beginWrite();
+            live.pulses = n;
+            if (n % 64 == 32)
+            {
+                std::this_thread::yield();
+            }
+            live.periodUs = n * 3u;
+            live.edgeUs = n * 7u;
+            live.check = ~n;
+            snapshot.endWrite();
+        }
+        done = true;
+    });
+
+    uint32_t reads = 0;
+    uint32_t torn = 0;
+    uint32_t last = 0;
+    bool monotonic = true;
+    while (!done)
+    {
+        Sample sample = makeSample(0);
+        if (!snapshot.tryRead(sample))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        if (!isConsistent(sample) && sample.pulses != 0)
+        {
+            torn++;
+        }
+        monotonic = monotonic && sample.pulses >= last;
+        last = sample.pulses;
+        reads++;
+        completedReads.store(reads);
+        std::this_thread::yield();
+    }
+    writer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, torn);
+    TEST_ASSERT_TRUE(monotonic);
+    TEST_ASSERT_TRUE(reads > 0);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_read_returns_last_write);
+    RUN_TEST(test_read_fails_while_write_in_progress);
+    RUN_TEST(test_sequence_advances_per_write);
+    RUN_TEST(test_concurrent_updates_never_tear);
+    return UNITY_END();
+}
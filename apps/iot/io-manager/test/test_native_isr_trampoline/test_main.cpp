@@ -0,0 +1,122 @@
+#include <unity.h>
+#include "abstract/isrTrampoline.h"
+
+// Simulated external interrupt controller: one vector per INTx line
+static void (*vectors[6])() = {nullptr};
+
+static void attachSimulated(uint8_t line, void (*handler)())
+{
+    vectors[line] = handler;
+}
+
+static void fire(uint8_t line, int times)
+{
+    for (int i = 0; i < times; i++)
+    {
+        vectors[line]();
+    }
+}
+
+// Stand-in for an interrupt driven flow meter
+class SimulatedMeter
+{
+public:
+    SimulatedMeter(uint8_t line, IsrBinding isr) : line(line), isr(isr), pulses(0) {}
+    ~SimulatedMeter()
+    {
+        isr.unbind(this);
+    }
+
+    bool initialize()
+    {
+        if (!isr.bind(this))
+        {
+            return false;
+        }
+        attachSimulated(line, isr.handler);
+        return true;
+    }
+
+    void onInterrupt()
+    {
+        pulses++;
+    }
+
+    uint8_t line;
+    IsrBinding isr;
+    volatile uint32_t pulses;
+};
+
+void setUp() {}
+void tearDown() {}
+
+void test_three_meters_receive_only_their_own_pulses()
+{
+    SimulatedMeter supply(0, IsrTrampoline<2, SimulatedMeter>::binding());
+    SimulatedMeter ret(1, IsrTrampoline<3, SimulatedMeter>::binding());
+    SimulatedMeter drain(5, IsrTrampoline<18, SimulatedMeter>::binding());
+
+    TEST_ASSERT_TRUE(supply.initialize());
+    TEST_ASSERT_TRUE(ret.initialize());
+    TEST_ASSERT_TRUE(drain.initialize());
+
+    fire(0, 10);
+    fire(1, 3);
+    fire(5, 7);
+    fire(0, 5);
+
+    TEST_ASSERT_EQUAL_UINT32(15, supply.pulses);
+    TEST_ASSERT_EQUAL_UINT32(3, ret.pulses);
+    TEST_ASSERT_EQUAL_UINT32(7, drain.pulses);
+}
+
+void test_each_source_gets_a_distinct_handler()
+{
+    typedef IsrTrampoline<2, SimulatedMeter> Supply;
+    typedef IsrTrampoline<3, SimulatedMeter> Return;
+    typedef IsrTrampoline<18, SimulatedMeter> Drain;
+
+    TEST_ASSERT_TRUE(Supply::binding().handler != Return::binding().handler);
+    TEST_ASSERT_TRUE(Return::binding().handler != Drain::binding().handler);
+}
+
+void test_second_instance_cannot_steal_an_interrupt()
+{
+    SimulatedMeter first(2, IsrTrampoline<19, SimulatedMeter>::binding());
+    SimulatedMeter second(2, IsrTrampoline<19, SimulatedMeter>::binding());
+
+    TEST_ASSERT_TRUE(first.initialize());
+    TEST_ASSERT_FALSE(second.initialize());
+
+    fire(2, 4);
+    TEST_ASSERT_EQUAL_UINT32(4, first.pulses);
+    TEST_ASSERT_EQUAL_UINT32(0, second.pulses);
+}
+
+void test_unbind_releases_the_interrupt()
+{
+    {
+        SimulatedMeter temporary(3, IsrTrampoline<20, SimulatedMeter>::binding());
+        TEST_ASSERT_TRUE(temporary.initialize());
+    }
+    typedef IsrTrampoline<20, SimulatedMeter> Spare;
+    TEST_ASSERT_NULL(Spare::get());
+
+    // A stray interrupt after unbinding is ignored
+    fire(3, 1);
+
+    SimulatedMeter replacement(3, IsrTrampoline<20, SimulatedMeter>::binding());
+    TEST_ASSERT_TRUE(replacement.initialize());
+    fire(3, 2);
+    TEST_ASSERT_EQUAL_UINT32(2, replacement.pulses);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_three_meters_receive_only_their_own_pulses);
+    RUN_TEST(test_each_source_gets_a_distinct_handler);
+    RUN_TEST(test_second_instance_cannot_steal_an_interrupt);
+    RUN_TEST(test_unbind_releases_the_interrupt);
+    return UNITY_END();
+}
@@ -0,0 +1,62 @@
+#include <unity.h>
+#include "utility/latencyWindow.util.h"
+
+void setUp() {}
+void tearDown() {}
+
+void test_empty_window_reports_zero()
+{
+    LatencyWindow<8> window;
+    TEST_ASSERT_EQUAL_UINT8(0, window.size());
+    TEST_ASSERT_EQUAL_UINT16(0, window.percentile(50));
+    TEST_ASSERT_EQUAL_UINT16(0, window.getLast());
+}
+
+void test_nearest_rank_percentiles()
+{
+    LatencyWindow<16> window;
+    const uint16_t samples[] = {40, 10, 90, 20, 70, 30, 100, 50, 80, 60};
+    for (uint16_t sample : samples)
+    {
+        window.add(sample);
+    }
+    TEST_ASSERT_EQUAL_UINT16(50, window.percentile(50));
+    TEST_ASSERT_EQUAL_UINT16(90, window.percentile(90));
+    TEST_ASSERT_EQUAL_UINT16(10, window.percentile(0));
+    TEST_ASSERT_EQUAL_UINT16(100, window.getMax());
+    TEST_ASSERT_EQUAL_UINT16(60, window.getLast());
+}
+
+void test_old_samples_leave_the_window()
+{
+    LatencyWindow<4> window;
+    for (uint16_t i = 1; i <= 10; i++)
+    {
+        window.add(i * 100);
+    }
+    TEST_ASSERT_EQUAL_UINT8(4, window.size());
+    TEST_ASSERT_EQUAL_UINT32(10, window.getTotal());
+    TEST_ASSERT_EQUAL_UINT16(700, window.percentile(0));
+    TEST_ASSERT_EQUAL_UINT16(1000, window.getMax());
+}
+
+void test_large_values_saturate()
+{
+    LatencyWindow<4> narrow;
+    narrow.add(120000UL);
+    TEST_ASSERT_EQUAL_UINT16(65535, narrow.getLast());
+
+    LatencyWindow<4, uint32_t> wide;
+    wide.add(120000UL);
+    TEST_ASSERT_EQUAL_UINT32(120000UL, wide.getLast());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_window_reports_zero);
+    RUN_TEST(test_nearest_rank_percentiles);
+    RUN_TEST(test_old_samples_leave_the_window);
+    RUN_TEST(test_large_values_saturate);
+    return UNITY_END();
+}
@@ -0,0 +1,161 @@
+#include <unity.h>
+#include "abstract/mqttInflight.h"
+
+typedef MqttInflightWindow<3, 64> Window;
+
+void setUp() {}
+void tearDown() {}
+
+void test_header_encodes_the_remaining_length()
+{
+    uint8_t out[8];
+    // 2 + 5 topic + 2 id + 10 payload = 19, one length byte
+    TEST_ASSERT_EQUAL_UINT8(4, mqttWritePublishHeader(out, 5, 10));
+    TEST_ASSERT_EQUAL_HEX8(0x32, out[0]);
+    TEST_ASSERT_EQUAL_HEX8(19, out[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x00, out[2]);
+    TEST_ASSERT_EQUAL_HEX8(0x05, out[3]);
+
+    // 2 + 11 + 2 + 200 = 215, two length bytes
+    TEST_ASSERT_EQUAL_UINT8(5, mqttWritePublishHeader(out, 11, 200));
+    TEST_ASSERT_EQUAL_HEX8(0xD7, out[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, out[2]);
+    TEST_ASSERT_EQUAL_HEX8(0x0B, out[4]);
+}
+
+void test_scanner_finds_pubacks_between_other_packets()
+{
+    // CONNACK, PUBACK 7, incoming PUBLISH whose payload looks like a PUBACK,
+    // PINGRESP, PUBACK 0x0102
+    const uint8_t stream[] = {0x20, 0x02, 0x00, 0x00,
+                              0x40, 0x02, 0x00, 0x07,
+                              0x30, 0x07, 0x00, 0x01, 't', 0x40, 0x02, 0x00, 0x09,
+                              0xD0, 0x00,
+                              0x40, 0x02, 0x01, 0x02};
+    MqttAckScanner scanner;
+    uint16_t found[4];
+    int count = 0;
+    for (uint8_t c : stream)
+    {
+        uint16_t packetId = scanner.feed(c);
+        if (packetId != 0 && count < 4)
+        {
+            found[count++] = packetId;
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(2, count);
+    TEST_ASSERT_EQUAL_UINT16(7, found[0]);
+    TEST_ASSERT_EQUAL_UINT16(0x0102, found[1]);
+}
+
+void test_scanner_reports_completed_packet_types()
+{
+    MqttAckScanner scanner;
+    scanner.feed(0xD0);
+    TEST_ASSERT_EQUAL_HEX8(0, scanner.completed());
+    scanner.feed(0x00);
+    TEST_ASSERT_EQUAL_HEX8(MQTT_PINGRESP, scanner.completed());
+
+    scanner.feed(0x40);
+    scanner.feed(0x02);
+    scanner.feed(0x00);
+    TEST_ASSERT_EQUAL_HEX8(0, scanner.completed());
+    scanner.feed(0x05);
+    TEST_ASSERT_EQUAL_HEX8(MQTT_PUBACK, scanner.completed());
+}
+
+void test_window_fills_and_frees_on_ack()
+{
+    Window window;
+    Window::Slot *a = window.claim();
+    Window::Slot *b = window.claim();
+    Window::Slot *c = window.claim();
+    TEST_ASSERT_NOT_NULL(c);
+    TEST_ASSERT_NULL(window.claim());
+    TEST_ASSERT_EQUAL_UINT8(3, window.inFlight());
+    TEST_ASSERT_TRUE(a->packetId != b->packetId);
+
+    TEST_ASSERT_TRUE(window.acknowledge(b->packetId));
+    TEST_ASSERT_FALSE(window.acknowledge(999));
+    TEST_ASSERT_EQUAL_UINT8(2, window.inFlight());
+    TEST_ASSERT_EQUAL_UINT32(1, window.getAcked());
+    TEST_ASSERT_NOT_NULL(window.claim());
+}
+
+void test_overdue_packets_go_out_again_with_dup()
+{
+    Window window;
+    Window::Slot *slot = window.claim();
+    slot->packet[0] = MQTT_PUBLISH_QOS1;
+    TEST_ASSERT_EQUAL_PTR(slot, window.nextDue(0, 1000));
+    window.markSent(*slot, 0);
+
+    // Pipelined, nothing to do while the ack is not overdue
+    TEST_ASSERT_NULL(window.nextDue(999, 1000));
+    TEST_ASSERT_EQUAL_PTR(slot, window.nextDue(1000, 1000));
+    TEST_ASSERT_EQUAL_HEX8(MQTT_PUBLISH_QOS1 | MQTT_PUBLISH_DUP, slot->packet[0]);
+    window.markSent(*slot, 1000);
+    TEST_ASSERT_EQUAL_UINT32(1, window.getRetransmits());
+    TEST_ASSERT_EQUAL_UINT8(2, slot->attempts);
+}
+
+void test_reconnect_resends_oldest_first()
+{
+    Window window;
+    Window::Slot *first = window.claim();
+    Window::Slot *second = window.claim();
+    first->packet[0] = second->packet[0] = MQTT_PUBLISH_QOS1;
+    window.markSent(*first, 0);
+    window.markSent(*second, 0);
+    TEST_ASSERT_NULL(window.nextDue(10, 1000));
+
+    window.resendAll();
+    TEST_ASSERT_EQUAL_PTR(first, window.nextDue(10, 1000));
+    window.markSent(*first, 10);
+    TEST_ASSERT_EQUAL_PTR(second, window.nextDue(10, 1000));
+    window.markSent(*second, 10);
+    TEST_ASSERT_NULL(window.nextDue(10, 1000));
+}
+
+void test_longest_wait_covers_sent_packets_only()
+{
+    Window window;
+    Window::Slot *first = window.claim();
+    Window::Slot *second = window.claim();
+    first->packet[0] = second->packet[0] = MQTT_PUBLISH_QOS1;
+    TEST_ASSERT_EQUAL_UINT32(0, window.longestWait(500));
+    TEST_ASSERT_NULL(window.find(first->packetId));
+
+    window.markSent(*first, 100);
+    window.markSent(*second, 300);
+    TEST_ASSERT_EQUAL_UINT32(400, window.longestWait(500));
+    TEST_ASSERT_EQUAL_UINT32(100, window.find(first->packetId)->sentAt);
+
+    // Waiting for the reconnect is not waiting for the broker
+    window.resendAll();
+    TEST_ASSERT_EQUAL_UINT32(0, window.longestWait(500));
+}
+
+void test_expired_packets_free_their_slot()
+{
+    Window window;
+    Window::Slot *slot = window.claim();
+    window.expire(*slot);
+    TEST_ASSERT_EQUAL_UINT8(0, window.inFlight());
+    TEST_ASSERT_EQUAL_UINT32(1, window.getExpired());
+    TEST_ASSERT_NULL(window.nextDue(0, 1000));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_header_encodes_the_remaining_length);
+    RUN_TEST(test_scanner_finds_pubacks_between_other_packets);
+    RUN_TEST(test_scanner_reports_completed_packet_types);
+    RUN_TEST(test_window_fills_and_frees_on_ack);
+    RUN_TEST(test_overdue_packets_go_out_again_with_dup);
+    RUN_TEST(test_reconnect_resends_oldest_first);
+    RUN_TEST(test_longest_wait_covers_sent_packets_only);
+    RUN_TEST(test_expired_packets_free_their_slot);
+    return UNITY_END();
+}
@@ -0,0 +1,114 @@
+#include <unity.h>
+#include <math.h>
+#include "utility/rollingStats.util.h"
+
+void setUp() {}
+void tearDown() {}
+
+// Pseudo random but repeatable samples around 7
+static float sample(int i)
+{
+    return 7.0f + (float)((i * 37) % 23 - 11) / 10.0f;
+}
+
+// Reference statistics of the last `window` samples ending at `last`
+static void reference(int last, int window, float &mean, float &variance, float &min, float &max)
+{
+    int first = last - window + 1;
+    double sum = 0;
+    min = max = sample(first);
+    for (int i = first; i <= last; i++)
+    {
+        sum += sample(i);
+        min = sample(i) < min ? sample(i) : min;
+        max = sample(i) > max ? sample(i) : max;
+    }
+    mean = (float)(sum / window);
+    double squares = 0;
+    for (int i = first; i <= last; i++)
+    {
+        squares += (sample(i) - mean) * (sample(i) - mean);
+    }
+    variance = (float)(squares / (window - 1));
+}
+
+void test_empty_window()
+{
+    RollingStats<8> stats;
+    TEST_ASSERT_EQUAL_UINT8(0, stats.size());
+    TEST_ASSERT_TRUE(isnan(stats.getMean()));
+    TEST_ASSERT_TRUE(isnan(stats.getMin()));
+    TEST_ASSERT_EQUAL_FLOAT(0, stats.getVariance());
+    TEST_ASSERT_EQUAL_FLOAT(0, stats.getSlope());
+}
+
+// Welford with removal and the monotonic queues against a full recompute,
+// over several laps so the periodic rebuild runs too
+void test_matches_a_full_recompute_across_evictions()
+{
+    RollingStats<8> stats;
+    for (int i = 0; i < 50; i++)
+    {
+        stats.add(sample(i), i * 1000UL);
+        int window = i + 1 < 8 ? i + 1 : 8;
+        if (window < 2)
+        {
+            continue;
+        }
+        float mean, variance, min, max;
+        reference(i, window, mean, variance, min, max);
+        TEST_ASSERT_EQUAL_UINT8(window, stats.size());
+        TEST_ASSERT_FLOAT_WITHIN(1e-4f, mean, stats.getMean());
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, variance, stats.getVariance());
+        TEST_ASSERT_EQUAL_FLOAT(min, stats.getMin());
+        TEST_ASSERT_EQUAL_FLOAT(max, stats.getMax());
+    }
+}
+
+void test_slope_of_a_ramp_survives_evictions()
+{
+    RollingStats<8> stats;
+    // 0.5 units per second, samples every 2 s
+    for (int i = 0; i < 30; i++)
+    {
+        stats.add(3.0f + i * 1.0f, i * 2000UL);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.5f, stats.getSlope());
+
+    RollingStats<8> falling;
+    for (int i = 0; i < 5; i++)
+    {
+        falling.add(10.0f - i * 0.25f, i * 1000UL);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, -0.25f, falling.getSlope());
+}
+
+void test_window_is_clamped_and_resets()
+{
+    RollingStats<8> stats;
+    stats.setWindow(1);
+    TEST_ASSERT_EQUAL_UINT8(2, stats.getWindow());
+    stats.setWindow(20);
+    TEST_ASSERT_EQUAL_UINT8(8, stats.getWindow());
+
+    stats.setWindow(3);
+    for (int i = 0; i < 5; i++)
+    {
+        stats.add((float)i, i * 1000UL);
+    }
+    TEST_ASSERT_EQUAL_UINT8(3, stats.size());
+    TEST_ASSERT_EQUAL_FLOAT(2, stats.getMin());
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 3, stats.getMean());
+    stats.setWindow(4);
+    TEST_ASSERT_EQUAL_UINT8(0, stats.size());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_window);
+    RUN_TEST(test_matches_a_full_recompute_across_evictions);
+    RUN_TEST(test_slope_of_a_ramp_survives_evictions);
+    RUN_TEST(test_window_is_clamped_and_resets);
+    return UNITY_END();
+}
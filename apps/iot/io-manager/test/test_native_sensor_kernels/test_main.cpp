@@ -0,0 +1,124 @@
+#include <unity.h>
+#include <math.h>
+#include "utility/sensorKernels.util.h"
+
+// Float references, evaluated in double. The pH reference is the legacy
+// PHSensor formula, temperature terms included.
+static double referencePh(double neutralMv, double acidMv, double temperature, int samples, long rawSum)
+{
+    double voltage = rawSum / (double)samples / 1023.0 * 5000.0;
+    double tempSlope = (59.16 + 0.1984 * (temperature - 25.0)) * 0.33;
+    double slope = 3.0 / ((neutralMv - 1500.0) / tempSlope - (acidMv - 1500.0) / tempSlope);
+    double intercept = 7.0 - slope * (neutralMv - 1500.0) / tempSlope;
+    return slope * ((voltage - 1500.0) / tempSlope) + intercept;
+}
+
+static double referenceTds(double temperature, int adc)
+{
+    double voltage = adc * (5.0 / 1024.0);
+    double compensationVoltage = voltage / (1.0 + 0.02 * (temperature - 25.0));
+    return (133.42 * compensationVoltage * compensationVoltage * compensationVoltage -
+            255.86 * compensationVoltage * compensationVoltage + 857.39 * compensationVoltage) *
+           0.5;
+}
+
+// Formula the pH sensor used before the kernel, in float as on the AVR
+static double legacyPh(float neutralVoltage, float acidVoltage, float temperature, long rawSum)
+{
+    float voltage = (rawSum / 50.0f) / 1023.0 * 5000.0;
+    float k = 0.33;
+    float tempSlope = (59.16 + 0.1984 * (temperature - 25.0)) * k;
+    float slope = (7.0 - 4.0) / ((neutralVoltage - 1500.0) / tempSlope - (acidVoltage - 1500.0) / tempSlope);
+    float intercept = 7.0 - slope * (neutralVoltage - 1500.0) / (tempSlope);
+    return slope * ((voltage - 1500.0) / tempSlope) + intercept;
+}
+
+void setUp() {}
+void tearDown() {}
+
+// The kernel has no temperature input, the legacy formula must not have
+// depended on it anywhere in the range the probe works in
+void test_ph_fixed_point_error_bound()
+{
+    const float calibrations[][2] = {{1950, 1615}, {1800, 1400}, {1650, 1500}, {1500, 1650}};
+    double worst = 0;
+    for (const auto &calibration : calibrations)
+    {
+        PhKernel kernel;
+        TEST_ASSERT_TRUE(kernel.configure(calibration[0], calibration[1], 50));
+        TEST_ASSERT_TRUE(kernel.isFixedPoint());
+        for (float temperature = 0; temperature <= 50; temperature += 0.5f)
+        {
+            for (long rawSum = 0; rawSum <= 1023L * 50; rawSum++)
+            {
+                double error = fabs(kernel.convert(rawSum) - referencePh(calibration[0], calibration[1], temperature, 50, rawSum));
+                worst = error > worst ? error : worst;
+            }
+        }
+    }
+    TEST_ASSERT_TRUE(worst < 0.002);
+}
+
+void test_ph_matches_legacy_float_formula()
+{
+    PhKernel kernel;
+    kernel.configure(1950, 1615, 50);
+    for (float temperature = 0; temperature <= 50; temperature += 5)
+    {
+        for (long rawSum = 0; rawSum <= 1023L * 50; rawSum += 7)
+        {
+            TEST_ASSERT_FLOAT_WITHIN(0.002, legacyPh(1950, 1615, temperature, rawSum), kernel.convert(rawSum));
+        }
+    }
+}
+
+void test_ph_weak_electrode_falls_back_to_float()
+{
+    PhKernel kernel;
+    TEST_ASSERT_TRUE(kernel.configure(1520, 1500, 50));
+    TEST_ASSERT_FALSE(kernel.isFixedPoint());
+    TEST_ASSERT_FLOAT_WITHIN(0.0001, referencePh(1520, 1500, 25, 50, 25000), kernel.convert(25000));
+}
+
+void test_ph_degenerate_calibration_is_rejected()
+{
+    PhKernel kernel;
+    TEST_ASSERT_FALSE(kernel.configure(1600, 1600, 50));
+    TEST_ASSERT_TRUE(isnan(kernel.convert(100)));
+}
+
+void test_tds_fixed_point_error_bound()
+{
+    double worst = 0;
+    for (float temperature = 0; temperature <= 50; temperature += 0.25f)
+    {
+        TdsKernel kernel;
+        kernel.configure(temperature);
+        for (int adc = 0; adc <= 1023; adc++)
+        {
+            double error = fabs(kernel.convert(adc) - referenceTds(temperature, adc));
+            worst = error > worst ? error : worst;
+        }
+    }
+    TEST_ASSERT_TRUE(worst < 0.25);
+}
+
+void test_tds_temperature_is_clamped()
+{
+    TdsKernel cold, frozen;
+    cold.configure(-5);
+    frozen.configure(0);
+    TEST_ASSERT_EQUAL_INT32(frozen.convertQ4(1023), cold.convertQ4(1023));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_ph_fixed_point_error_bound);
+    RUN_TEST(test_ph_matches_legacy_float_formula);
+    RUN_TEST(test_ph_weak_electrode_falls_back_to_float);
+    RUN_TEST(test_ph_degenerate_calibration_is_rejected);
+    RUN_TEST(test_tds_fixed_point_error_bound);
+    RUN_TEST(test_tds_temperature_is_clamped);
+    return UNITY_END();
+}
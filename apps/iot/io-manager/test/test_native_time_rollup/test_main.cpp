@@ -0,0 +1,101 @@
+#include <unity.h>
+#include "utility/rollup.util.h"
+#include "utility/wallClock.util.h"
+
+void setUp() {}
+void tearDown() {}
+
+static std::map<std::string, double> frame(double ph, double tds)
+{
+    std::map<std::string, double> data;
+    data["ph"] = ph;
+    data["tds"] = tds;
+    return data;
+}
+
+void test_bucket_statistics()
+{
+    RollupBucket bucket;
+    TEST_ASSERT_TRUE(isnan(bucket.getMean()));
+    bucket.add(7.0f);
+    bucket.add(6.5f);
+    bucket.add(7.5f);
+    TEST_ASSERT_EQUAL_UINT16(3, bucket.count);
+    TEST_ASSERT_EQUAL_FLOAT(6.5f, bucket.min);
+    TEST_ASSERT_EQUAL_FLOAT(7.5f, bucket.max);
+    TEST_ASSERT_EQUAL_FLOAT(7.0f, bucket.getMean());
+}
+
+void test_period_hands_over_all_channels_once()
+{
+    TimeRollup rollup("1m", 60000UL);
+    rollup.add(frame(7.0, 400), 1000);
+    rollup.add(frame(7.2, 410), 31000);
+    TEST_ASSERT_FALSE(rollup.takePending());
+
+    // The first sample of the next period closes the previous one
+    rollup.add(frame(9.9, 999), 61000);
+    TEST_ASSERT_TRUE(rollup.isPending());
+    TEST_ASSERT_TRUE(rollup.isPending()); // Held until taken
+    TEST_ASSERT_TRUE(rollup.takePending());
+    TEST_ASSERT_FALSE(rollup.isPending());
+    TEST_ASSERT_FALSE(rollup.takePending());
+    TEST_ASSERT_EQUAL_UINT32(1, rollup.getSequence());
+    TEST_ASSERT_EQUAL_UINT32(1000, rollup.getCompletedStart());
+
+    const std::map<std::string, RollupBucket> &completed = rollup.getCompleted();
+    TEST_ASSERT_EQUAL_INT(2, (int)completed.size());
+    TEST_ASSERT_EQUAL_UINT16(2, completed.at("ph").count);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 7.1f, completed.at("ph").getMean());
+    TEST_ASSERT_EQUAL_FLOAT(410, completed.at("tds").max);
+}
+
+void test_idle_periods_keep_the_grid()
+{
+    TimeRollup rollup("1m", 60000UL);
+    rollup.add(frame(7, 400), 5000);
+    rollup.add(frame(7, 400), 70000); // Closes [5000, 65000)
+    TEST_ASSERT_TRUE(rollup.takePending());
+    // Nothing for two periods, the next bucket still starts on the grid
+    rollup.add(frame(7, 400), 250000);
+    TEST_ASSERT_TRUE(rollup.takePending());
+    TEST_ASSERT_EQUAL_UINT32(65000, rollup.getCompletedStart());
+    rollup.add(frame(7, 400), 310000);
+    TEST_ASSERT_TRUE(rollup.takePending());
+    TEST_ASSERT_EQUAL_UINT32(245000, rollup.getCompletedStart());
+    TEST_ASSERT_EQUAL_UINT32(3, rollup.getSequence());
+}
+
+void test_epoch_from_civil()
+{
+    TEST_ASSERT_EQUAL_UINT32(0, epochFromCivil(1970, 1, 1, 0));
+    TEST_ASSERT_EQUAL_UINT32(951782400UL, epochFromCivil(2000, 2, 29, 0));
+    TEST_ASSERT_EQUAL_UINT32(1760970645UL, epochFromCivil(2025, 10, 20, 14 * 3600UL + 30 * 60 + 45));
+    TEST_ASSERT_EQUAL_UINT32(4102444800UL, epochFromCivil(2100, 1, 1, 0));
+}
+
+void test_wall_clock_maps_both_sides_of_the_sync()
+{
+    WallClock clock;
+    TEST_ASSERT_FALSE(clock.isSynced());
+    clock.sync(1760970645UL, 500000UL);
+    TEST_ASSERT_TRUE(clock.isSynced());
+    TEST_ASSERT_EQUAL_UINT32(1760970645UL, clock.at(500000UL));
+    TEST_ASSERT_EQUAL_UINT32(1760970705UL, clock.at(560999UL));
+    TEST_ASSERT_EQUAL_UINT32(1760970584UL, clock.at(439500UL));
+
+    // Across the millis() wrap
+    clock.sync(1000000UL, 0xFFFFF000UL);
+    TEST_ASSERT_EQUAL_UINT32(1000010UL, clock.at((0xFFFFF000UL + 10000UL) & 0xFFFFFFFFUL));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_bucket_statistics);
+    RUN_TEST(test_period_hands_over_all_channels_once);
+    RUN_TEST(test_idle_periods_keep_the_grid);
+    RUN_TEST(test_epoch_from_civil);
+    RUN_TEST(test_wall_clock_maps_both_sides_of_the_sync);
+    return UNITY_END();
+}